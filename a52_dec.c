@@ -32,31 +32,52 @@
 #include <math.h>
 #include <inttypes.h>
 #include <dlfcn.h>
+#include <pthread.h>
 
 
 #include "a52dec.h"
 
 
+// liba52 function defs for using dlsym
+static a52_state_t * (*a52_init) (uint32_t);
+static sample_t * (*a52_samples) (a52_state_t *);
+static int (*a52_syncinfo) (uint8_t * , int * , int * , int * );
+static int (*a52_frame) (a52_state_t * , uint8_t * , int * , level_t * , sample_t );
+static int (*a52_block) (a52_state_t * );
+static void (*a52_free) (a52_state_t * );
+
+// the library is shared by all players, it is unloaded when the last one is done
+static void *a52_handle;
+static int a52_users;
+static pthread_mutex_t a52_lock = PTHREAD_MUTEX_INITIALIZER;
+
 // try to dynamically load and wrap liba52.so.0
 
 int ddvd_load_liba52()
 {
-	a52_handle = dlopen("liba52.so.0",RTLD_LAZY);
+	pthread_mutex_lock(&a52_lock);
+	if (a52_users == 0)
+		a52_handle = dlopen("liba52.so.0",RTLD_LAZY);
 	
 	if (a52_handle)
 	{
-		a52_init = (a52_state_t* (*)(uint32_t)) dlsym(a52_handle, "a52_init");
-		a52_samples = (sample_t* (*)(a52_state_t*)) dlsym(a52_handle, "a52_samples");
-		a52_syncinfo = (int (*)(uint8_t*, int*, int*, int*)) dlsym(a52_handle, "a52_syncinfo");
-		a52_frame = (int (*)(a52_state_t* ,uint8_t* ,int* ,level_t* ,sample_t)) dlsym(a52_handle, "a52_frame");
-		a52_block = (int (*)(a52_state_t*)) dlsym(a52_handle, "a52_block");
-		a52_free = (void (*)(a52_state_t*)) dlsym(a52_handle, "a52_free");
-
-		printf("libdreamdvd: soft ac3 decoding is available, liba52.so.0 loaded !\n");
+		if (a52_users++ == 0)
+		{
+			a52_init = (a52_state_t* (*)(uint32_t)) dlsym(a52_handle, "a52_init");
+			a52_samples = (sample_t* (*)(a52_state_t*)) dlsym(a52_handle, "a52_samples");
+			a52_syncinfo = (int (*)(uint8_t*, int*, int*, int*)) dlsym(a52_handle, "a52_syncinfo");
+			a52_frame = (int (*)(a52_state_t* ,uint8_t* ,int* ,level_t* ,sample_t)) dlsym(a52_handle, "a52_frame");
+			a52_block = (int (*)(a52_state_t*)) dlsym(a52_handle, "a52_block");
+			a52_free = (void (*)(a52_state_t*)) dlsym(a52_handle, "a52_free");
+
+			printf("libdreamdvd: soft ac3 decoding is available, liba52.so.0 loaded !\n");
+		}
+		pthread_mutex_unlock(&a52_lock);
 		return 1;
 	}
 	else
 	{
+		pthread_mutex_unlock(&a52_lock);
 		printf("libdreamdvd: soft ac3 decoding is not available, liba52.so.0 not found !\n");
 		return 0;
 	}
@@ -66,7 +87,31 @@ int ddvd_load_liba52()
 
 void ddvd_close_liba52()
 {
-	dlclose(a52_handle);
+	pthread_mutex_lock(&a52_lock);
+	if (a52_users > 0 && --a52_users == 0)
+	{
+		dlclose(a52_handle);
+		a52_handle = NULL;
+	}
+	pthread_mutex_unlock(&a52_lock);
+}
+
+// set up a decoder (needs a loaded liba52)
+
+int ddvd_a52_init(struct ddvd_a52 *a52)
+{
+	memset(a52, 0, sizeof(struct ddvd_a52));
+	a52->bufptr = a52->buf;
+	a52->bufpos = a52->buf + 7;
+	a52->state = a52_init(0);
+	return a52->state != NULL;
+}
+
+void ddvd_a52_free(struct ddvd_a52 *a52)
+{
+	if (a52->state)
+		a52_free(a52->state);
+	a52->state = NULL;
 }
 
 // convert 32bit samples to 16bit
@@ -93,18 +138,16 @@ static void a52_convert2s16_2 (sample_t * _f, int16_t * s16)
 
 // a52 decode function (needs liba52)
 
-int ddvd_ac3_decode(const uint8_t *input, unsigned int len, int16_t *output)
+int ddvd_ac3_decode(struct ddvd_a52 *a52, const uint8_t *input, unsigned int len, int16_t *output)
 {
-	static int sample_rate;
-    static int flags;
+    uint8_t *buf = a52->buf;
     int bit_rate;
 	int out_len=0;
 	const uint8_t *end; 
 	end=input+len;
 	
-    static uint8_t buf[3840];
-    static uint8_t * bufptr = buf;
-    static uint8_t * bufpos = buf + 7;
+    uint8_t * bufptr = a52->bufptr;
+    uint8_t * bufpos = a52->bufpos;
 
     while (1) {
 	len = end - input;
@@ -121,7 +164,7 @@ int ddvd_ac3_decode(const uint8_t *input, unsigned int len, int16_t *output)
 	    if (bufpos == buf + 7) {
 		int length;
 
-		length = a52_syncinfo (buf, &flags, &sample_rate, &bit_rate);
+		length = a52_syncinfo (buf, &a52->flags, &a52->sample_rate, &bit_rate);
 		if (!length) {
 		    for (bufptr = buf; bufptr < buf + 6; bufptr++)
 			bufptr[0] = bufptr[1];
@@ -133,18 +176,18 @@ int ddvd_ac3_decode(const uint8_t *input, unsigned int len, int16_t *output)
 		sample_t bias;
 		int i;
 
-		flags=A52_DOLBY|A52_ADJUST_LEVEL;
+		a52->flags=A52_DOLBY|A52_ADJUST_LEVEL;
 			
 		bias=0;
 		level=(1 << 26);
 
-		if (a52_frame (state, buf, &flags, &level, bias))
+		if (a52_frame (a52->state, buf, &a52->flags, &level, bias))
 		    goto error;
 
 		for (i = 0; i < 6; i++) {
-		    if (a52_block (state))
+		    if (a52_block (a52->state))
 			goto error;
-			a52_convert2s16_2(a52_samples(state),output);
+			a52_convert2s16_2(a52_samples(a52->state),output);
 			output+=512;
 			out_len+=1024;
 		}
@@ -157,5 +200,7 @@ int ddvd_ac3_decode(const uint8_t *input, unsigned int len, int16_t *output)
 	    }
 	}
     }
+    a52->bufptr = bufptr;
+    a52->bufpos = bufpos;
 	return out_len;
 }
@@ -49,20 +49,20 @@ typedef struct a52_state_s a52_state_t;
 #define A52_LFE 16
 #define A52_ADJUST_LEVEL 32
 
-// liba52 function defs for using dlsym
-a52_state_t * (*a52_init) (uint32_t);
-sample_t * (*a52_samples) (a52_state_t *);
-int (*a52_syncinfo) (uint8_t * , int * , int * , int * );
-int (*a52_frame) (a52_state_t * , uint8_t * , int * , level_t * , sample_t );
-int (*a52_block) (a52_state_t * );
-void (*a52_free) (a52_state_t * );
+// decoder state, one per player
+struct ddvd_a52 {
+	a52_state_t *state;
+	int sample_rate;
+	int flags;
+	uint8_t buf[3840];
+	uint8_t *bufptr;
+	uint8_t *bufpos;
+};
 
-void *a52_handle;
-
-a52_state_t * state;
-
-int ddvd_ac3_decode(const uint8_t *input, unsigned int len, int16_t *output);
 int ddvd_load_liba52();
 void ddvd_close_liba52();
+int ddvd_a52_init(struct ddvd_a52 *a52);
+void ddvd_a52_free(struct ddvd_a52 *a52);
+int ddvd_ac3_decode(struct ddvd_a52 *a52, const uint8_t *input, unsigned int len, int16_t *output);
 
 #endif
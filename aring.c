@@ -0,0 +1,116 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "aring.h"
+#include "debug.h"
+
+void ddvd_aring_clear(struct ddvd_arings *r)
+{
+	int i;
+
+	for (i = 0; i < DDVD_ARING_STREAMS; i++)
+		r->ring[i].head = 0;
+	r->replay_next = r->replay_count = 0;
+}
+
+void ddvd_aring_free(struct ddvd_arings *r)
+{
+	int i;
+
+	for (i = 0; i < DDVD_ARING_STREAMS; i++) {
+		free(r->ring[i].pack);
+		r->ring[i].pack = NULL;
+	}
+	free(r->replay);
+	r->replay = NULL;
+	ddvd_aring_clear(r);
+}
+
+void ddvd_aring_put(struct ddvd_arings *r, int stream, const uint8_t *block, int len, int has_time, int64_t time)
+{
+	struct ddvd_aring *ring;
+	struct ddvd_aring_pack *pack;
+
+	if (stream < 0 || stream >= DDVD_ARING_STREAMS || len > 2048)
+		return;
+	ring = &r->ring[stream];
+	if (ring->pack == NULL) {
+		ring->pack = malloc(DDVD_ARING_PACKS * sizeof(struct ddvd_aring_pack));
+		if (ring->pack == NULL) {
+			Perror("malloc audio ring");
+			return;
+		}
+		ring->head = 0;
+	}
+	if (has_time)
+		ring->time = time;
+	else if (ring->head == 0)	// no time to start with
+		return;
+
+	pack = &ring->pack[ring->head % DDVD_ARING_PACKS];
+	pack->time = ring->time;
+	pack->len = len;
+	memcpy(pack->data, block, len);
+	ring->head++;
+}
+
+int ddvd_aring_replay(struct ddvd_arings *r, int stream, int64_t time)
+{
+	struct ddvd_aring *ring;
+	unsigned int first, i;
+
+	r->replay_next = r->replay_count = 0;
+	if (stream < 0 || stream >= DDVD_ARING_STREAMS || r->ring[stream].pack == NULL)
+		return 0;
+	ring = &r->ring[stream];
+	if (r->replay == NULL) {
+		r->replay = malloc(DDVD_ARING_PACKS * 2048);
+		if (r->replay == NULL) {
+			Perror("malloc audio replay");
+			return 0;
+		}
+	}
+
+	// the oldest pack the decoder has not played yet
+	first = ring->head > DDVD_ARING_PACKS ? ring->head - DDVD_ARING_PACKS : 0;
+	while (first < ring->head && ring->pack[first % DDVD_ARING_PACKS].time < time)
+		first++;
+	for (i = first; i < ring->head; i++) {
+		struct ddvd_aring_pack *pack = &ring->pack[i % DDVD_ARING_PACKS];
+		memcpy(r->replay + r->replay_count * 2048, pack->data, pack->len);
+		r->replay_len[r->replay_count++] = pack->len;
+	}
+	Debug(3, "audio ring: replay %d packs of stream %d from %lld\n", r->replay_count, stream, (long long)time);
+	return r->replay_count;
+}
+
+uint8_t *ddvd_aring_next(struct ddvd_arings *r, int *len)
+{
+	if (r->replay_next >= r->replay_count)
+		return NULL;
+	*len = r->replay_len[r->replay_next];
+	return r->replay + r->replay_next++ * 2048;
+}
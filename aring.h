@@ -0,0 +1,73 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __ARING_H__
+#define __ARING_H__
+
+#include <stdint.h>
+
+/*
+ * the last packs of every audio stream, for switching the audio track without a jump
+ *
+ * All audio streams are demuxed, the packs of each are kept in a small ring with their time
+ * on the timeline. On a switch only the audio decoder is cleared and the packs of the new
+ * stream from the current decoder time on are played again, the video goes on undisturbed.
+ * A ring is allocated with the first pack of its stream.
+ */
+
+#define DDVD_ARING_STREAMS	8
+#define DDVD_ARING_PACKS	64		// about 2s of AC3 at 448kbit/s, less with LPCM
+
+struct ddvd_aring_pack {
+	int64_t time;				// timeline time of the last pts of the stream up to this pack
+	int len;
+	uint8_t data[2048];			// the pack as read
+};
+
+struct ddvd_aring {
+	struct ddvd_aring_pack *pack;	// DDVD_ARING_PACKS
+	unsigned int head;			// packs stored, counts up
+	int64_t time;
+};
+
+struct ddvd_arings {
+	struct ddvd_aring ring[DDVD_ARING_STREAMS];
+	uint8_t *replay;			// copy of the packs being replayed, they may be patched while played
+	int replay_len[DDVD_ARING_PACKS];
+	int replay_next, replay_count;
+};
+
+// forget all packs, the decoder was cleared
+void	ddvd_aring_clear(struct ddvd_arings *r);
+void	ddvd_aring_free(struct ddvd_arings *r);
+
+// keep a pack of stream, with a pts its time is given (has_time), else it takes the last one
+void	ddvd_aring_put(struct ddvd_arings *r, int stream, const uint8_t *block, int len, int has_time, int64_t time);
+
+// replay the packs of stream from time on, returns their number
+int		ddvd_aring_replay(struct ddvd_arings *r, int stream, int64_t time);
+
+// next pack to replay, NULL when done, it stays valid until the next ddvd_aring_replay
+uint8_t	*ddvd_aring_next(struct ddvd_arings *r, int *len);
+
+#endif
@@ -0,0 +1,943 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+/*
+ * ddvd_mkfixture, writes a small synthetic DVD-Video structure for benchmarking
+ *
+ * The result is a VIDEO_TS directory with a first play PGC jumping to the only title,
+ * one title set and one cell per chapter. Every VOBU starts with a NAV pack and carries
+ * MPEG-2 video, optionally one audio stream (AC3, LPCM or MPEG) and one subtitle stream.
+ * All headers, timestamps and navigation data are valid, the video and compressed
+ * audio payload is noise. LPCM samples and subpictures are real content so the
+ * transcoder and the SPU decoder get realistic input.
+ */
+
+#include "libdreamdvd_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define SECTOR				2048
+#define VOB_MAX_SECTORS		(512 * 1024)	// split title VOBs at 1GB like a real disc
+#define PTS_START			45000			// first video pts, leaves room for the scr
+#define SPU_EVERY			4				// a subtitle every n VOBUs
+#define SPU_WIDTH			360
+#define SPU_HEIGHT			32
+#define SRI_END_OF_CELL		0x3fffffff
+
+enum { // audio types
+	AUDIO_NONE,
+	AUDIO_AC3,
+	AUDIO_LPCM,
+	AUDIO_MPA,
+};
+
+struct fixture {
+	const char *dir;
+	int audio;
+	int spu;
+	int ntsc;
+	int wide;
+	int chapters;
+	int vobus;				// VOBUs per chapter
+	int video_kbps;
+
+	int frames;				// pictures per VOBU
+	int frame_ticks;
+	int vobu_ticks;
+	int video_sectors;		// video packs per VOBU
+	int audio_frame;		// bytes per audio frame
+	int audio_ticks;		// duration of an audio frame
+	int audio_payload;		// audio bytes per pack
+
+	uint32_t *vobu_start;	// first sector of every VOBU
+	uint32_t *cell_first;
+	uint32_t *cell_last;
+	uint32_t sectors;		// title VOBS size
+
+	int fd;
+	int vob_nr;
+	uint32_t file_sectors;
+	uint32_t rng;
+	int lpcm_sample;
+};
+
+/*
+ * helpers
+ */
+
+static void put16(uint8_t *p, uint16_t v)
+{
+	p[0] = v >> 8;
+	p[1] = v;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+// payload noise, never contains a zero byte so it can not emulate a start code
+static void noise(struct fixture *f, uint8_t *p, int len)
+{
+	while (len-- > 0) {
+		f->rng = f->rng * 1103515245 + 12345;
+		*p = f->rng >> 16;
+		if (*p == 0)
+			*p = 0x55;
+		p++;
+	}
+}
+
+static uint8_t bcd(int v)
+{
+	return ((v / 10) << 4) | (v % 10);
+}
+
+// dvd_time_t of a duration in 90kHz ticks
+static void put_time(struct fixture *f, uint8_t *p, uint64_t ticks)
+{
+	uint64_t s = ticks / 90000;
+	p[0] = bcd(s / 3600);
+	p[1] = bcd((s / 60) % 60);
+	p[2] = bcd(s % 60);
+	p[3] = (f->ntsc ? 0xC0 : 0x40) | bcd((ticks % 90000) / f->frame_ticks);
+}
+
+static void put_pts(uint8_t *p, int marker, uint64_t pts)
+{
+	p[0] = (marker << 4) | (((pts >> 30) & 7) << 1) | 1;
+	p[1] = pts >> 22;
+	p[2] = (((pts >> 15) & 0x7F) << 1) | 1;
+	p[3] = pts >> 7;
+	p[4] = ((pts & 0x7F) << 1) | 1;
+}
+
+static void put_pack_header(uint8_t *p, uint64_t scr)
+{
+	p[0] = 0x00;
+	p[1] = 0x00;
+	p[2] = 0x01;
+	p[3] = 0xBA;
+	p[4] = 0x44 | (((scr >> 30) & 7) << 3) | ((scr >> 28) & 3);
+	p[5] = scr >> 20;
+	p[6] = (((scr >> 15) & 0x1F) << 3) | 0x04 | ((scr >> 13) & 3);
+	p[7] = scr >> 5;
+	p[8] = ((scr & 0x1F) << 3) | 0x04;
+	p[9] = 0x01;
+	p[10] = 0x89;	// mux rate 10.08 Mbit/s
+	p[11] = 0xC3;
+	p[12] = 0xF8;	// no pack stuffing, the player expects the PES at offset 14
+}
+
+/*
+ * one PES packet filling the rest of the pack, data shorter than the room is completed
+ * with header stuffing or a padding packet. sub is the private stream header (substream
+ * id and friends) put in front of the data
+ */
+static void put_pes(uint8_t *p, int room, int id, const uint64_t *pts, const uint64_t *dts,
+					const uint8_t *sub, int sublen, const uint8_t *data, int len)
+{
+	int hdr = (pts ? 5 : 0) + (dts ? 5 : 0);
+	int left = room - (9 + hdr + sublen + len);
+	int stuffing = left <= 8 ? left : 0;
+	int pes_len = 3 + hdr + stuffing + sublen + len;
+
+	p[0] = 0x00;
+	p[1] = 0x00;
+	p[2] = 0x01;
+	p[3] = id;
+	put16(p + 4, pes_len);
+	p[6] = 0x81;
+	p[7] = (pts ? 0x80 : 0) | (dts ? 0x40 : 0);
+	p[8] = hdr + stuffing;
+	p += 9;
+	if (pts) {
+		put_pts(p, dts ? 3 : 2, *pts);
+		p += 5;
+	}
+	if (dts) {
+		put_pts(p, 1, *dts);
+		p += 5;
+	}
+	memset(p, 0xFF, stuffing);
+	p += stuffing;
+	memcpy(p, sub, sublen);
+	p += sublen;
+	memcpy(p, data, len);
+	p += len;
+
+	left -= stuffing;
+	if (left > 0) {	// padding stream
+		p[0] = 0x00;
+		p[1] = 0x00;
+		p[2] = 0x01;
+		p[3] = 0xBE;
+		put16(p + 4, left - 6);
+		memset(p + 6, 0xFF, left - 6);
+	}
+}
+
+/*
+ * title VOBS output, split into VTS_01_n.VOB files
+ */
+
+static int write_sector(struct fixture *f, const uint8_t *sector)
+{
+	if (f->fd < 0 || f->file_sectors == VOB_MAX_SECTORS) {
+		char name[1024];
+		if (f->fd >= 0)
+			close(f->fd);
+		if (++f->vob_nr > 9) {
+			fprintf(stderr, "title too large\n");
+			return -1;
+		}
+		snprintf(name, sizeof(name), "%s/VIDEO_TS/VTS_01_%d.VOB", f->dir, f->vob_nr);
+		f->fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (f->fd < 0) {
+			perror(name);
+			return -1;
+		}
+		f->file_sectors = 0;
+	}
+	if (write(f->fd, sector, SECTOR) != SECTOR) {
+		perror("write");
+		return -1;
+	}
+	f->file_sectors++;
+	return 0;
+}
+
+static int write_file(const char *dir, const char *name, const uint8_t *data, size_t len)
+{
+	char path[1024];
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/VIDEO_TS/%s", dir, name);
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+	if (write(fd, data, len) != (ssize_t)len) {
+		perror(path);
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	return 0;
+}
+
+/*
+ * stream layout
+ */
+
+// first audio frame of VOBU g
+static int audio_frame_nr(struct fixture *f, int g)
+{
+	return (int)((int64_t)g * f->vobu_ticks / f->audio_ticks);
+}
+
+static int audio_sectors(struct fixture *f, int g)
+{
+	int bytes;
+
+	if (f->audio == AUDIO_NONE)
+		return 0;
+	bytes = (audio_frame_nr(f, g + 1) - audio_frame_nr(f, g)) * f->audio_frame;
+	return (bytes + f->audio_payload - 1) / f->audio_payload;
+}
+
+static int has_spu(struct fixture *f, int g)
+{
+	return f->spu && (g % f->vobus) % SPU_EVERY == 0;
+}
+
+static int vobu_sectors(struct fixture *f, int g)
+{
+	return 1 + has_spu(f, g) + f->video_sectors + audio_sectors(f, g);
+}
+
+static void layout(struct fixture *f)
+{
+	int total = f->chapters * f->vobus;
+	uint32_t s = 0;
+	int g;
+
+	for (g = 0; g < total; g++) {
+		if (g % f->vobus == 0)
+			f->cell_first[g / f->vobus] = s;
+		f->vobu_start[g] = s;
+		s += vobu_sectors(f, g);
+		if (g % f->vobus == f->vobus - 1)
+			f->cell_last[g / f->vobus] = s - 1;
+	}
+	f->vobu_start[total] = s;
+	f->sectors = s;
+}
+
+/*
+ * packs
+ */
+
+static void put_nav(struct fixture *f, uint8_t *buf, int g, uint64_t scr)
+{
+	int cell = g / f->vobus;
+	int k = g % f->vobus;
+	uint32_t lbn = f->vobu_start[g];
+	uint32_t ea = f->vobu_start[g + 1] - lbn - 1;
+	uint64_t s_ptm = PTS_START + (uint64_t)g * f->vobu_ticks;
+	uint64_t c_eltm = (uint64_t)k * f->vobu_ticks;
+	uint8_t *p, *pci, *dsi;
+
+	memset(buf, 0, SECTOR);
+	put_pack_header(buf, scr);
+
+	// system header
+	p = buf + 14;
+	p[0] = 0x00; p[1] = 0x00; p[2] = 0x01; p[3] = 0xBB;
+	put16(p + 4, 18);
+	memcpy(p + 6, "\x80\xC4\xE1\x04\xE1\x7F\xB9\xE0\xE8\xB8\xC0\x20\xBD\xE0\x3A\xBF\xE0\x02", 18);
+
+	// PCI
+	p = buf + 38;
+	p[0] = 0x00; p[1] = 0x00; p[2] = 0x01; p[3] = 0xBF;
+	put16(p + 4, 980);
+	p[6] = 0x00;
+	pci = p + 7;
+	put32(pci + 0, lbn);
+	put32(pci + 12, s_ptm);
+	put32(pci + 16, s_ptm + f->vobu_ticks);
+	put_time(f, pci + 24, c_eltm);
+
+	// DSI
+	p = buf + 1024;
+	p[0] = 0x00; p[1] = 0x00; p[2] = 0x01; p[3] = 0xBF;
+	put16(p + 4, 1018);
+	p[6] = 0x01;
+	dsi = p + 7;
+	put32(dsi + 0, scr);
+	put32(dsi + 4, lbn);
+	put32(dsi + 8, ea);
+	put32(dsi + 12, ea < 3 ? ea : 3);	// end of the first reference picture
+	put16(dsi + 24, 1);
+	dsi[27] = cell + 1;
+	put_time(f, dsi + 28, c_eltm);
+	put32(dsi + 44, PTS_START);
+	put32(dsi + 48, PTS_START + (uint64_t)f->chapters * f->vobus * f->vobu_ticks);
+	put32(dsi + 234, k == f->vobus - 1 ? SRI_END_OF_CELL : 0x80000000 | (f->vobu_start[g + 1] - lbn));	// next video
+	put32(dsi + 314, k == f->vobus - 1 ? SRI_END_OF_CELL : 0x80000000 | (f->vobu_start[g + 1] - lbn));	// next vobu
+	put32(dsi + 318, k == 0 ? SRI_END_OF_CELL : 0x80000000 | (lbn - f->vobu_start[g - 1]));			// prev vobu
+	put32(dsi + 398, k == 0 ? SRI_END_OF_CELL : 0x80000000 | (lbn - f->vobu_start[g - 1]));			// prev video
+}
+
+// one GOP, closed, IBBPBBP... in coded order
+static int build_video_es(struct fixture *f, uint8_t *es, int size)
+{
+	int rows = f->ntsc ? 30 : 36;
+	int per_picture = size / f->frames;
+	int pos = 0;
+	int j, row;
+
+	for (j = 0; j < f->frames; j++) {
+		int end = j == f->frames - 1 ? size : pos + per_picture;
+		int type, tr;
+
+		if (j == 0) {
+			uint8_t seq[] = {
+				0x00, 0x00, 0x01, 0xB3, 0x2D, 0x02, 0x40, 0x23, 0x5F, 0xB4, 0x3B, 0x80,		// sequence header
+				0x00, 0x00, 0x01, 0xB5, 0x14, 0x8A, 0x00, 0x01, 0x00, 0x00,					// sequence extension
+				0x00, 0x00, 0x01, 0xB8, 0x00, 0x08, 0x00, 0x40,								// gop, closed
+			};
+			int lines = f->ntsc ? 480 : 576;
+			seq[5] = lines >> 8;
+			seq[6] = lines & 0xFF;
+			seq[7] = (f->wide ? 0x30 : 0x20) | (f->ntsc ? 4 : 3);
+			memcpy(es + pos, seq, sizeof(seq));
+			pos += sizeof(seq);
+			type = 1;
+			tr = 2;
+		}
+		else if (j < 3) {
+			type = 3;
+			tr = j - 1;
+		}
+		else {
+			int m = (j - 3) / 3;
+			type = (j - 3) % 3 == 0 ? 2 : 3;
+			tr = 3 * m + ((j - 3) % 3 == 0 ? 5 : (j - 3) % 3 + 2);
+		}
+
+		// picture header and picture coding extension
+		es[pos++] = 0x00; es[pos++] = 0x00; es[pos++] = 0x01; es[pos++] = 0x00;
+		es[pos++] = tr >> 2;
+		es[pos++] = ((tr & 3) << 6) | (type << 3) | 0x07;
+		es[pos++] = 0xFF;
+		es[pos++] = 0xF8;
+		memcpy(es + pos, "\x00\x00\x01\xB5\x8F\xFF\xF3\x41\x80", 9);
+		pos += 9;
+
+		// slices with noise
+		int per_slice = (end - pos) / rows;
+		for (row = 1; row <= rows; row++) {
+			int slice_end = row == rows ? end : pos + per_slice;
+			es[pos++] = 0x00; es[pos++] = 0x00; es[pos++] = 0x01; es[pos++] = row;
+			noise(f, es + pos, slice_end - pos);
+			pos = slice_end;
+		}
+	}
+	return pos;
+}
+
+static void build_audio_es(struct fixture *f, uint8_t *es, int count)
+{
+	int i, j;
+
+	for (i = 0; i < count; i++) {
+		uint8_t *p = es + i * f->audio_frame;
+		switch (f->audio) {
+			case AUDIO_AC3:	// 448 kbit/s stereo
+				noise(f, p, f->audio_frame);
+				memcpy(p, "\x0B\x77", 2);
+				p[4] = 0x1C;
+				p[5] = 0x40;
+				p[6] = 0x40;
+				break;
+			case AUDIO_MPA:	// layer II 224 kbit/s stereo
+				noise(f, p, f->audio_frame);
+				memcpy(p, "\xFF\xFD\xB4\x04", 4);
+				break;
+			case AUDIO_LPCM:	// 16 bit big endian stereo, two sine waves
+				for (j = 0; j < f->audio_frame / 4; j++, f->lpcm_sample++) {
+					int16_t l = 8000 * sin(2 * M_PI * 1000 * f->lpcm_sample / 48000);
+					int16_t r = 8000 * sin(2 * M_PI * 1500 * f->lpcm_sample / 48000);
+					put16(p + 4 * j, l);
+					put16(p + 4 * j + 2, r);
+				}
+				break;
+		}
+	}
+}
+
+// one subtitle, striped boxes in a 360x32 area, shown for two seconds
+static int build_spu(struct fixture *f, uint8_t *spu)
+{
+	int x1 = 180, y1 = f->ntsc ? 400 : 480;
+	int x2 = x1 + SPU_WIDTH - 1, y2 = y1 + SPU_HEIGHT - 1;
+	int field_offset[2];
+	int pos = 4, nibble = 0;
+	int field, y, x;
+
+#define PUT_NIBBLE(v) do { \
+		if (nibble) { spu[pos++] |= (v); nibble = 0; } \
+		else { spu[pos] = (v) << 4; nibble = 1; } \
+	} while (0)
+
+	for (field = 0; field < 2; field++) {
+		field_offset[field] = pos;
+		for (y = field; y < SPU_HEIGHT; y += 2) {
+			x = 0;
+			while (x < SPU_WIDTH) {
+				int color = y % 10 < 7 ? (x / 9) % 4 : 0;
+				int run = 1;
+				while (x + run < SPU_WIDTH && run < 255 && (y % 10 < 7 ? ((x + run) / 9) % 4 : 0) == color)
+					run++;
+				int code = (run << 2) | color;
+				if (run >= 64) {
+					PUT_NIBBLE(0); PUT_NIBBLE(code >> 8); PUT_NIBBLE((code >> 4) & 0xF); PUT_NIBBLE(code & 0xF);
+				}
+				else if (run >= 16) {
+					PUT_NIBBLE(0); PUT_NIBBLE(code >> 4); PUT_NIBBLE(code & 0xF);
+				}
+				else if (run >= 4) {
+					PUT_NIBBLE(code >> 4); PUT_NIBBLE(code & 0xF);
+				}
+				else
+					PUT_NIBBLE(code);
+				x += run;
+			}
+			if (nibble)	// lines are byte aligned
+				PUT_NIBBLE(0);
+		}
+	}
+#undef PUT_NIBBLE
+
+	// display control sequences, show now and hide after two seconds
+	int dcsq1 = pos, dcsq2 = pos + 26;
+	put16(spu + 2, dcsq1);
+	put16(spu + pos, 0);
+	put16(spu + pos + 2, dcsq2);
+	pos += 4;
+	spu[pos++] = 0x03;	// colors
+	spu[pos++] = 0x32;
+	spu[pos++] = 0x10;
+	spu[pos++] = 0x04;	// contrast
+	spu[pos++] = 0xFF;
+	spu[pos++] = 0xF0;
+	spu[pos++] = 0x05;	// area
+	spu[pos++] = x1 >> 4;
+	spu[pos++] = ((x1 & 0xF) << 4) | (x2 >> 8);
+	spu[pos++] = x2;
+	spu[pos++] = y1 >> 4;
+	spu[pos++] = ((y1 & 0xF) << 4) | (y2 >> 8);
+	spu[pos++] = y2;
+	spu[pos++] = 0x06;	// field offsets
+	put16(spu + pos, field_offset[0]);
+	put16(spu + pos + 2, field_offset[1]);
+	pos += 4;
+	spu[pos++] = 0x01;	// show
+	spu[pos++] = 0xFF;
+	put16(spu + pos, 2 * 90000 / 1024);
+	put16(spu + pos + 2, dcsq2);
+	pos += 4;
+	spu[pos++] = 0x02;	// hide
+	spu[pos++] = 0xFF;
+	put16(spu, pos);
+	return pos;
+}
+
+static int write_vobu(struct fixture *f, int g, uint8_t *video_es, uint8_t *audio_es)
+{
+	uint8_t buf[SECTOR];
+	int n = vobu_sectors(f, g);
+	uint64_t base = PTS_START + (uint64_t)g * f->vobu_ticks;
+	uint64_t scr = base - PTS_START / 2;
+	int V = f->video_sectors;
+	int A = audio_sectors(f, g);
+	int first_frame = A ? audio_frame_nr(f, g) : 0;
+	int frames = A ? audio_frame_nr(f, g + 1) - first_frame : 0;
+	int audio_len = frames * f->audio_frame;
+	int v = 0, a = 0, vpos = 0, apos = 0;
+	int i;
+
+	put_nav(f, buf, g, scr);
+	if (write_sector(f, buf) < 0)
+		return -1;
+
+	if (has_spu(f, g)) {
+		uint8_t unit[2019] = { 0 };
+		uint8_t sub = 0x20;
+		build_spu(f, unit);
+		put_pack_header(buf, scr + 1 * f->vobu_ticks / n);
+		put_pes(buf + 14, SECTOR - 14, 0xBD, &base, NULL, &sub, 1, unit, sizeof(unit));
+		if (write_sector(f, buf) < 0)
+			return -1;
+	}
+
+	build_video_es(f, video_es, 2015 + (V - 1) * 2025);
+	if (A)
+		build_audio_es(f, audio_es, frames);
+
+	for (i = 1 + has_spu(f, g); i < n; i++) {
+		put_pack_header(buf, scr + (uint64_t)i * f->vobu_ticks / n);
+		if (a < A && (v == V || a * V < v * A)) {
+			int len = audio_len - apos < f->audio_payload ? audio_len - apos : f->audio_payload;
+			int next = (apos + f->audio_frame - 1) / f->audio_frame;	// first frame starting in this pack
+			int starts = 0;
+			uint64_t pts = base + (uint64_t)next * f->audio_ticks;
+			uint8_t sub[7];
+			int sublen = 0;
+
+			while ((next + starts) * f->audio_frame < apos + len)
+				starts++;
+			if (f->audio != AUDIO_MPA) {	// private stream 1 header
+				sub[0] = f->audio == AUDIO_AC3 ? 0x80 : 0xA0;
+				sub[1] = starts;
+				put16(sub + 2, starts ? next * f->audio_frame - apos + 1 : 0);
+				sublen = 4;
+			}
+			if (f->audio == AUDIO_LPCM) {
+				sub[4] = 0x00;
+				sub[5] = 0x01;	// 16 bit, 48kHz, stereo
+				sub[6] = 0x80;
+				sublen = 7;
+			}
+			put_pes(buf + 14, SECTOR - 14, f->audio == AUDIO_MPA ? 0xC0 : 0xBD, starts ? &pts : NULL, NULL,
+					sub, sublen, audio_es + apos, len);
+			apos += len;
+			a++;
+		}
+		else {
+			uint64_t dts = base - f->frame_ticks;
+			uint64_t pts = base + 2 * f->frame_ticks;
+			int len = v == 0 ? 2015 : 2025;
+			put_pes(buf + 14, SECTOR - 14, 0xE0, v == 0 ? &pts : NULL, v == 0 ? &dts : NULL,
+					NULL, 0, video_es + vpos, len);
+			vpos += len;
+			v++;
+		}
+		if (write_sector(f, buf) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+/*
+ * IFOs
+ */
+
+static void put_video_attr(struct fixture *f, uint8_t *p)
+{
+	p[0] = 0x40 | (f->ntsc ? 0x00 : 0x10) | (f->wide ? 0x0C : 0x03);
+	p[1] = 0x00;
+}
+
+static void put_audio_attr(struct fixture *f, uint8_t *p)
+{
+	static const uint8_t format[] = { 0, 0, 4, 2 };
+	p[0] = (format[f->audio] << 5) | 0x04;	// language present
+	p[1] = 0x01;	// 48kHz, 2 channels
+	p[2] = 'e';
+	p[3] = 'n';
+}
+
+static void put_subp_attr(uint8_t *p)
+{
+	p[0] = 0x01;	// language present
+	p[2] = 'e';
+	p[3] = 'n';
+}
+
+static int write_ifo(struct fixture *f, const char *name, const char *bup, const uint8_t *ifo, int sectors)
+{
+	if (write_file(f->dir, name, ifo, sectors * SECTOR) < 0 ||
+		write_file(f->dir, bup, ifo, sectors * SECTOR) < 0)
+		return -1;
+	return 0;
+}
+
+static int write_vmg(struct fixture *f)
+{
+	uint8_t ifo[3 * SECTOR];
+	uint8_t *p;
+
+	memset(ifo, 0, sizeof(ifo));
+
+	// VMGI_MAT
+	memcpy(ifo, "DVDVIDEO-VMG", 12);
+	put32(ifo + 0x0C, 2 * 3 - 1);		// vmg_last_sector, IFO and BUP
+	put32(ifo + 0x1C, 3 - 1);			// vmgi_last_sector
+	ifo[0x21] = 0x10;					// specification version 1.0
+	put16(ifo + 0x26, 1);				// volumes
+	put16(ifo + 0x28, 1);				// this volume
+	put16(ifo + 0x3E, 1);				// title sets
+	memcpy(ifo + 0x40, "libdreamdvd bench fixture", 25);
+	put32(ifo + 0x80, 0x400 + 236 + 16 - 1);	// vmgi_last_byte
+	put32(ifo + 0x84, 0x400);			// first play pgc
+	put32(ifo + 0xC4, 1);				// tt_srpt
+	put32(ifo + 0xD0, 2);				// vts_atrt
+	put_video_attr(f, ifo + 0x100);
+
+	// first play PGC, a single pre command "JumpTT 1"
+	p = ifo + 0x400;
+	put16(p + 0xE4, 236);
+	put16(p + 236, 1);
+	put16(p + 236 + 6, 16 - 1);
+	memcpy(p + 236 + 8, "\x30\x02\x00\x00\x00\x01\x00\x00", 8);
+
+	// TT_SRPT
+	p = ifo + SECTOR;
+	put16(p, 1);
+	put32(p + 4, 8 + 12 - 1);
+	p[8 + 1] = 1;						// angles
+	put16(p + 8 + 2, f->chapters);
+	p[8 + 6] = 1;						// title set
+	p[8 + 7] = 1;						// title in title set
+	put32(p + 8 + 8, 2 * 3);			// title set start sector
+
+	// VTS_ATRT
+	p = ifo + 2 * SECTOR;
+	put16(p, 1);
+	put32(p + 4, 12 + 542 - 1);
+	put32(p + 8, 12);
+	p += 12;
+	put32(p, 542 - 1);
+	put_video_attr(f, p + 8);
+	put_video_attr(f, p + 264);
+	if (f->audio != AUDIO_NONE) {
+		p[267] = 1;
+		put_audio_attr(f, p + 268);
+	}
+	if (f->spu) {
+		p[349] = 1;
+		put_subp_attr(p + 350);
+	}
+
+	return write_ifo(f, "VIDEO_TS.IFO", "VIDEO_TS.BUP", ifo, 3);
+}
+
+static int write_vts(struct fixture *f)
+{
+	int n = f->chapters;
+	int nr_vobus = n * f->vobus;
+	int pgc_size = 236 + ((n + 1) & ~1) + n * 24 + n * 4;
+	int pgcit_sectors = (16 + pgc_size + SECTOR - 1) / SECTOR;
+	int c_adt_sectors = (8 + 12 * n + SECTOR - 1) / SECTOR;
+	int admap_sectors = (4 + 4 * nr_vobus + SECTOR - 1) / SECTOR;
+	int pgcit = 2, c_adt = pgcit + pgcit_sectors, admap = c_adt + c_adt_sectors;
+	int sectors = admap + admap_sectors;
+	uint64_t title_ticks = (uint64_t)nr_vobus * f->vobu_ticks;
+	uint8_t *ifo, *p, *pgc;
+	int i, ret;
+
+	ifo = calloc(sectors, SECTOR);
+	if (ifo == NULL) {
+		perror("calloc");
+		return -1;
+	}
+
+	// VTSI_MAT
+	memcpy(ifo, "DVDVIDEO-VTS", 12);
+	put32(ifo + 0x0C, 2 * sectors + f->sectors - 1);	// vts_last_sector
+	put32(ifo + 0x1C, sectors - 1);			// vtsi_last_sector
+	ifo[0x21] = 0x10;
+	put32(ifo + 0x80, 0x3D8 - 1);			// vtsi_last_byte
+	put32(ifo + 0xC4, sectors);				// vtstt_vobs
+	put32(ifo + 0xC8, 1);					// vts_ptt_srpt
+	put32(ifo + 0xCC, pgcit);				// vts_pgcit
+	put32(ifo + 0xE0, c_adt);				// vts_c_adt
+	put32(ifo + 0xE4, admap);				// vts_vobu_admap
+	put_video_attr(f, ifo + 0x100);
+	put_video_attr(f, ifo + 0x200);
+	if (f->audio != AUDIO_NONE) {
+		ifo[0x203] = 1;
+		put_audio_attr(f, ifo + 0x204);
+	}
+	if (f->spu) {
+		ifo[0x255] = 1;
+		put_subp_attr(ifo + 0x256);
+	}
+
+	// VTS_PTT_SRPT, chapter k is program k of PGC 1
+	p = ifo + SECTOR;
+	put16(p, 1);
+	put32(p + 4, 12 + 4 * n - 1);
+	put32(p + 8, 12);
+	for (i = 0; i < n; i++) {
+		put16(p + 12 + 4 * i, 1);
+		put16(p + 12 + 4 * i + 2, i + 1);
+	}
+
+	// VTS_PGCIT
+	p = ifo + pgcit * SECTOR;
+	put16(p, 1);
+	put32(p + 4, 16 + pgc_size - 1);
+	p[8] = 0x81;							// entry PGC of title 1
+	put32(p + 12, 16);
+	pgc = p + 16;
+	pgc[2] = n;								// programs
+	pgc[3] = n;								// cells
+	put_time(f, pgc + 4, title_ticks);
+	if (f->audio != AUDIO_NONE)
+		put16(pgc + 0x0C, 0x8000);
+	if (f->spu)
+		put32(pgc + 0x1C, 0x80000000);
+	put32(pgc + 0xA4 + 0 * 4, 0x108080);	// black
+	put32(pgc + 0xA4 + 1 * 4, 0xEB8080);	// white
+	put32(pgc + 0xA4 + 2 * 4, 0x7E8080);	// grey
+	put32(pgc + 0xA4 + 3 * 4, 0xD29210);	// yellow
+	int map = 236, playback = map + ((n + 1) & ~1), position = playback + 24 * n;
+	put16(pgc + 0xE6, map);
+	put16(pgc + 0xE8, playback);
+	put16(pgc + 0xEA, position);
+	for (i = 0; i < n; i++) {
+		uint8_t *c = pgc + playback + 24 * i;
+		pgc[map + i] = i + 1;
+		if (i == 0)
+			c[0] = 0x02;					// stc discontinuity
+		put_time(f, c + 4, (uint64_t)f->vobus * f->vobu_ticks);
+		put32(c + 8, f->cell_first[i]);
+		put32(c + 16, f->vobu_start[(i + 1) * f->vobus - 1]);
+		put32(c + 20, f->cell_last[i]);
+		put16(pgc + position + 4 * i, 1);
+		pgc[position + 4 * i + 3] = i + 1;
+	}
+
+	// VTS_C_ADT
+	p = ifo + c_adt * SECTOR;
+	put16(p, 1);
+	put32(p + 4, 8 + 12 * n - 1);
+	for (i = 0; i < n; i++) {
+		put16(p + 8 + 12 * i, 1);
+		p[8 + 12 * i + 2] = i + 1;
+		put32(p + 8 + 12 * i + 4, f->cell_first[i]);
+		put32(p + 8 + 12 * i + 8, f->cell_last[i]);
+	}
+
+	// VTS_VOBU_ADMAP
+	p = ifo + admap * SECTOR;
+	put32(p, 4 + 4 * nr_vobus - 1);
+	for (i = 0; i < nr_vobus; i++)
+		put32(p + 4 + 4 * i, f->vobu_start[i]);
+
+	ret = write_ifo(f, "VTS_01_0.IFO", "VTS_01_0.BUP", ifo, sectors);
+	free(ifo);
+	return ret;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options] <dir>\n"
+		"  -a <ac3|lpcm|mpa|none>  audio stream (ac3)\n"
+		"  -s                      add a subtitle stream\n"
+		"  -n                      NTSC instead of PAL\n"
+		"  -w                      16:9 instead of 4:3\n"
+		"  -c <n>                  chapters (4)\n"
+		"  -v <n>                  VOBUs per chapter (64)\n"
+		"  -b <kbit/s>             video bitrate (6000)\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	struct fixture f;
+	char path[1024];
+	uint8_t *video_es = NULL, *audio_es = NULL;
+	int g, c, ret = 1;
+
+	memset(&f, 0, sizeof(f));
+	f.audio = AUDIO_AC3;
+	f.chapters = 4;
+	f.vobus = 64;
+	f.video_kbps = 6000;
+	f.fd = -1;
+	f.rng = 1;
+
+	while ((c = getopt(argc, argv, "a:snwc:v:b:")) != -1) {
+		switch (c) {
+			case 'a':
+				if (!strcmp(optarg, "ac3"))
+					f.audio = AUDIO_AC3;
+				else if (!strcmp(optarg, "lpcm"))
+					f.audio = AUDIO_LPCM;
+				else if (!strcmp(optarg, "mpa"))
+					f.audio = AUDIO_MPA;
+				else if (!strcmp(optarg, "none"))
+					f.audio = AUDIO_NONE;
+				else {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			case 's':
+				f.spu = 1;
+				break;
+			case 'n':
+				f.ntsc = 1;
+				break;
+			case 'w':
+				f.wide = 1;
+				break;
+			case 'c':
+				f.chapters = atoi(optarg);
+				break;
+			case 'v':
+				f.vobus = atoi(optarg);
+				break;
+			case 'b':
+				f.video_kbps = atoi(optarg);
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc - 1 || f.chapters < 1 || f.chapters > 99 || f.vobus < 1 || f.video_kbps < 100) {
+		usage(argv[0]);
+		return 1;
+	}
+	f.dir = argv[optind];
+
+	f.frames = f.ntsc ? 15 : 12;
+	f.frame_ticks = f.ntsc ? 3003 : 3600;
+	f.vobu_ticks = f.frames * f.frame_ticks;
+	f.video_sectors = (int)((int64_t)f.video_kbps * 1000 / 8 * f.vobu_ticks / 90000 / 2025);
+	if (f.video_sectors < 2)
+		f.video_sectors = 2;
+	switch (f.audio) {
+		case AUDIO_AC3:
+			f.audio_frame = 1792;
+			f.audio_ticks = 2880;
+			f.audio_payload = 2016;
+			break;
+		case AUDIO_LPCM:
+			f.audio_frame = 320;		// 1/600s
+			f.audio_ticks = 150;
+			f.audio_payload = 2012;		// whole stereo samples
+			break;
+		case AUDIO_MPA:
+			f.audio_frame = 672;
+			f.audio_ticks = 2160;
+			f.audio_payload = 2020;
+			break;
+	}
+
+	f.vobu_start = calloc(f.chapters * f.vobus + 1, sizeof(uint32_t));
+	f.cell_first = calloc(f.chapters, sizeof(uint32_t));
+	f.cell_last = calloc(f.chapters, sizeof(uint32_t));
+	video_es = malloc(f.video_sectors * 2025);
+	audio_es = malloc(f.audio == AUDIO_NONE ? 1 : (f.vobu_ticks / f.audio_ticks + 2) * f.audio_frame);
+	if (!f.vobu_start || !f.cell_first || !f.cell_last || !video_es || !audio_es) {
+		perror("malloc");
+		goto out;
+	}
+
+	snprintf(path, sizeof(path), "%s/VIDEO_TS", f.dir);
+	if ((mkdir(f.dir, 0755) < 0 && errno != EEXIST) || (mkdir(path, 0755) < 0 && errno != EEXIST)) {
+		perror(path);
+		goto out;
+	}
+
+	layout(&f);
+	for (g = 0; g < f.chapters * f.vobus; g++) {
+		if (write_vobu(&f, g, video_es, audio_es) < 0)
+			goto out;
+	}
+	if (write_vmg(&f) < 0 || write_vts(&f) < 0)
+		goto out;
+
+	printf("%s: %d chapters, %d VOBUs, %u sectors (%.1f MB)\n", f.dir, f.chapters, f.chapters * f.vobus,
+		f.sectors, f.sectors * (double)SECTOR / (1024 * 1024));
+	ret = 0;
+
+out:
+	if (f.fd >= 0)
+		close(f.fd);
+	free(video_es);
+	free(audio_es);
+	free(f.vobu_start);
+	free(f.cell_first);
+	free(f.cell_last);
+	return ret;
+}
@@ -0,0 +1,463 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+/*
+ * ddvd_bench_kernels, cost of the hot kernels in isolation
+ *
+ * Every kernel runs on a fixed input built here, so the numbers only change when the code
+ * does. Each call is timed on its own, the best of all iterations is reported as cycles per
+ * pixel, sample or pack (ns when the cycle counter is not available). The AC3 decoder needs liba52
+ * and a raw AC3 stream given with -a.
+ */
+
+#include "libdreamdvd_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "ddvdlib.h"
+#include "ddvd_internal.h"
+#include "demux.h"
+
+#define SPU_X		0
+#define SPU_Y		440
+#define SPU_WIDTH	720
+#define SPU_HEIGHT	120
+
+#define DST_XRES	1280
+#define DST_YRES	720
+
+static int perf_fd = -1;
+
+static void counter_open(void)
+{
+#ifdef HAVE_LINUX_PERF_EVENT_H
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CPU_CYCLES;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	perf_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+}
+
+// cycles when the pmu is accessible, else nanoseconds
+static uint64_t counter_read(void)
+{
+	struct timespec ts;
+	uint64_t count;
+
+	if (perf_fd >= 0 && read(perf_fd, &count, sizeof(count)) == sizeof(count))
+		return count;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void report(const char *kernel, uint64_t best, double units, const char *unit)
+{
+	printf("%-24s %12llu %10.0f %10.2f %s/%s\n", kernel, (unsigned long long)best, units, best / units,
+		perf_fd >= 0 ? "cycles" : "ns", unit);
+}
+
+static void put16(uint8_t *p, int v)
+{
+	p[0] = v >> 8;
+	p[1] = v;
+}
+
+// a subtitle sized unit with text like runs of all four colors, same input on every run
+static int build_spu(uint8_t *spu)
+{
+	int x2 = SPU_X + SPU_WIDTH - 1, y2 = SPU_Y + SPU_HEIGHT - 1;
+	int field_offset[2];
+	int pos = 4, nibble = 0;
+	int field, y, x;
+	uint32_t seed = 1;
+
+#define PUT_NIBBLE(v) do { \
+		if (nibble) { spu[pos++] |= (v); nibble = 0; } \
+		else { spu[pos] = (v) << 4; nibble = 1; } \
+	} while (0)
+
+	for (field = 0; field < 2; field++) {
+		field_offset[field] = pos;
+		for (y = field; y < SPU_HEIGHT; y += 2) {
+			x = 0;
+			while (x < SPU_WIDTH) {
+				seed = seed * 1103515245 + 12345;
+				int color = (seed >> 16) & 3;
+				int run = 1 + ((seed >> 20) % 24);
+				if (x + run > SPU_WIDTH)
+					run = SPU_WIDTH - x;
+				int code = (run << 2) | color;
+				if (run >= 64) {
+					PUT_NIBBLE(0); PUT_NIBBLE(code >> 8); PUT_NIBBLE((code >> 4) & 0xF); PUT_NIBBLE(code & 0xF);
+				}
+				else if (run >= 16) {
+					PUT_NIBBLE(0); PUT_NIBBLE(code >> 4); PUT_NIBBLE(code & 0xF);
+				}
+				else if (run >= 4) {
+					PUT_NIBBLE(code >> 4); PUT_NIBBLE(code & 0xF);
+				}
+				else
+					PUT_NIBBLE(code);
+				x += run;
+			}
+			if (nibble)	// lines are byte aligned
+				PUT_NIBBLE(0);
+		}
+	}
+#undef PUT_NIBBLE
+
+	int dcsq = pos;
+	put16(spu + 2, dcsq);
+	put16(spu + pos, 0);
+	put16(spu + pos + 2, dcsq);
+	pos += 4;
+	spu[pos++] = 0x03;	// colors
+	spu[pos++] = 0x32;
+	spu[pos++] = 0x10;
+	spu[pos++] = 0x04;	// contrast
+	spu[pos++] = 0xFF;
+	spu[pos++] = 0xF0;
+	spu[pos++] = 0x05;	// area
+	spu[pos++] = SPU_X >> 4;
+	spu[pos++] = ((SPU_X & 0xF) << 4) | (x2 >> 8);
+	spu[pos++] = x2;
+	spu[pos++] = SPU_Y >> 4;
+	spu[pos++] = ((SPU_Y & 0xF) << 4) | (y2 >> 8);
+	spu[pos++] = y2;
+	spu[pos++] = 0x06;	// field offsets
+	put16(spu + pos, field_offset[0]);
+	put16(spu + pos + 2, field_offset[1]);
+	pos += 4;
+	spu[pos++] = 0x01;	// show
+	spu[pos++] = 0xFF;
+	put16(spu, pos);
+	return pos;
+}
+
+static void bench_spu_blit(struct ddvd *ddvd, int iterations)
+{
+	uint8_t *spu = malloc(65536);
+	char *lbb = malloc(720 * 576);
+	uint32_t *argb = malloc(720 * 576 * 4);
+	uint64_t t, best;
+	int i;
+
+	build_spu(spu);
+	memset(lbb, 0, 720 * 576);
+	for (best = ~0ULL, i = 0; i < iterations; i++) {
+		t = counter_read();
+		ddvd_spu_decode_data(ddvd, lbb, spu, 0);
+		t = counter_read() - t;
+		if (t < best)
+			best = t;
+	}
+	report("spu_decode_data", best, SPU_WIDTH * SPU_HEIGHT, "pixel");
+
+	for (best = ~0ULL, i = 0; i < iterations; i++) {
+		t = counter_read();
+		ddvd_blit_to_argb(ddvd, argb, lbb, 720 * 576);
+		t = counter_read() - t;
+		if (t < best)
+			best = t;
+	}
+	report("blit_to_argb", best, 720 * 576, "pixel");
+
+	free(argb);
+	free(lbb);
+	free(spu);
+}
+
+typedef struct ddvd_resize_return (*resize_fn)(unsigned char *, int, int, int, int, int, int, int, int, int, int, int);
+
+// the kernels scale in place, the source is restored before every call
+static void bench_resize(const char *name, resize_fn resize, int colors, int iterations)
+{
+	int src_size = 720 * 576 * colors;
+	int dst_size = DST_XRES * DST_YRES * colors;
+	unsigned char *src = malloc(src_size);
+	unsigned char *pixmap = malloc(src_size > dst_size ? src_size : dst_size);
+	uint64_t t, best;
+	int i;
+
+	for (i = 0; i < src_size; i++)
+		src[i] = (i / colors) % 720 / 16 % 2 ? 0xFF : i * 7;
+	for (best = ~0ULL, i = 0; i < iterations; i++) {
+		memcpy(pixmap, src, src_size);
+		t = counter_read();
+		resize(pixmap, 720, 576, DST_XRES, DST_YRES, 0, 0, 0, 719, 0, 575, colors);
+		t = counter_read() - t;
+		if (t < best)
+			best = t;
+	}
+	report(name, best, DST_XRES * DST_YRES, "pixel");
+
+	free(pixmap);
+	free(src);
+}
+
+static void bench_mpa(int iterations)
+{
+	ddvd_mpa_context *mpa = ddvd_mpa_init(48000, 192000);
+	int16_t pcm[1152 * 2];
+	unsigned char frame[4608];
+	uint64_t t, best;
+	int i;
+
+	if (mpa == NULL) {
+		printf("%-24s skipped, encoder init failed\n", "mpa_encode_frame");
+		return;
+	}
+	for (i = 0; i < 1152; i++) {
+		pcm[2 * i] = 8000 * sin(2 * M_PI * 1000 * i / 48000);
+		pcm[2 * i + 1] = 8000 * sin(2 * M_PI * 1500 * i / 48000);
+	}
+	for (best = ~0ULL, i = 0; i < iterations; i++) {
+		t = counter_read();
+		ddvd_mpa_encode_frame(mpa, frame, sizeof(frame), pcm);
+		t = counter_read() - t;
+		if (t < best)
+			best = t;
+	}
+	report("mpa_encode_frame", best, 1152, "sample");
+	ddvd_mpa_free(mpa);
+}
+
+// one pack with a pes header of 5 bytes pts, the payload starts with substream (-1 none)
+static void build_pack(uint8_t *pack, int stream_id, int substream, int pts)
+{
+	uint8_t *p = pack + DDVD_PACK_HEADER;
+
+	memset(pack, 0xFF, 2048);
+	memcpy(pack, "\x00\x00\x01\xBA", 4);
+	memcpy(p, "\x00\x00\x01", 3);
+	p[3] = stream_id;
+	put16(p + 4, 2048 - DDVD_PACK_HEADER - 6);
+	p[6] = 0x81;
+	p[7] = 0x80;
+	p[8] = 5;
+	p[9] = 0x21 | ((pts >> 29) & 0x0E);
+	put16(p + 10, ((pts >> 14) & 0xFFFE) | 1);
+	put16(p + 12, ((pts << 1) & 0xFFFE) | 1);
+	if (substream >= 0)
+		p[14] = substream;
+}
+
+// a mix like a film title, mostly video, two audio streams and subpictures, reported per pack
+static void bench_demux(int iterations)
+{
+	static const int mix[][2] = {
+		{ 0xBF, -1 }, { 0xE0, -1 }, { 0xE0, -1 }, { 0xBD, 0x80 }, { 0xE0, -1 }, { 0xE0, -1 },
+		{ 0xBD, 0x81 }, { 0xE0, -1 }, { 0xBD, 0x20 }, { 0xE0, -1 }, { 0xC0, -1 }, { 0xBE, -1 },
+		{ 0xE0, -1 }, { 0xBD, 0xA0 }, { 0xE0, -1 }, { 0xBD, 0x88 },
+	};
+	int packs = sizeof(mix) / sizeof(mix[0]);
+	struct ddvd_pes pes;
+	uint8_t *buf;
+	uint64_t t, best;
+	int i, j, types = 0;
+
+	buf = malloc(packs * 2048);
+	if (buf == NULL)
+		return;
+	for (j = 0; j < packs; j++)
+		build_pack(buf + j * 2048, mix[j][0], mix[j][1], j * 3600);
+
+	for (best = ~0ULL, i = 0; i < iterations; i++) {
+		t = counter_read();
+		for (j = 0; j < packs; j++)
+			types += ddvd_demux_parse(buf + j * 2048, 2048, &pes);
+		t = counter_read() - t;
+		if (t < best)
+			best = t;
+	}
+	if (types == 0)	// keep the calls
+		printf("no stream recognized\n");
+	report("demux_parse", best, packs, "pack");
+	free(buf);
+}
+
+// a video pack with a picture header and a few slices in noise, reported per byte
+static void bench_start_codes(int iterations)
+{
+	static const uint8_t headers[][4] = {
+		{ 0, 0, 1, 0x00 }, { 0, 0, 1, 0xB5 }, { 0, 0, 1, 0x01 }, { 0, 0, 1, 0x02 }, { 0, 0, 1, 0x03 },
+	};
+	uint8_t pack[2048];
+	uint16_t codes[DDVD_MAX_START_CODES];
+	uint64_t t, best;
+	unsigned int seed = 1;
+	int i, n = 0;
+
+	build_pack(pack, 0xE0, -1, 0);
+	for (i = DDVD_PACK_HEADER + 14; i < 2048; i++) {
+		seed = seed * 1103515245 + 12345;
+		pack[i] = (seed >> 16) | 0x02;	// no start codes by chance
+	}
+	for (i = 0; i < 5; i++)
+		memcpy(pack + DDVD_PACK_HEADER + 14 + i * 400, headers[i], 4);
+
+	for (best = ~0ULL, i = 0; i < iterations; i++) {
+		t = counter_read();
+		n += ddvd_demux_start_codes(pack, DDVD_PACK_HEADER + 14, 2048, codes, DDVD_MAX_START_CODES);
+		t = counter_read() - t;
+		if (t < best)
+			best = t;
+	}
+	if (n != 5 * iterations)
+		printf("%-24s found %d start codes instead of 5\n", "demux_start_codes", n / iterations);
+	report("demux_start_codes", best, 2048 - DDVD_PACK_HEADER - 14, "byte");
+}
+
+// the stream is fed in pack sized pieces like the player does, reported per stereo output sample
+static void bench_ac3(const char *file, int iterations)
+{
+	struct ddvd_a52 a52;
+	int16_t *out;
+	uint8_t *es;
+	long len;
+	uint64_t t, best;
+	FILE *f;
+	int i;
+
+	if (file == NULL) {
+		printf("%-24s skipped, no AC3 stream given (-a)\n", "ac3_decode");
+		return;
+	}
+	if (!ddvd_load_liba52()) {
+		printf("%-24s skipped, liba52 not available\n", "ac3_decode");
+		return;
+	}
+	f = fopen(file, "rb");
+	if (f == NULL) {
+		perror(file);
+		ddvd_close_liba52();
+		return;
+	}
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	es = malloc(len);
+	out = malloc(len / 2 * 1024 * 6 / 64 + 65536);	// a frame is at least 64 bytes
+	if (es == NULL || out == NULL || fread(es, 1, len, f) != (size_t)len) {
+		fprintf(stderr, "%s: read failed\n", file);
+		fclose(f);
+		free(es);
+		free(out);
+		ddvd_close_liba52();
+		return;
+	}
+	fclose(f);
+
+	long samples = 0;
+	for (best = ~0ULL, i = 0; i < iterations; i++) {
+		long pos, bytes = 0;
+		memset(&a52, 0, sizeof(a52));
+		if (!ddvd_a52_init(&a52))
+			break;
+		t = counter_read();
+		for (pos = 0; pos < len; pos += 2016)
+			bytes += ddvd_ac3_decode(&a52, es + pos, len - pos < 2016 ? len - pos : 2016, out + bytes / 2);
+		t = counter_read() - t;
+		ddvd_a52_free(&a52);
+		samples = bytes / 4;
+		if (t < best)
+			best = t;
+	}
+	if (samples > 0)
+		report("ac3_decode", best, samples, "sample");
+	else
+		printf("%-24s skipped, no frames decoded from %s\n", "ac3_decode", file);
+
+	free(out);
+	free(es);
+	ddvd_close_liba52();
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options]\n"
+		"  -n <n>     iterations per kernel, the best is reported (200)\n"
+		"  -a <file>  raw AC3 stream for the AC3 decoder\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	const char *ac3 = NULL;
+	int iterations = 200;
+	struct ddvd *ddvd;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:a:")) != -1) {
+		switch (c) {
+			case 'n':
+				iterations = atoi(optarg);
+				break;
+			case 'a':
+				ac3 = optarg;
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (iterations < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	ddvd = ddvd_create();
+	if (ddvd == NULL)
+		return 1;
+
+	counter_open();
+	printf("%-24s %12s %10s %10s\n", "kernel", "best", "units", "per unit");
+	bench_demux(iterations);
+	bench_start_codes(iterations);
+	bench_spu_blit(ddvd, iterations);
+	bench_resize("resize_pixmap_xbpp", ddvd_resize_pixmap_xbpp, 4, iterations);
+	bench_resize("resize_pixmap_smooth", ddvd_resize_pixmap_xbpp_smooth, 4, iterations);
+	bench_resize("resize_pixmap_1bpp", ddvd_resize_pixmap_1bpp, 1, iterations);
+	bench_mpa(iterations);
+	bench_ac3(ac3, iterations);
+
+	if (perf_fd >= 0)
+		close(perf_fd);
+	ddvd_close(ddvd);
+	return 0;
+}
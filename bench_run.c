@@ -0,0 +1,215 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+/*
+ * ddvd_bench, end-to-end throughput of ddvd_run
+ *
+ * Every DVD structure given on the command line (usually made by ddvd_mkfixture, one per
+ * stream type) is remuxed from start to end of the title as fast as possible. No decoder is
+ * needed, the output goes to the memory sink or through the TS multiplexer to /dev/null.
+ * The best of the runs is reported as blocks/s, MB/s and CPU time.
+ */
+
+#include "libdreamdvd_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include "ddvdlib.h"
+
+struct bench_run {
+	struct ddvd *ddvd;
+	enum ddvd_result res;
+	volatile int done;
+};
+
+struct bench_result {
+	double wall;		// seconds
+	double cpu;			// seconds, user + system
+};
+
+static void *bench_thread(void *arg)
+{
+	struct bench_run *run = arg;
+	run->res = ddvd_run(run->ddvd);
+	run->done = 1;
+	return NULL;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double cpu_time(void)
+{
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+// size of the title VOBS of title set 1 in blocks
+static long title_blocks(const char *dir)
+{
+	char name[1024];
+	struct stat st;
+	long blocks = 0;
+	int i;
+
+	for (i = 1; i <= 9; i++) {
+		snprintf(name, sizeof(name), "%s/VIDEO_TS/VTS_01_%d.VOB", dir, i);
+		if (stat(name, &st) < 0)
+			break;
+		blocks += st.st_size / 2048;
+	}
+	return blocks;
+}
+
+static int bench_one(const char *dir, int sink, int title, unsigned char *lfb, struct bench_result *result)
+{
+	struct bench_run run;
+	pthread_t thread;
+	double wall, cpu;
+
+	memset(&run, 0, sizeof(run));
+	run.ddvd = ddvd_create();
+	if (run.ddvd == NULL)
+		return -1;
+	ddvd_set_dvd_path(run.ddvd, dir);
+	ddvd_set_lfb(run.ddvd, lfb, 720, 576, 4, 720 * 4);
+	ddvd_set_ac3thru(run.ddvd, 1);
+	ddvd_set_sink(run.ddvd, sink, sink == DDVD_SINK_TS ? "/dev/null" : NULL);
+	ddvd_set_run_mode(run.ddvd, DDVD_RUN_REMUX, title);
+	ddvd_set_spu(run.ddvd, 0);
+
+	wall = now();
+	cpu = cpu_time();
+	if (pthread_create(&thread, NULL, bench_thread, &run) != 0) {
+		perror("pthread_create");
+		ddvd_close(run.ddvd);
+		return -1;
+	}
+	while (!run.done) {	// keep the message pipe from filling up
+		while (ddvd_get_next_message(run.ddvd, 0) != DDVD_NULL)
+			;
+		usleep(10000);
+	}
+	pthread_join(thread, NULL);
+	result->wall = now() - wall;
+	result->cpu = cpu_time() - cpu;
+
+	ddvd_close(run.ddvd);
+	if (run.res != DDVD_OK) {
+		fprintf(stderr, "%s: ddvd_run failed (%d)\n", dir, run.res);
+		return -1;
+	}
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options] <dvd>...\n"
+		"  -s <memory|ts>  output sink (memory)\n"
+		"  -r <n>          runs per dvd, the best is reported (3)\n"
+		"  -t <n>          title to remux (1)\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	int sink = DDVD_SINK_MEMORY;
+	int runs = 3;
+	int title = 1;
+	unsigned char *lfb;
+	int c, i, r, ret = 0;
+
+	while ((c = getopt(argc, argv, "s:r:t:")) != -1) {
+		switch (c) {
+			case 's':
+				if (!strcmp(optarg, "memory"))
+					sink = DDVD_SINK_MEMORY;
+				else if (!strcmp(optarg, "ts"))
+					sink = DDVD_SINK_TS;
+				else {
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			case 'r':
+				runs = atoi(optarg);
+				break;
+			case 't':
+				title = atoi(optarg);
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind == argc || runs < 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	lfb = malloc(720 * 576 * 4);
+	if (lfb == NULL) {
+		perror("malloc");
+		return 1;
+	}
+
+	printf("%-24s %6s %9s %11s %9s %6s %9s\n", "dvd", "sink", "blocks", "blocks/s", "MB/s", "cpu%", "us/block");
+	for (i = optind; i < argc; i++) {
+		struct bench_result best = { 0, 0 };
+		long blocks = title_blocks(argv[i]);
+		const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+
+		for (r = 0; r < runs; r++) {
+			struct bench_result res;
+			if (bench_one(argv[i], sink, title, lfb, &res) < 0) {
+				ret = 1;
+				break;
+			}
+			if (r == 0 || res.wall < best.wall)
+				best = res;
+		}
+		if (r < runs || blocks == 0 || best.wall <= 0)
+			continue;
+
+		printf("%-24s %6s %9ld %11.0f %9.1f %6.1f %9.2f\n", name, sink == DDVD_SINK_TS ? "ts" : "memory", blocks,
+			blocks / best.wall, blocks * 2048.0 / (1024 * 1024) / best.wall,
+			100.0 * best.cpu / best.wall, 1e6 * best.cpu / blocks);
+	}
+
+	free(lfb);
+	return ret;
+}
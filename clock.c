@@ -0,0 +1,80 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#include <string.h>
+
+#include "clock.h"
+#include "stats.h"
+#include "debug.h"
+
+void ddvd_clock_init(struct ddvd_clock *clock)
+{
+	memset(clock, 0, sizeof(struct ddvd_clock));
+}
+
+void ddvd_clock_resync(struct ddvd_clock *clock)
+{
+	clock->valid = 0;
+}
+
+int ddvd_clock_update(struct ddvd_clock *clock, struct ddvd_sink *sink, int running)
+{
+	uint64_t now = ddvd_stats_clock();
+
+	if (running != clock->running) {	// the decoder speed changes, the interpolation is off
+		clock->running = running;
+		clock->valid = 0;
+	}
+	if (clock->valid && now - clock->sample_ns < DDVD_CLOCK_SAMPLE_MS * 1000000ULL)
+		return 0;
+
+#if CONFIG_API_VERSION == 1
+	unsigned int tpts;
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_GET_PTS, &tpts) < 0)
+		Perror("VIDEO_GET_PTS");
+	else
+		clock->pts = tpts;
+#else
+	unsigned long long pts;
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_GET_PTS, &pts) < 0)
+		Perror("VIDEO_GET_PTS");
+	else
+		clock->pts = pts;
+#endif
+	clock->sample_ns = now;
+	clock->valid = 1;
+	return 1;
+}
+
+unsigned long long ddvd_clock_pts(struct ddvd_clock *clock)
+{
+	if (!clock->valid || !clock->running)
+		return clock->pts;
+	// the sample is at most DDVD_CLOCK_SAMPLE_MS old
+#if CONFIG_API_VERSION == 1
+	// the 32 bit decoder time counts 45 kHz
+	return clock->pts + (ddvd_stats_clock() - clock->sample_ns) * 9 / 200000;
+#else
+	return clock->pts + (ddvd_stats_clock() - clock->sample_ns) * 9 / 100000;
+#endif
+}
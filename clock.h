@@ -0,0 +1,58 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+#include <stdint.h>
+
+#include "sink.h"
+
+/*
+ * playback clock, the decoder time (pts) without asking the decoder every round
+ *
+ * The decoder pts (STC) is sampled at most every DDVD_CLOCK_SAMPLE_MS and moved on with the
+ * monotonic clock in between, as long as the decoder plays at normal speed. Paused, stepping
+ * or in trick mode the last sample is used as is. A change of the play state and
+ * ddvd_clock_resync (jumps, cleared decoder) take a new sample on the next update.
+ */
+
+#define DDVD_CLOCK_SAMPLE_MS	40		// one video frame, subtitles are shown on a frame anyway
+
+struct ddvd_clock {
+	unsigned long long pts;			// decoder pts of the last sample (45 kHz on API 1)
+	uint64_t sample_ns;				// monotonic time of the last sample
+	int valid;						// a sample was taken since the last resync
+	int running;					// the decoder plays at normal speed
+};
+
+void	ddvd_clock_init(struct ddvd_clock *clock);
+void	ddvd_clock_resync(struct ddvd_clock *clock);
+
+// samples the decoder when due, returns 1 when it did (so the caller can ask it for more)
+int		ddvd_clock_update(struct ddvd_clock *clock, struct ddvd_sink *sink, int running);
+
+// current decoder pts
+unsigned long long ddvd_clock_pts(struct ddvd_clock *clock);
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __DDVD_INTERNAL_H__
+#define __DDVD_INTERNAL_H__
+
+/*
+ * library internals shared with the benchmarks, this header is not installed and
+ * nothing in here is part of the API
+ */
+
+#include <stdint.h>
+
+#include "a52dec.h"
+#include "mpegaudioenc.h"
+
+struct ddvd;
+
+enum {SPU_NOP, SPU_SHOW, SPU_HIDE, SPU_FORCE};
+struct ddvd_spu_return {
+	int display_time;
+	int x_start;
+	int x_end;
+	int y_start;
+	int y_end;
+	int force_hide;
+	unsigned long long pts;
+};
+
+struct ddvd_resize_return {
+	int x_start;
+	int x_end;
+	int y_start;
+	int y_end;
+
+	int x_offset, y_offset, width, height;
+};
+
+// decode a complete SPU packet into the 720x576 8 bit backbuffer spu_buf (colors 252-255),
+// palette and transparency commands update the palette of the player
+struct ddvd_spu_return ddvd_spu_decode_data(struct ddvd *playerconfig, char *spu_buf, const uint8_t *buffer, unsigned long long pts);
+
+// convert pix 8 bit pixels to 32 bit argb with the palette of the player
+void ddvd_blit_to_argb(struct ddvd *playerconfig, void *_dst, const void *_src, int pix);
+
+// scale the xsource*ysource pixmap in place to xdest*ydest, the buffer must hold the larger of both
+struct ddvd_resize_return ddvd_resize_pixmap_xbpp(unsigned char *pixmap, int xsource, int ysource, int xdest, int ydest, int xoffset, int yoffset, int xstart, int xend, int ystart, int yend, int colors);
+struct ddvd_resize_return ddvd_resize_pixmap_xbpp_smooth(unsigned char *pixmap, int xsource, int ysource, int xdest, int ydest, int xoffset, int yoffset, int xstart, int xend, int ystart, int yend, int colors);
+struct ddvd_resize_return ddvd_resize_pixmap_1bpp(unsigned char *pixmap, int xsource, int ysource, int xdest, int ydest, int xoffset, int yoffset, int xstart, int xend, int ystart, int yend, int colors);
+
+#endif
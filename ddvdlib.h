@@ -23,6 +23,8 @@
  * part of libdreamdvd
  */
 
+#ifndef __DDVDLIB_H__
+#define __DDVDLIB_H__
 
 /*
  * main struct for ddvd handle
@@ -73,6 +75,16 @@ void ddvd_set_lfb_ex(struct ddvd *pconfig, unsigned char *lfb, int xres, int yre
 // set path to a dvd block device, a dvd file structure or an dvd iso-file ("/dev/dvd" ...)
 void ddvd_set_dvd_path(struct ddvd *pconfig, const char *path);
 
+// set a directory to keep the seek index of played discs in (one small file per disc), so
+// playing a disc again does not parse its IFO files for it, NULL (the default) keeps nothing
+void ddvd_set_cache_dir(struct ddvd *pconfig, const char *dir);
+
+// set the directory libdvdcss keeps the cracked title keys of scrambled discs in (DVDCSS_CACHE, which
+// is set for the whole process when a disc is opened), NULL (the default) leaves DVDCSS_CACHE as it is.
+// With a key cache ddvd_probe also fetches the keys of all title sets on a thread of its own, after
+// DDVD_DISC_INFO and next to ddvd_run
+void ddvd_set_css_cache(struct ddvd *pconfig, const char *dir);
+
 // set preferred dvd language in 2 letter iso code (en,de, ...)
 void ddvd_set_language(struct ddvd *pconfig, const char lang[2]);
 
@@ -81,10 +93,32 @@ void ddvd_set_language(struct ddvd *pconfig, const char lang[2]);
 // if set to "internal" and liba52 will not be found, the AC3 data will be passed thru 
 void ddvd_set_ac3thru(struct ddvd *pconfig, int ac3thru);
 
+// open the decoders non-blocking (default 0), a full decoder does not stall keys, subtitles
+// and menu highlights, the player polls it until it takes more data
+void ddvd_set_nonblock_output(struct ddvd *pconfig, int nonblock);
+
+// read ahead with the cache of dvdnav and play the blocks in place instead of copying them
+// (default 0), smooths reading from slow drives at the cost of some memory
+void ddvd_set_readahead(struct ddvd *pconfig, int readahead);
+
 // set video options for aspect and the tv system, see enums for possible options
 void ddvd_set_video(struct ddvd *pconfig, int aspect, int tv_mode, int tv_system);
 void ddvd_set_video_ex(struct ddvd *pconfig, int aspect, int tv_mode, int tv_mode2, int tv_system);
 
+// set the output backend, see sink enum for possible backends (default DDVD_SINK_DVB)
+// path is the file prefix for DDVD_SINK_FILE, the streams and control calls are recorded to
+// <path>.video.pes, <path>.audio.pes, <path>.spu.pes and <path>.ctl
+// for DDVD_SINK_TS path is the transport stream file or a dvr device to write to
+void ddvd_set_sink(struct ddvd *pconfig, int sink, const char *path);
+
+// set what ddvd_run does with the dvd, see run mode enum for possible modes (default DDVD_RUN_PLAY)
+// DDVD_RUN_REMUX plays the given title without menus, still waits, timers or subtitle rendering and
+// writes video, audio and subtitles to the sink as fast as the disc can be read, ddvd_run returns
+// when the title ends. Use it together with DDVD_SINK_TS to archive a title as MPEG-TS
+// DDVD_RUN_MAIN_FEATURE plays like DDVD_RUN_PLAY but starts the title with the longest playback time
+// (title is not used), DDVD_KEY_MENU leads to the menus from there
+void ddvd_set_run_mode(struct ddvd *pconfig, int mode, int title);
+
 // set resume postion for dvd start
 void ddvd_set_resume_pos(struct ddvd *pconfig, struct ddvd_resume resume_info);
 
@@ -94,6 +128,18 @@ void ddvd_set_audio(struct ddvd *pconfig, int audio_id);
 // directly set given subtitle stream id (alternative to iteration through the streams with the DDVD_KEY_SUBTITLE)
 void ddvd_set_spu(struct ddvd *pconfig, int spu_id);
 
+#define DDVD_SUPPORTS_PROBE 1
+struct ddvd_disc_info;
+// prepare the disc set with ddvd_set_dvd_path on a thread of its own: open it, read the title, chapter
+// and stream tables, load liba52 and set up the mp2 encoder. ddvd_run takes over what is ready and
+// starts right away. Sends DDVD_DISC_INFO when done, returns DDVD_OK when the thread runs.
+// Do not change the options of the handle until DDVD_DISC_INFO came or ddvd_run was called
+enum ddvd_result ddvd_probe(struct ddvd *pconfig);
+
+// get what ddvd_probe found, use blocked=1 to wait for it. Returns DDVD_BUSY while the probe runs
+// (blocked=0), DDVD_INVAL without a probe and DDVD_FAIL_OPEN if the disc could not be opened
+enum ddvd_result ddvd_get_disc_info(struct ddvd *pconfig, struct ddvd_disc_info *info, int blocked);
+
 /* 
  * functions for starting the dvd player
  */
@@ -113,6 +159,9 @@ void ddvd_send_key(struct ddvd *pconfig, int key);
 // skip n seconds in playing n>0 forward - n<0 backward
 void ddvd_skip_seconds(struct ddvd *pconfig, int seconds);
 
+// jump to the given seconds from the beginning of the current title
+void ddvd_seek_abs(struct ddvd *pconfig, int seconds);
+
 // jump to beginning of given title
 void ddvd_set_title(struct ddvd *pconfig, int title);
 
@@ -188,6 +237,18 @@ void ddvd_get_last_size(struct ddvd *pconfig, int *width, int *height, int *aspe
 void ddvd_get_last_framerate(struct ddvd *pconfig, int *frate);
 void ddvd_get_last_progressive(struct ddvd *pconfig, int *progressive);
 
+#define DDVD_SUPPORTS_STATS 1
+struct ddvd_stats;
+// get a consistent copy of the performance counters of the player, safe to call from any thread
+// while the player is running. The counters only grow over the lifetime of the handle, subtract
+// two copies to get the numbers for an interval
+void ddvd_get_stats(struct ddvd *pconfig, struct ddvd_stats *stats);
+
+// write the recorded player loop events as text to fd, oldest first. With LIBDVD_DEBUG set to 3 or
+// higher the timing sensitive debug output of the player loop is only recorded and written here
+// (and once more when ddvd_run returns), so printing it does not disturb the playback
+void ddvd_trace_dump(int fd);
+
 /* 
  * functions for clean up AFTER the player had stopped
  */
@@ -229,6 +290,7 @@ enum { // state
 	DDVD_FRAMERATE_CHANGED,
 	DDVD_SHOWOSD_STATE_SFWD,	// we should display SFWD/SBWD trickmode on osd you can grab the actual time with ddvd_get_last_time
 	DDVD_SHOWOSD_STATE_SBWD,	// and the trickspeed with ddvd_get_last_trickspeed
+	DDVD_DISC_INFO,				// ddvd_probe is done, get the result with ddvd_get_disc_info
 };
 
 
@@ -265,7 +327,7 @@ enum { // send_key
 	DDVD_SKIP_BWD,				// jump backward in playing SHOULD NOT BE USED DIRECTLY, USE ddvd_skip_seconds FOR SKIPPING 
 	DDVD_SET_TITLE,				// jump to given title
 	DDVD_SET_CHAPTER,			// jump to given chapter
-	DDVD_SEEK_ABS,				// seek to given absolute seconds (from beginning of current title)
+	DDVD_SEEK_ABS,				// seek to given absolute seconds (from beginning of current title) SHOULD NOT BE USED DIRECTLY, USE ddvd_seek_abs
 	DDVD_SET_MUTE,				// just telling dreamdvd that the sound has been muted, libdreamdvd does not mute for you, but has to know
 								// the mute state for sound handling on ffwd/fbwd trick mode
 	DDVD_UNSET_MUTE,			// sound is not muted any more (see DDVD_SET_MUTE)
@@ -313,9 +375,40 @@ enum { // tv mode
 	DDVD_JUSTSCALE,
 };
 
+enum { // sink
+	DDVD_SINK_DVB,				// decoder devices in /dev/dvb
+	DDVD_SINK_FILE,				// record PES streams and control calls to files, no decoder needed
+	DDVD_SINK_MEMORY,			// drop the output, only count it (benchmarking)
+	DDVD_SINK_TS,				// multiplex the streams into an MPEG transport stream file
+};
+
+enum { // run mode
+	DDVD_RUN_PLAY,				// interactive playback in real time
+	DDVD_RUN_REMUX,				// demux a single title as fast as possible
+	DDVD_RUN_MAIN_FEATURE,		// interactive playback, starting with the longest title instead of first play and menus
+};
+
+enum { // output devices
+	DDVD_DEV_VIDEO,				// video PES stream and video decoder control
+	DDVD_DEV_AUDIO,				// audio PES stream and audio decoder control
+	DDVD_DEV_SPU,				// subpicture PES stream, only written when remuxing
+	DDVD_DEV_MAX,
+};
+
+enum { // stats stages
+	DDVD_STAGE_READ,			// dvdnav_get_next_block
+	DDVD_STAGE_WRITE,			// writes to the output devices
+	DDVD_STAGE_MESSAGE,			// writes to the message pipe
+	DDVD_STAGE_SPU_DECODE,		// subpicture decoding
+	DDVD_STAGE_BLIT,			// argb conversion and resizing of subtitles and menus
+	DDVD_STAGE_AC3_DECODE,		// AC3 soft decoding
+	DDVD_STAGE_MPA_ENCODE,		// MPEG audio encoding of decoded AC3 and LPCM
+	DDVD_STAGE_MAX,
+};
+
 
 /* 
- * structs for color palette and osd time and resume info
+ * structs for color palette, osd time, disc info and resume info
  */
 
 struct ddvd_color { 
@@ -337,3 +430,43 @@ struct ddvd_time {
 	int end_chapter;
 	int end_title;
 };
+
+#define DDVD_MAX_TITLES 99
+#define DDVD_MAX_AUDIO 8
+#define DDVD_MAX_SPU 32
+
+struct ddvd_title_info {
+	int chapters;
+	int angles;
+	int seconds;				// playback time
+	int audio_count;
+	unsigned short audio_lang[DDVD_MAX_AUDIO];	// language in 2 letter iso code, "--" if not given
+	int audio_type[DDVD_MAX_AUDIO];				// see audio type enum
+	int spu_count;
+	unsigned short spu_lang[DDVD_MAX_SPU];
+};
+
+struct ddvd_disc_info {
+	char title_string[96];			// as the disc gives it, may be empty
+	int titles;
+	struct ddvd_title_info title[DDVD_MAX_TITLES];	// title n is title[n - 1]
+};
+
+#define DDVD_STATS_BUCKETS 32
+
+struct ddvd_stage_stats {
+	unsigned long long count;		// number of calls
+	unsigned long long total_ns;	// time spent in all calls
+	unsigned long long max_ns;		// longest call
+	unsigned long long hist[DDVD_STATS_BUCKETS];	// hist[i] counts the calls that took 2^i to 2^(i+1)-1 ns,
+									// the last bucket also the longer ones
+};
+
+struct ddvd_stats {
+	struct ddvd_stage_stats stage[DDVD_STAGE_MAX];	// see stats stages enum
+	unsigned long long bytes[DDVD_DEV_MAX];		// bytes written per output device
+	unsigned long long ioctls[DDVD_DEV_MAX];	// decoder control calls per output device
+	unsigned long long messages;				// messages sent to the message pipe
+};
+
+#endif
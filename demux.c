@@ -0,0 +1,152 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "demux.h"
+
+struct demux_entry {
+	uint8_t type;
+	uint8_t base;			// first id of the range, index = id - base
+};
+
+#define RANGE(first, last, t) [first ... last] = { t, first }
+
+static const struct demux_entry demux_stream[256] = {
+	RANGE(0xC0, 0xC7, DDVD_DEMUX_MPEG),
+	RANGE(0xE0, 0xEF, DDVD_DEMUX_VIDEO),
+};
+
+// substreams of private stream 1 (0xBD)
+static const struct demux_entry demux_substream[256] = {
+	RANGE(0x20, 0x3F, DDVD_DEMUX_SPU),
+	RANGE(0x80, 0x87, DDVD_DEMUX_AC3),
+	RANGE(0x88, 0x8F, DDVD_DEMUX_DTS),
+	RANGE(0xA0, 0xA7, DDVD_DEMUX_LPCM),
+};
+
+#undef RANGE
+
+int ddvd_demux_parse(const uint8_t *block, int len, struct ddvd_pes *pes)
+{
+	const uint8_t *p = block + DDVD_PACK_HEADER;
+	const struct demux_entry *e;
+	int id;
+
+	pes->type = DDVD_DEMUX_OTHER;
+	pes->index = 0;
+	pes->substream = -1;
+	pes->has_pts = 0;
+	pes->pts = 0;
+	if (len < DDVD_PACK_HEADER + 9 || p[0] != 0 || p[1] != 0 || p[2] != 1) {
+		pes->stream_id = -1;
+		pes->pes_len = pes->header_len = pes->payload = pes->payload_len = 0;
+		return pes->type;
+	}
+
+	id = p[3];
+	pes->stream_id = id;
+	pes->pes_len = ((p[4] << 8) | p[5]) + 6;
+	pes->header_len = 9 + p[8];
+	pes->payload = DDVD_PACK_HEADER + pes->header_len;
+	pes->payload_len = pes->pes_len - pes->header_len;
+	if (pes->payload >= len || pes->payload_len <= 0)
+		return pes->type;
+
+	e = &demux_stream[id];
+	if (id == 0xBD) {
+		pes->substream = block[pes->payload];
+		e = &demux_substream[pes->substream];
+		pes->payload++;
+		pes->payload_len--;
+	}
+	if (e->type == DDVD_DEMUX_OTHER)
+		return pes->type;
+
+	pes->type = e->type;
+	pes->index = (id == 0xBD ? pes->substream : id) - e->base;
+	if (p[7] & 0x80) {
+		pes->has_pts = 1;
+		pes->pts = (unsigned long long)((p[9] >> 1) & 7) << 30;
+		pes->pts |= p[10] << 22;
+		pes->pts |= (p[11] >> 1) << 15;
+		pes->pts |= p[12] << 7;
+		pes->pts |= p[13] >> 1;
+	}
+	return pes->type;
+}
+
+// the byte after a code is read by the caller, so it has to be in the range as well
+static int start_codes_scalar(const uint8_t *buf, int p, int end, uint16_t *codes, int n, int max)
+{
+	while (p + 3 < end && n < max) {
+		if (buf[p + 2] > 1)
+			p += 3;
+		else if (buf[p + 2] == 0)
+			p++;
+		else {
+			if (buf[p] == 0 && buf[p + 1] == 0)
+				codes[n++] = p;
+			p += 3;
+		}
+	}
+	return n;
+}
+
+int ddvd_demux_start_codes(const uint8_t *buf, int start, int end, uint16_t *codes, int max)
+{
+	int p = start, n = 0;
+
+#if defined(__SSE2__)
+	// compare 16 positions at once, 00 00 01 at p, p + 1 and p + 2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+	for (; p + 18 < end && n < max; p += 16) {
+		__m128i m = _mm_and_si128(
+			_mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(buf + p)), zero),
+				_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(buf + p + 1)), zero)),
+			_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(buf + p + 2)), one));
+		unsigned int bits = _mm_movemask_epi8(m);
+		while (bits && n < max) {
+			codes[n++] = p + __builtin_ctz(bits);
+			bits &= bits - 1;
+		}
+	}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	// find the 16 byte pieces with a start code, the few hits are located by the scalar scan
+	const uint8x16_t zero = vdupq_n_u8(0);
+	const uint8x16_t one = vdupq_n_u8(1);
+	for (; p + 18 < end && n < max; p += 16) {
+		uint8x16_t m = vandq_u8(vandq_u8(vceqq_u8(vld1q_u8(buf + p), zero), vceqq_u8(vld1q_u8(buf + p + 1), zero)),
+			vceqq_u8(vld1q_u8(buf + p + 2), one));
+		uint64x2_t m64 = vreinterpretq_u64_u8(m);
+		if (vgetq_lane_u64(m64, 0) | vgetq_lane_u64(m64, 1))
+			n = start_codes_scalar(buf, p, p + 19, codes, n, max);
+	}
+#endif
+	return start_codes_scalar(buf, p, end, codes, n, max);
+}
@@ -0,0 +1,74 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __DEMUX_H__
+#define __DEMUX_H__
+
+#include <stdint.h>
+
+/*
+ * demultiplexer of the 2048 byte program stream packs of a DVD
+ *
+ * Every pack holds one PES packet behind the 14 byte pack header. ddvd_demux_parse reads its
+ * header once and looks the stream id (and for private stream 1 the substream id in front of
+ * the payload) up in a table, the player then only switches on the type. All positions are
+ * offsets into the pack so they stay valid when the pack is copied to be patched.
+ */
+
+enum ddvd_demux_type {
+	DDVD_DEMUX_OTHER,		// navigation, padding or anything the player does not use
+	DDVD_DEMUX_VIDEO,
+	DDVD_DEMUX_MPEG,
+	DDVD_DEMUX_AC3,
+	DDVD_DEMUX_DTS,
+	DDVD_DEMUX_LPCM,
+	DDVD_DEMUX_SPU,
+	DDVD_DEMUX_TYPES
+};
+
+#define DDVD_PACK_HEADER	14
+
+struct ddvd_pes {
+	int type;				// enum ddvd_demux_type
+	int index;				// audio or subpicture stream number
+	int stream_id;
+	int substream;			// substream id of private stream 1, -1 for other streams
+	int pes_len;			// whole PES packet incl. its 6 byte start code and length
+	int header_len;			// PES header incl. the 9 fixed bytes
+	int payload;			// offset of the payload (behind the substream id) in the pack
+	int payload_len;
+	int has_pts;
+	unsigned long long pts;	// 33 bit, 90kHz
+};
+
+// parse the PES header of the pack block of len bytes, returns pes->type
+int ddvd_demux_parse(const uint8_t *block, int len, struct ddvd_pes *pes);
+
+// a start code takes at least 3 bytes, so this many fit in a pack
+#define DDVD_MAX_START_CODES	(2048 / 3 + 1)
+
+// offsets of the mpeg start codes (00 00 01 xx) in buf that lie completely in start..end - 1,
+// at most max of them are stored in codes, returns their number
+int ddvd_demux_start_codes(const uint8_t *buf, int start, int end, uint16_t *codes, int max);
+
+#endif
@@ -0,0 +1,220 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include "loop.h"
+#include "debug.h"
+
+#ifdef DDVD_LOOP_EPOLL
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#endif
+
+#define LOOP_TAG_KEY	(-1)	// epoll data of the fds that are no device
+#define LOOP_TAG_WAKE	(-2)
+#define LOOP_TAG_TIMER	(-3)
+
+static void loop_drain(int fd)
+{
+	uint8_t buf[64];
+
+	while (read(fd, buf, sizeof(buf)) > 0)
+		;
+}
+
+#ifdef DDVD_LOOP_EPOLL
+static int loop_add(struct ddvd_loop *loop, int fd, uint32_t events, int tag)
+{
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = events;
+	ev.data.u32 = tag;
+	return epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+#endif
+
+int ddvd_loop_init(struct ddvd_loop *loop, int key_fd)
+{
+	int i;
+
+	memset(loop, 0, sizeof(struct ddvd_loop));
+	loop->key_fd = key_fd;
+	loop->epfd = loop->timerfd = loop->wake_fd[0] = loop->wake_fd[1] = -1;
+	for (i = 0; i < DDVD_DEV_MAX; i++)
+		loop->out_fd[i] = -1;
+
+#ifdef DDVD_LOOP_EPOLL
+	loop->wake_fd[0] = loop->wake_fd[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	loop->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (loop->wake_fd[0] == -1 || loop->timerfd == -1 || loop->epfd == -1) {
+		Perror("event loop");
+		goto err;
+	}
+	if (loop_add(loop, key_fd, EPOLLIN | EPOLLPRI, LOOP_TAG_KEY) < 0 ||
+		loop_add(loop, loop->wake_fd[0], EPOLLIN, LOOP_TAG_WAKE) < 0 ||
+		loop_add(loop, loop->timerfd, EPOLLIN, LOOP_TAG_TIMER) < 0) {
+		Perror("epoll_ctl");
+		goto err;
+	}
+#else
+	if (pipe(loop->wake_fd) < 0) {
+		Perror("event loop");
+		loop->wake_fd[0] = loop->wake_fd[1] = -1;
+		goto err;
+	}
+	fcntl(loop->wake_fd[0], F_SETFL, O_NONBLOCK);
+	fcntl(loop->wake_fd[1], F_SETFL, O_NONBLOCK);
+#endif
+	loop->running = 1;
+	return 0;
+
+err:
+	loop->running = 1;
+	ddvd_loop_close(loop);
+	return -1;
+}
+
+void ddvd_loop_close(struct ddvd_loop *loop)
+{
+	if (!loop->running)
+		return;
+
+	if (loop->epfd != -1)
+		close(loop->epfd);
+	if (loop->timerfd != -1)
+		close(loop->timerfd);
+	if (loop->wake_fd[1] != -1 && loop->wake_fd[1] != loop->wake_fd[0])
+		close(loop->wake_fd[1]);
+	if (loop->wake_fd[0] != -1)
+		close(loop->wake_fd[0]);
+	loop->epfd = loop->timerfd = loop->wake_fd[0] = loop->wake_fd[1] = -1;
+	loop->running = 0;
+}
+
+void ddvd_loop_wake(struct ddvd_loop *loop)
+{
+	uint64_t one = 1;	// eventfd takes 8 bytes, a pipe does not care
+
+	if (write(loop->wake_fd[1], &one, sizeof(one)) < 0 && errno != EAGAIN)
+		Perror("wake event loop");
+}
+
+#ifdef DDVD_LOOP_EPOLL
+int ddvd_loop_wait(struct ddvd_loop *loop, struct ddvd_sink *sink, int timeout_ms)
+{
+	struct epoll_event ev[4 + DDVD_DEV_MAX];
+	struct itimerspec its;
+	int i, n, ret = 0;
+
+	// devices only wake us while they hold pending output, writable they always are otherwise
+	for (i = 0; i < DDVD_DEV_MAX; i++) {
+		int fd = sink->pend_len[i] ? sink->write_fd[i] : -1;
+		if (fd == loop->out_fd[i])
+			continue;
+		if (loop->out_fd[i] != -1)
+			epoll_ctl(loop->epfd, EPOLL_CTL_DEL, loop->out_fd[i], NULL);
+		loop->out_fd[i] = -1;
+		if (fd != -1) {
+			if (loop_add(loop, fd, EPOLLOUT, i) < 0)
+				timeout_ms = 0;	// no pollable device (a plain file), it takes data anyway
+			else
+				loop->out_fd[i] = fd;
+		}
+	}
+
+	memset(&its, 0, sizeof(its));
+	if (timeout_ms > 0) {
+		its.it_value.tv_sec = timeout_ms / 1000;
+		its.it_value.tv_nsec = (timeout_ms % 1000) * 1000000;
+		timerfd_settime(loop->timerfd, 0, &its, NULL);
+	}
+
+	n = epoll_wait(loop->epfd, ev, sizeof(ev) / sizeof(ev[0]), timeout_ms == 0 ? 0 : -1);
+	if (n < 0 && errno != EINTR)
+		Perror("epoll_wait");
+	for (i = 0; i < n; i++) {
+		switch ((int)ev[i].data.u32) {
+			case LOOP_TAG_KEY:
+				ret |= DDVD_LOOP_KEY;
+				break;
+			case LOOP_TAG_WAKE:
+				loop_drain(loop->wake_fd[0]);
+				ret |= DDVD_LOOP_WAKE;
+				break;
+			case LOOP_TAG_TIMER:
+				ret |= DDVD_LOOP_TIMER;
+				break;
+			default:
+				ret |= DDVD_LOOP_OUTPUT;
+				break;
+		}
+	}
+
+	if (timeout_ms > 0) {	// disarm and forget an expiry we did not look at
+		memset(&its, 0, sizeof(its));
+		timerfd_settime(loop->timerfd, 0, &its, NULL);
+		loop_drain(loop->timerfd);
+	}
+	if (!n)
+		ret |= DDVD_LOOP_TIMER;
+	return ret;
+}
+#else
+int ddvd_loop_wait(struct ddvd_loop *loop, struct ddvd_sink *sink, int timeout_ms)
+{
+	struct pollfd pfd[2 + DDVD_DEV_MAX];
+	int n, ret = 0;
+
+	pfd[0].fd = loop->key_fd;
+	pfd[0].events = POLLIN | POLLPRI;
+	pfd[1].fd = loop->wake_fd[0];
+	pfd[1].events = POLLIN;
+	pfd[0].revents = pfd[1].revents = 0;
+	n = 2 + ddvd_sink_pollfds(sink, pfd + 2, DDVD_DEV_MAX);
+
+	n = poll(pfd, n, timeout_ms);
+	if (n < 0 && errno != EINTR)
+		Perror("poll");
+	if (n == 0)
+		return DDVD_LOOP_TIMER;
+	if (n < 0)
+		return 0;
+	if (pfd[0].revents)
+		ret |= DDVD_LOOP_KEY;
+	if (pfd[1].revents) {
+		loop_drain(loop->wake_fd[0]);
+		ret |= DDVD_LOOP_WAKE;
+	}
+	if (n > !!pfd[0].revents + !!pfd[1].revents)
+		ret |= DDVD_LOOP_OUTPUT;
+	return ret;
+}
+#endif
@@ -0,0 +1,69 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __LOOP_H__
+#define __LOOP_H__
+
+#include "libdreamdvd_config.h"
+
+#include "sink.h"
+
+/*
+ * event loop of the player, sleeps until a key, the reader, a decoder taking data again or the
+ * next timer needs the player
+ *
+ * epoll watches the key pipe, an eventfd other threads wake the loop with, a timerfd armed for
+ * the nearest timer and the decoder devices with pending output. Without epoll, timerfd and
+ * eventfd (old kernels) the same is done with poll, its timeout and a pipe.
+ */
+
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_SYS_TIMERFD_H) && defined(HAVE_SYS_EVENTFD_H)
+#define DDVD_LOOP_EPOLL 1
+#endif
+
+// what ended ddvd_loop_wait
+#define DDVD_LOOP_KEY		1
+#define DDVD_LOOP_WAKE		2
+#define DDVD_LOOP_TIMER		4
+#define DDVD_LOOP_OUTPUT	8
+
+struct ddvd_loop {
+	int key_fd;
+	int wake_fd[2];					// read and write end, the same eventfd or a pipe
+	int epfd;						// epoll only
+	int timerfd;
+	int out_fd[DDVD_DEV_MAX];		// device fds registered for EPOLLOUT, -1 none
+	int running;
+};
+
+int		ddvd_loop_init(struct ddvd_loop *loop, int key_fd);
+void	ddvd_loop_close(struct ddvd_loop *loop);
+
+// may be called from any thread
+void	ddvd_loop_wake(struct ddvd_loop *loop);
+
+// sleep at most timeout_ms (-1 no limit), wakes on keys, ddvd_loop_wake and the devices with
+// pending output in sink becoming writable, returns the DDVD_LOOP_* reasons
+int		ddvd_loop_wait(struct ddvd_loop *loop, struct ddvd_sink *sink, int timeout_ms);
+
+#endif
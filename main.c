@@ -29,12 +29,10 @@
 #include "main.h"
 #include "mpegaudioenc.h"
 #include "a52dec.h"
+#include "debug.h"
 #include "string.h"
 #include "errno.h"
 
-#define Debug(level, str, ...) (DebugLevel > level ? printf("LIBDVD: %07.3f: " str, (float) ddvd_get_time() / 1000.0, ##__VA_ARGS__) : 0)
-#define Perror(msg)            Debug(-1, "%s: %s", msg, strerror(errno))
-
 int DebugLevel = 1;
 
 /*
@@ -61,19 +59,18 @@ static ssize_t safe_write(int fd, const void *buf, size_t count)
 	return written;
 }
 
-
-static void write_string(const char *filename, const char *string)
+// a message to the host is its id followed by the message specific data
+static void send_message_data(struct ddvd *playerconfig, const void *buf, size_t count)
 {
-	FILE *f;
-
-	f = fopen(filename, "w");
-	if (f == NULL) {
-		Perror(filename);
-		return;
-	}
+	uint64_t start = ddvd_stats_clock();
+	safe_write(playerconfig->message_pipe[1], buf, count);
+	ddvd_stats_time(&playerconfig->stats, DDVD_STAGE_MESSAGE, start, NULL, 0);
+}
 
-	fputs(string, f);
-	fclose(f);
+static void send_message(struct ddvd *playerconfig, int msg)
+{
+	ddvd_stats_count(&playerconfig->stats, &playerconfig->stats.s.messages, 1);
+	send_message_data(playerconfig, &msg, sizeof(int));
 }
 
 
@@ -131,6 +128,8 @@ struct ddvd *ddvd_create(void)
 	}
 
 	memset(pconfig, 0, sizeof(struct ddvd));
+	pthread_mutex_init(&pconfig->probe_mutex, NULL);
+	pthread_cond_init(&pconfig->probe_cond, NULL);
 	for (i = 0; i < MAX_AUDIO; i++)
 		pconfig->audio_format[i] = -1;
 	pconfig->last_audio_id = -1;
@@ -145,6 +144,7 @@ struct ddvd *ddvd_create(void)
 	ddvd_set_dvd_path(pconfig, "/dev/cdroms/cdrom0");
 	ddvd_set_video(pconfig, DDVD_4_3, DDVD_LETTERBOX, DDVD_PAL);
 	ddvd_set_lfb(pconfig, NULL, 720, 576, 1, 720);
+	ddvd_set_sink(pconfig, DDVD_SINK_DVB, NULL);
 	struct ddvd_resume resume_info;
 	resume_info.title = resume_info.chapter = resume_info.block = resume_info.audio_id =
 						resume_info.audio_lock = resume_info.spu_id = resume_info.spu_lock = 0;
@@ -170,6 +170,22 @@ struct ddvd *ddvd_create(void)
 void ddvd_close(struct ddvd *pconfig)
 {
 	// Debug(2, "ddvd_close: cleanup dvd config struct\n");
+	// a probe ddvd_run did not take over
+	ddvd_probe_join(pconfig);
+	if (pconfig->css_started) {
+		__atomic_store_n(&pconfig->css_stop, 1, __ATOMIC_RELAXED);
+		pthread_join(pconfig->css_thread, NULL);
+	}
+	free(pconfig->css_path);
+	pthread_cond_destroy(&pconfig->probe_cond);
+	pthread_mutex_destroy(&pconfig->probe_mutex);
+	if (pconfig->dvdnav != NULL) {
+		ddvd_tmap_close(&pconfig->tmap);
+		dvdnav_close(pconfig->dvdnav);
+	}
+	ddvd_mpa_free(pconfig->mpa);
+	if (pconfig->probe_a52)
+		ddvd_close_liba52();
 	if (pconfig->message_pipe[0] != -1)
 		close(pconfig->message_pipe[0]);
 	if (pconfig->message_pipe[1] != -1)
@@ -180,6 +196,12 @@ void ddvd_close(struct ddvd *pconfig)
 		close(pconfig->key_pipe[1]);
 	if (pconfig->dvd_path != NULL)
 		free(pconfig->dvd_path);
+	if (pconfig->sink_path != NULL)
+		free(pconfig->sink_path);
+	if (pconfig->cache_dir != NULL)
+		free(pconfig->cache_dir);
+	if (pconfig->css_cache_dir != NULL)
+		free(pconfig->css_cache_dir);
 
 	free(pconfig);
 }
@@ -234,6 +256,48 @@ void ddvd_set_dvd_path(struct ddvd *pconfig, const char *path)
 	pconfig->dvd_path = strdup(path);
 }
 
+// set a directory to keep the seek index of played discs in, NULL (the default) keeps nothing
+void ddvd_set_cache_dir(struct ddvd *pconfig, const char *dir)
+{
+	if (pconfig->cache_dir != NULL)
+		free(pconfig->cache_dir);
+
+	pconfig->cache_dir = dir ? strdup(dir) : NULL;
+}
+
+// set the directory libdvdcss keeps the title keys of scrambled discs in
+void ddvd_set_css_cache(struct ddvd *pconfig, const char *dir)
+{
+	if (pconfig->css_cache_dir != NULL)
+		free(pconfig->css_cache_dir);
+
+	pconfig->css_cache_dir = dir ? strdup(dir) : NULL;
+}
+
+// libdvdcss reads its key cache directory from the environment when the disc is opened
+static void ddvd_css_setup(struct ddvd *playerconfig)
+{
+	if (playerconfig->css_cache_dir != NULL && setenv("DVDCSS_CACHE", playerconfig->css_cache_dir, 1) < 0)
+		Perror("setenv DVDCSS_CACHE");
+}
+
+// set output backend
+void ddvd_set_sink(struct ddvd *pconfig, int sink, const char *path)
+{
+	if (pconfig->sink_path != NULL)
+		free(pconfig->sink_path);
+
+	pconfig->sink_type = sink;
+	pconfig->sink_path = path ? strdup(path) : NULL;
+}
+
+// set run mode
+void ddvd_set_run_mode(struct ddvd *pconfig, int mode, int title)
+{
+	pconfig->run_mode = mode;
+	pconfig->remux_title = title;
+}
+
 // set language
 void ddvd_set_language(struct ddvd *pconfig, const char lang[2])
 {
@@ -247,6 +311,18 @@ void ddvd_set_ac3thru(struct ddvd *pconfig, int ac3thru)
 	pconfig->ac3thru = ac3thru;
 }
 
+// write to the decoders without blocking the player
+void ddvd_set_nonblock_output(struct ddvd *pconfig, int nonblock)
+{
+	pconfig->nonblock_output = nonblock;
+}
+
+// play from the dvdnav read-ahead cache
+void ddvd_set_readahead(struct ddvd *pconfig, int readahead)
+{
+	pconfig->readahead = readahead;
+}
+
 // set video options
 void ddvd_set_video_ex(struct ddvd *pconfig, int aspect, int tv_mode, int tv_mode2, int tv_system)
 {
@@ -289,6 +365,13 @@ void ddvd_skip_seconds(struct ddvd *pconfig, int seconds)
 	ddvd_send_key(pconfig, seconds);
 }
 
+// jump to the given seconds from the beginning of the current title
+void ddvd_seek_abs(struct ddvd *pconfig, int seconds)
+{
+	ddvd_send_key(pconfig, DDVD_SEEK_ABS);
+	ddvd_send_key(pconfig, seconds);
+}
+
 // jump to beginning of given title
 void ddvd_set_title(struct ddvd *pconfig, int title)
 {
@@ -438,8 +521,8 @@ void ddvd_get_audio_byid(struct ddvd *pconfig, int audio_id, void *lang, void *t
 {
 	int audio_id_logical;
 	uint16_t audio_lang = 0xFFFF;
-	audio_id_logical = dvdnav_get_audio_logical_stream(dvdnav, audio_id);
-	audio_lang = dvdnav_audio_stream_to_lang(dvdnav, audio_id_logical);
+	audio_id_logical = dvdnav_get_audio_logical_stream(pconfig->dvdnav, audio_id);
+	audio_lang = dvdnav_audio_stream_to_lang(pconfig->dvdnav, audio_id_logical);
 	if (audio_lang == 0xFFFF)
 		audio_lang = 0x2D2D;
 	memcpy(lang, &audio_lang, sizeof(uint16_t));
@@ -485,6 +568,136 @@ void ddvd_get_title_string(struct ddvd *pconfig, char *title_string)
 	memcpy(title_string, pconfig->title_string, sizeof(pconfig->title_string));
 }
 
+// disc_info and the result are there, wake who waits for them
+static void ddvd_probe_finish(struct ddvd *pconfig, enum ddvd_result result)
+{
+	pthread_mutex_lock(&pconfig->probe_mutex);
+	pconfig->probe_result = result;
+	__atomic_store_n(&pconfig->probe_done, 1, __ATOMIC_RELEASE);
+	pthread_cond_broadcast(&pconfig->probe_cond);
+	pthread_mutex_unlock(&pconfig->probe_mutex);
+	send_message(pconfig, DDVD_DISC_INFO);
+}
+
+// open the disc and do the setup of ddvd_run that does not need the decoder
+static void *ddvd_probe_thread(void *arg)
+{
+	struct ddvd *pconfig = arg;
+	struct ddvd_disc_info *info = &pconfig->disc_info;
+	const char *title_string = NULL;
+	int i;
+
+	pconfig->probe_a52 = ddvd_load_liba52();
+	if (pconfig->mpa == NULL)
+		pconfig->mpa = ddvd_mpa_init(48000, 192000);	// builds the encoder tables as well
+
+	Debug(1, "Probing DVD...%s\n", pconfig->dvd_path);
+	if (dvdnav_open(&pconfig->dvdnav, pconfig->dvd_path) != DVDNAV_STATUS_OK) {
+		Debug(1, "Error on dvdnav_open\n");
+		pconfig->dvdnav = NULL;
+		ddvd_probe_finish(pconfig, DDVD_FAIL_OPEN);
+		return NULL;
+	}
+	ddvd_tmap_open(&pconfig->tmap, pconfig->dvd_path, pconfig->cache_dir);
+
+	memset(info, 0, sizeof(struct ddvd_disc_info));
+	if (dvdnav_get_title_string(pconfig->dvdnav, &title_string) == DVDNAV_STATUS_OK && title_string != NULL)
+		strncpy(info->title_string, title_string, sizeof(info->title_string) - 1);
+	if (ddvd_probe_titles(&pconfig->tmap, pconfig->dvd_path, info) < 0) {
+		// no streams without the IFO files, dvdnav still knows the titles
+		dvdnav_get_number_of_titles(pconfig->dvdnav, &info->titles);
+		if (info->titles > DDVD_MAX_TITLES)
+			info->titles = DDVD_MAX_TITLES;
+		for (i = 0; i < info->titles; i++)
+			dvdnav_get_number_of_parts(pconfig->dvdnav, i + 1, &info->title[i].chapters);
+	}
+
+	ddvd_probe_finish(pconfig, DDVD_OK);
+	return NULL;
+}
+
+// get the keys while the frontend shows the disc info or the player already runs
+static void *ddvd_css_thread(void *arg)
+{
+	struct ddvd *pconfig = arg;
+
+	ddvd_probe_wait(pconfig);	// the disc info goes first, the drive does one thing at a time
+	if (pconfig->probe_result == DDVD_OK)
+		ddvd_probe_css_keys(pconfig->css_path, &pconfig->css_stop);
+	return NULL;
+}
+
+enum ddvd_result ddvd_probe(struct ddvd *pconfig)
+{
+	if (pconfig->probe_started || pconfig->dvdnav != NULL)
+		return DDVD_BUSY;
+
+	// a key fetch of an earlier probe of another disc is stopped, for the same disc it goes on
+	if (pconfig->css_started && (pconfig->css_path == NULL || strcmp(pconfig->css_path, pconfig->dvd_path))) {
+		__atomic_store_n(&pconfig->css_stop, 1, __ATOMIC_RELAXED);
+		pthread_join(pconfig->css_thread, NULL);
+		pconfig->css_started = 0;
+		pconfig->css_stop = 0;
+	}
+
+	// the environment is shared by all threads, set it here and not in the probe thread
+	ddvd_css_setup(pconfig);
+
+	pconfig->probe_done = 0;
+	pconfig->probe_result = DDVD_FAIL_OPEN;
+	if (pthread_create(&pconfig->probe_thread, NULL, ddvd_probe_thread, pconfig) != 0) {
+		Perror("pthread_create");
+		return DDVD_NOMEM;
+	}
+	pconfig->probe_started = 1;
+
+	if (pconfig->css_cache_dir != NULL && !pconfig->css_started) {
+		free(pconfig->css_path);
+		pconfig->css_path = strdup(pconfig->dvd_path);
+		if (pconfig->css_path != NULL && pthread_create(&pconfig->css_thread, NULL, ddvd_css_thread, pconfig) == 0)
+			pconfig->css_started = 1;
+		else
+			Perror("pthread_create css keys");
+	}
+	return DDVD_OK;
+}
+
+// wait until the probe has the disc info, the key fetch may still go on
+static void ddvd_probe_wait(struct ddvd *pconfig)
+{
+	pthread_mutex_lock(&pconfig->probe_mutex);
+	while (!pconfig->probe_done)
+		pthread_cond_wait(&pconfig->probe_cond, &pconfig->probe_mutex);
+	pthread_mutex_unlock(&pconfig->probe_mutex);
+}
+
+// take over the probe, what it prepared stays in the handle
+static void ddvd_probe_join(struct ddvd *pconfig)
+{
+	if (pconfig->probe_started) {
+		ddvd_probe_wait(pconfig);
+		pthread_join(pconfig->probe_thread, NULL);	// only the message is left to send
+		pconfig->probe_started = 0;
+	}
+}
+
+// get the disc info found by ddvd_probe
+enum ddvd_result ddvd_get_disc_info(struct ddvd *pconfig, struct ddvd_disc_info *info, int blocked)
+{
+	int done = __atomic_load_n(&pconfig->probe_done, __ATOMIC_ACQUIRE);
+
+	if (!pconfig->probe_started && !done)
+		return DDVD_INVAL;
+	if (!done) {
+		if (!blocked)
+			return DDVD_BUSY;
+		ddvd_probe_wait(pconfig);
+	}
+	if (pconfig->probe_result == DDVD_OK)
+		memcpy(info, &pconfig->disc_info, sizeof(struct ddvd_disc_info));
+	return pconfig->probe_result;
+}
+
 // get actual position for resuming
 void ddvd_get_resume_pos(struct ddvd *pconfig, struct ddvd_resume *resume_info)
 {
@@ -514,52 +727,58 @@ void ddvd_get_last_framerate(struct ddvd *pconfig, int *framerate)
 	*framerate = pconfig->last_framerate.framerate;
 }
 
-static int calc_x_scale_offset(int dvd_aspect, int tv_mode, int tv_mode2, int tv_aspect)
+// get the performance counters of the player
+void ddvd_get_stats(struct ddvd *pconfig, struct ddvd_stats *stats)
+{
+	ddvd_stats_read(&pconfig->stats, stats);
+}
+
+static int calc_x_scale_offset(struct ddvd *playerconfig, int dvd_aspect, int tv_mode, int tv_mode2, int tv_aspect)
 {
 	int x_offset=0;
 
 	if (dvd_aspect == 0 && tv_mode == DDVD_PAN_SCAN) {
 		switch (tv_aspect) {
 			case DDVD_16_10:
-				x_offset = (ddvd_screeninfo_xres - ddvd_screeninfo_xres * 12 / 15) / 2;  // correct 16:10 (broadcom 15:9) panscan (pillarbox) overlay
+				x_offset = (playerconfig->screeninfo_xres - playerconfig->screeninfo_xres * 12 / 15) / 2;  // correct 16:10 (broadcom 15:9) panscan (pillarbox) overlay
 				break;
 			case DDVD_16_9:
-				x_offset = (ddvd_screeninfo_xres - ddvd_screeninfo_xres * 3 / 4) / 2; // correct 16:9 panscan (pillarbox) overlay
+				x_offset = (playerconfig->screeninfo_xres - playerconfig->screeninfo_xres * 3 / 4) / 2; // correct 16:9 panscan (pillarbox) overlay
 			default:
 				break;
 		}
 	}
 
 	if (dvd_aspect >= 2 && tv_aspect == DDVD_4_3 && tv_mode == DDVD_PAN_SCAN)
-		x_offset = -(ddvd_screeninfo_xres * 4 / 3 - ddvd_screeninfo_xres) / 2;
+		x_offset = -(playerconfig->screeninfo_xres * 4 / 3 - playerconfig->screeninfo_xres) / 2;
 
 	if (dvd_aspect >= 2 && tv_aspect == DDVD_16_10 && tv_mode2 == DDVD_PAN_SCAN)
-		x_offset = -(ddvd_screeninfo_xres * 16 / 15 - ddvd_screeninfo_xres) / 2;
+		x_offset = -(playerconfig->screeninfo_xres * 16 / 15 - playerconfig->screeninfo_xres) / 2;
 
 	return x_offset;
 }
 
-static int calc_y_scale_offset(int dvd_aspect, int tv_mode, int tv_mode2, int tv_aspect)
+static int calc_y_scale_offset(struct ddvd *playerconfig, int dvd_aspect, int tv_mode, int tv_mode2, int tv_aspect)
 {
 	int y_offset = 0;
 
 	if (dvd_aspect == 0 && tv_mode == DDVD_LETTERBOX) {
 		switch (tv_aspect) {
 			case DDVD_16_10:
-				y_offset = (ddvd_screeninfo_yres * 15 / 12 - ddvd_screeninfo_yres) / 2; // correct 16:10 (broacom 15:9) letterbox overlay
+				y_offset = (playerconfig->screeninfo_yres * 15 / 12 - playerconfig->screeninfo_yres) / 2; // correct 16:10 (broacom 15:9) letterbox overlay
 				break;
 			case DDVD_16_9:
-				y_offset = (ddvd_screeninfo_yres * 4 / 3 - ddvd_screeninfo_yres) / 2; // correct 16:9 letterbox overlay
+				y_offset = (playerconfig->screeninfo_yres * 4 / 3 - playerconfig->screeninfo_yres) / 2; // correct 16:9 letterbox overlay
 			default:
 				break;
 		}
 	}
 
 	if (dvd_aspect >= 2 && tv_aspect == DDVD_4_3 && tv_mode == DDVD_LETTERBOX)
-		y_offset = -(ddvd_screeninfo_yres - ddvd_screeninfo_yres * 3 / 4) / 2;
+		y_offset = -(playerconfig->screeninfo_yres - playerconfig->screeninfo_yres * 3 / 4) / 2;
 
 	if (dvd_aspect >= 2 && tv_aspect == DDVD_16_10 && tv_mode2 == DDVD_LETTERBOX)
-		y_offset = -(ddvd_screeninfo_yres - ddvd_screeninfo_yres * 15 / 16) / 2;
+		y_offset = -(playerconfig->screeninfo_yres - playerconfig->screeninfo_yres * 15 / 16) / 2;
 
 	return y_offset;
 }
@@ -578,10 +797,10 @@ static int readMpegProc(char *str, int decoder)
 	return val;
 }
 
-static int readApiSize(int fd, int *xres, int *yres, int *aspect)
+static int readApiSize(struct ddvd_sink *sink, int *xres, int *yres, int *aspect)
 {
 	video_size_t size;
-	if (!ioctl(fd, VIDEO_GET_SIZE, &size)) {
+	if (!ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_GET_SIZE, &size)) {
 		*xres = size.w;
 		*yres = size.h;
 		*aspect = size.aspect_ratio == 0 ? 2 : 3;  // convert dvb api to etsi
@@ -590,10 +809,10 @@ static int readApiSize(int fd, int *xres, int *yres, int *aspect)
 	return -1;
 }
 
-static int readApiFrameRate(int fd, int *framerate)
+static int readApiFrameRate(struct ddvd_sink *sink, int *framerate)
 {
 	unsigned int frate;
-	if (!ioctl(fd, VIDEO_GET_FRAME_RATE, &frate)) {
+	if (!ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_GET_FRAME_RATE, &frate)) {
 		*framerate = frate;
 		return 0;
 	}
@@ -618,25 +837,33 @@ enum ddvd_result ddvd_run(struct ddvd *playerconfig)
 	int first_vts_change = 1;
 	int next_cell_change = 0;
 	int ddvd_have_ntsc = -1;
+	// remuxing runs without menus, stills and real time pacing
+	int remux = playerconfig->run_mode == DDVD_RUN_REMUX;
+	int remux_part = 0;
 
-	ddvd_screeninfo_xres = playerconfig->xres;
-	ddvd_screeninfo_yres = playerconfig->yres;
-	ddvd_screeninfo_stride = playerconfig->stride;
+	playerconfig->screeninfo_xres = playerconfig->xres;
+	playerconfig->screeninfo_yres = playerconfig->yres;
+	playerconfig->screeninfo_stride = playerconfig->stride;
 	int ddvd_screeninfo_bypp = playerconfig->bypp;
-	int message_pipe = playerconfig->message_pipe[1];
 	int key_pipe = playerconfig->key_pipe[0];
 	unsigned char *p_lfb = playerconfig->lfb;
 	enum ddvd_result res = DDVD_OK;
 	int msg;
+	uint64_t stage_start;			// for the stats of the stage that is running
+	// take over what ddvd_probe has prepared
+	ddvd_probe_join(playerconfig);
+	int probed = playerconfig->dvdnav != NULL;
 	// try to load liba52.so.0 for softdecoding
-	int have_liba52 = ddvd_load_liba52();
+	int have_liba52 = playerconfig->probe_a52 ? 1 : ddvd_load_liba52();
+	playerconfig->probe_a52 = 0;
 	int audio_lock = 0;
 	int spu_lock = 0;
+	int lpcm_mode = -1;	// audio bypass mode for lpcm, detected on the first lpcm packet
 
 	unsigned long long vpts = 0, apts = 0, spts = 0, pts = 0;
 	unsigned long long steppts = 0; // target pts for STEP mode
-	ddvd_lbb_changed = 0;
-	ddvd_clear_screen = 0;
+	playerconfig->lbb_changed = 0;
+	playerconfig->clear_screen = 0;
 	int have_highlight = 0;
 	int ddvd_wait_highlight = 0;
 	const char *dvd_titlestring = NULL;
@@ -649,20 +876,20 @@ enum ddvd_result ddvd_run(struct ddvd *playerconfig)
 	// for hd skins we use nearest neighbor resize because upscaling to hd is too slow with bicubic resize
 	// for bypp != 0 resize function is set in spu/highlight code
 	if (ddvd_screeninfo_bypp == 1)
-		ddvd_resize_pixmap = &ddvd_resize_pixmap_1bpp;
+		playerconfig->resize_pixmap = &ddvd_resize_pixmap_1bpp;
 
 	uint8_t *last_iframe = NULL;
 
 	// init backbuffer (SPU)
-	ddvd_lbb = malloc(720 * 576);	// the spu backbuffer is always max DVD PAL 720x576 pixel (NTSC 720x480)
-	if (ddvd_lbb == NULL) {
+	playerconfig->lbb = malloc(720 * 576);	// the spu backbuffer is always max DVD PAL 720x576 pixel (NTSC 720x480)
+	if (playerconfig->lbb == NULL) {
 		Perror("SPU decode buffer <mem allocation failed>");
 		res = DDVD_NOMEM;
 		goto err_malloc;
 	}
 
-	ddvd_lbb2 = malloc(ddvd_screeninfo_xres * ddvd_screeninfo_yres * ddvd_screeninfo_bypp);
-	if (ddvd_lbb2 == NULL) {
+	playerconfig->lbb2 = malloc(playerconfig->screeninfo_xres * playerconfig->screeninfo_yres * ddvd_screeninfo_bypp);
+	if (playerconfig->lbb2 == NULL) {
 		Perror("SPU to screen buffer <mem allocation failed>");
 		res = DDVD_NOMEM;
 		goto err_malloc;
@@ -670,6 +897,8 @@ enum ddvd_result ddvd_run(struct ddvd *playerconfig)
 
 #define SPU_BUFLEN   (2 * (128 * 1024))
 	unsigned long long spu_backpts[NUM_SPU_BACKBUFFER];
+	int64_t spu_backtime[NUM_SPU_BACKBUFFER];	// on the timeline
+	int64_t spu_time = 0;
 	unsigned char *ddvd_spu[NUM_SPU_BACKBUFFER];
 	pci_t *ddvd_pci[NUM_SPU_BACKBUFFER];
 	{   int  i;
@@ -698,118 +927,64 @@ enum ddvd_result ddvd_run(struct ddvd *playerconfig)
 
 	struct ddvd_resize_return blit_area;
 
-	memset(p_lfb, 0, ddvd_screeninfo_stride * ddvd_screeninfo_yres);	//clear screen
+	memset(p_lfb, 0, playerconfig->screeninfo_stride * playerconfig->screeninfo_yres);	//clear screen
 	blit_area.x_start = blit_area.y_start = 0;
-	blit_area.x_end = ddvd_screeninfo_xres - 1;
-	blit_area.y_end = ddvd_screeninfo_yres - 1;
+	blit_area.x_end = playerconfig->screeninfo_xres - 1;
+	blit_area.y_end = playerconfig->screeninfo_yres - 1;
 	blit_area.x_offset = 0;
 	blit_area.y_offset = 0;
-	blit_area.width = ddvd_screeninfo_xres;
-	blit_area.height = ddvd_screeninfo_yres;
+	blit_area.width = playerconfig->screeninfo_xres;
+	blit_area.height = playerconfig->screeninfo_yres;
 
 	msg = DDVD_SCREEN_UPDATE;
-	safe_write(message_pipe, &msg, sizeof(int));
-	safe_write(message_pipe, &blit_area, sizeof(struct ddvd_resize_return));
-
-	Debug(1, "Opening output...\n");
-
-#if CONFIG_API_VERSION == 1
-	ddvd_output_fd = open("/dev/video", O_WRONLY);
-	if (ddvd_output_fd == -1) {
-		Perror("/dev/video");
-		res = DDVD_BUSY;
-		goto err_open_output_fd;
-	}
-
-	ddvd_fdvideo = open("/dev/dvb/card0/video0", O_RDWR);
-	if (ddvd_fdvideo == -1) {
-		Perror("/dev/dvb/card0/video0");
-		res = DDVD_BUSY;
-		goto err_open_fdvideo;
-	}
-
-	ddvd_fdaudio = open("/dev/dvb/card0/audio0", O_RDWR);
-	if (ddvd_fdaudio == -1) {
-		Perror("/dev/dvb/card0/audio0");
-		res = DDVD_BUSY;
-		goto err_open_fdaudio;
-	}
-
-	ddvd_ac3_fd = open("/dev/sound/dsp1", O_RDWR);
-	if (ddvd_ac3_fd == -1) {
-		Perror("/dev/sound/dsp1");
-		res = DDVD_BUSY;
-		goto err_open_ac3_fd;
-	}
-
-	if (ioctl(ddvd_fdvideo, VIDEO_SELECT_SOURCE, VIDEO_SOURCE_MEMORY) < 0)
-		Perror("VIDEO_SELECT_SOURCE");
-	if (ioctl(ddvd_fdvideo, VIDEO_CLEAR_BUFFER) < 0)
-		Perror("VIDEO_CLEAR_BUFFER");
-	if (ioctl(ddvd_fdvideo, VIDEO_PLAY) < 0)
-		Perror("VIDEO_PLAY");
-
-	if (ioctl(ddvd_fdaudio, AUDIO_SELECT_SOURCE, AUDIO_SOURCE_MEMORY) < 0)
-		Perror("AUDIO_SELECT_SOURCE");
-	if (ioctl(ddvd_fdaudio, AUDIO_CLEAR_BUFFER) < 0)
-		Perror("AUDIO_CLEAR_BUFFER");
-	if (ioctl(ddvd_fdaudio, AUDIO_PLAY) < 0)
-		Perror("AUDIO_PLAY");
-
-#elif CONFIG_API_VERSION == 3
-	ddvd_output_fd = ddvd_fdvideo = open("/dev/dvb/adapter0/video0", O_RDWR);
-	if (ddvd_fdvideo == -1) {
-		Perror("/dev/dvb/adapter0/video0");
-		res = DDVD_BUSY;
-		goto err_open_fdvideo;
-	}
-
-	ddvd_ac3_fd = ddvd_fdaudio = open("/dev/dvb/adapter0/audio0", O_RDWR);
-	if (ddvd_fdaudio == -1) {
-		Perror("/dev/dvb/adapter0/audio0");
+	send_message(playerconfig, msg);
+	send_message_data(playerconfig, &blit_area, sizeof(struct ddvd_resize_return));
+
+	struct ddvd_sink *sink = &playerconfig->sink;
+	ddvd_sink_init(sink, playerconfig->sink_type, playerconfig->sink_path);
+	sink->stats = &playerconfig->stats;
+	sink->nonblock = playerconfig->nonblock_output;
+	if (ddvd_sink_open(sink) < 0) {
 		res = DDVD_BUSY;
-		goto err_open_ac3_fd;
+		goto err_open_output;
 	}
 
-	if (ioctl(ddvd_fdvideo, VIDEO_SELECT_SOURCE, VIDEO_SOURCE_MEMORY) < 0)
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_SELECT_SOURCE, VIDEO_SOURCE_MEMORY) < 0)
 		Perror("VIDEO_SELECT_SOURCE");
-	if (ioctl(ddvd_fdvideo, VIDEO_CLEAR_BUFFER) < 0)
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_CLEAR_BUFFER) < 0)
 		Perror("VIDEO_CLEAR_BUFFER");
-	if (ioctl(ddvd_fdvideo, VIDEO_SET_STREAMTYPE, 0) < 0)	// set mpeg2
+#if CONFIG_API_VERSION == 3
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_SET_STREAMTYPE, 0) < 0)	// set mpeg2
 		Perror("VIDEO_SET_STREAMTYPE");
-	if (ioctl(ddvd_fdvideo, VIDEO_PLAY) < 0)
+#endif
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_PLAY) < 0)
 		Perror("VIDEO_PLAY");
 
-	if (ioctl(ddvd_fdaudio, AUDIO_SELECT_SOURCE, AUDIO_SOURCE_MEMORY) < 0)
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_SELECT_SOURCE, AUDIO_SOURCE_MEMORY) < 0)
 		Perror("AUDIO_SELECT_SOURCE");
-	if (ioctl(ddvd_fdaudio, AUDIO_CLEAR_BUFFER) < 0)
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_CLEAR_BUFFER) < 0)
 		Perror("AUDIO_CLEAR_BUFFER");
-	if (ioctl(ddvd_fdaudio, AUDIO_PLAY) < 0)
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_PLAY) < 0)
 		Perror("AUDIO_PLAY");
-#else
-# error please define CONFIG_API_VERSION to be 1 or 3
-#endif
 
 	int i;
 // show startup screen
 #if SHOW_START_SCREEN == 1
+	if (!remux) {
 # if CONFIG_API_VERSION == 1
-	//that really sucks but there is no other way
-	for (i = 0; i < 10; i++)
-		safe_write(ddvd_output_fd, ddvd_startup_logo, sizeof(ddvd_startup_logo));
+		//that really sucks but there is no other way
+		for (i = 0; i < 10; i++)
+			ddvd_sink_write(sink, DDVD_DEV_VIDEO, ddvd_startup_logo, sizeof(ddvd_startup_logo));
 # else
-	unsigned char pes_header[] = { 0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x80, 0x00, 0x00 };
-	safe_write(ddvd_output_fd, pes_header, sizeof(pes_header));
-	safe_write(ddvd_output_fd, ddvd_startup_logo, sizeof(ddvd_startup_logo));
+		unsigned char pes_header[] = { 0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x80, 0x00, 0x00 };
+		ddvd_sink_write(sink, DDVD_DEV_VIDEO, pes_header, sizeof(pes_header));
+		ddvd_sink_write(sink, DDVD_DEV_VIDEO, ddvd_startup_logo, sizeof(ddvd_startup_logo));
 # endif
+	}
 #endif
 
 	int audio_type = DDVD_UNKNOWN;
 
-#if CONFIG_API_VERSION == 3
-	ddvd_set_pcr_offset();
-#endif
-
 	uint8_t mem[DVD_VIDEO_LB_LEN];
 	uint8_t *buf = mem;
 	int result, event, len;
@@ -821,13 +996,17 @@ enum ddvd_result ddvd_run(struct ddvd *playerconfig)
 	int ac3_len;
 	int16_t ac3_tmp[2048 * 6 * 6];
 
-	ddvd_mpa_init(48000, 192000);	//init MPA Encoder with 48kHz and 192k Bitrate
+	if (playerconfig->mpa == NULL)
+		playerconfig->mpa = ddvd_mpa_init(48000, 192000);	//init MPA Encoder with 48kHz and 192k Bitrate
+	if (playerconfig->mpa == NULL) {
+		Perror("MPA encoder <mem allocation failed>");
+		res = DDVD_NOMEM;
+		goto err_dvdnav_open;
+	}
 
 	int ac3thru = 1;
-	if (have_liba52) {
-		state = a52_init(0);	//init AC3 Decoder
+	if (have_liba52 && ddvd_a52_init(&playerconfig->a52))	//init AC3 Decoder
 		ac3thru = playerconfig->ac3thru;
-	}
 
 	char osdtext[512];
 	osdtext[0] = 0;
@@ -851,13 +1030,13 @@ enum ddvd_result ddvd_run(struct ddvd *playerconfig)
 	last_spu_return.x_start = last_spu_return.y_start = 0;
 	last_spu_return.x_end = last_spu_return.y_end = 0;
 
-	ddvd_trickmode = TOFF;
-	ddvd_trickspeed = 0;
+	playerconfig->trickmode = TOFF;
+	playerconfig->trickspeed = 0;
 
 	int rccode;
 	int ismute = 0;
 
-	if (ioctl(ddvd_fdaudio, AUDIO_SET_AV_SYNC, 1) < 0)
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_SET_AV_SYNC, 1) < 0)
 		Perror("AUDIO_SET_AV_SYNC");
 #if CONFIG_API_VERSION == 1
 	// set video system
@@ -879,67 +1058,75 @@ enum ddvd_result ddvd_run(struct ddvd *playerconfig)
 		struct ddvd_framerate_evt f_evt;
 		struct ddvd_progressive_evt p_evt;
 		int msg = DDVD_SIZE_CHANGED;
-		readApiSize(ddvd_fdvideo, &s_evt.width, &s_evt.height, &s_evt.aspect);
-		safe_write(message_pipe, &msg, sizeof(int));
-		safe_write(message_pipe, &s_evt, sizeof(s_evt));
+		readApiSize(sink, &s_evt.width, &s_evt.height, &s_evt.aspect);
+		send_message(playerconfig, msg);
+		send_message_data(playerconfig, &s_evt, sizeof(s_evt));
 
 		msg = DDVD_FRAMERATE_CHANGED;
-		readApiFrameRate(ddvd_fdvideo, &f_evt.framerate);
-		safe_write(message_pipe, &msg, sizeof(int));
-		safe_write(message_pipe, &f_evt, sizeof(f_evt));
+		readApiFrameRate(sink, &f_evt.framerate);
+		send_message(playerconfig, msg);
+		send_message_data(playerconfig, &f_evt, sizeof(f_evt));
 
 		msg = DDVD_PROGRESSIVE_CHANGED;
 		p_evt.progressive = readMpegProc("progressive", 0);
-		safe_write(message_pipe, &msg, sizeof(int));
-		safe_write(message_pipe, &p_evt, sizeof(p_evt));
+		send_message(playerconfig, msg);
+		send_message_data(playerconfig, &p_evt, sizeof(p_evt));
 	}
 #endif
 
 	/* open dvdnav handle */
 	Debug(1, "Opening DVD...%s\n", playerconfig->dvd_path);
-	if (dvdnav_open(&dvdnav, playerconfig->dvd_path) != DVDNAV_STATUS_OK) {
+	if (!probed)
+		ddvd_css_setup(playerconfig);
+	if (!probed && dvdnav_open(&playerconfig->dvdnav, playerconfig->dvd_path) != DVDNAV_STATUS_OK) {
 		Debug(1, "Error on dvdnav_open\n");
 		sprintf(osdtext, "Error: Cant open DVD Source: %s", playerconfig->dvd_path);
 		msg = DDVD_SHOWOSD_STRING;
-		safe_write(message_pipe, &msg, sizeof(int));
-		safe_write(message_pipe, &osdtext, sizeof(osdtext));
+		send_message(playerconfig, msg);
+		send_message_data(playerconfig, &osdtext, sizeof(osdtext));
 		res = DDVD_FAIL_OPEN;
+		playerconfig->dvdnav = NULL;
 		goto err_dvdnav_open;
 	}
 
-	/* set read ahead cache usage to no */
-	if (dvdnav_set_readahead_flag(dvdnav, 0) != DVDNAV_STATUS_OK) {
-		Debug(1, "Error on dvdnav_set_readahead_flag: %s\n", dvdnav_err_to_string(dvdnav));
+	// seek index of the titles, from the cache when the disc was played before
+	if (!probed)
+		ddvd_tmap_open(&playerconfig->tmap, playerconfig->dvd_path, playerconfig->cache_dir);
+
+	/* set read ahead cache usage to no, unless we read as fast as possible anyway or play
+	 * the blocks from the cache */
+	if (dvdnav_set_readahead_flag(playerconfig->dvdnav, remux || playerconfig->readahead) != DVDNAV_STATUS_OK) {
+		Debug(1, "Error on dvdnav_set_readahead_flag: %s\n", dvdnav_err_to_string(playerconfig->dvdnav));
 		res = DDVD_FAIL_PREFS;
 		goto err_dvdnav;
 	}
 
 	/* set the language */
-	if (dvdnav_menu_language_select(dvdnav, playerconfig->language) != DVDNAV_STATUS_OK ||
-		dvdnav_audio_language_select(dvdnav, playerconfig->language) != DVDNAV_STATUS_OK ||
-		dvdnav_spu_language_select(dvdnav, playerconfig->language) != DVDNAV_STATUS_OK) {
-		Debug(1, "Error on setting languages: %s\n", dvdnav_err_to_string(dvdnav));
+	if (dvdnav_menu_language_select(playerconfig->dvdnav, playerconfig->language) != DVDNAV_STATUS_OK ||
+		dvdnav_audio_language_select(playerconfig->dvdnav, playerconfig->language) != DVDNAV_STATUS_OK ||
+		dvdnav_spu_language_select(playerconfig->dvdnav, playerconfig->language) != DVDNAV_STATUS_OK) {
+		Debug(1, "Error on setting languages: %s\n", dvdnav_err_to_string(playerconfig->dvdnav));
 		res = DDVD_FAIL_PREFS;
 		goto err_dvdnav;
 	}
 
 	/* set the PGC positioning flag to have position information relatively to the
 	 * whole feature instead of just relatively to the current chapter */
-	if (dvdnav_set_PGC_positioning_flag(dvdnav, 1) != DVDNAV_STATUS_OK) {
-		Debug(1, "Error on dvdnav_set_PGC_positioning_flag: %s\n", dvdnav_err_to_string(dvdnav));
+	if (dvdnav_set_PGC_positioning_flag(playerconfig->dvdnav, 1) != DVDNAV_STATUS_OK) {
+		Debug(1, "Error on dvdnav_set_PGC_positioning_flag: %s\n", dvdnav_err_to_string(playerconfig->dvdnav));
 		res = DDVD_FAIL_PREFS;
 		goto err_dvdnav;
 	}
 
-	audio_id = dvdnav_get_active_audio_stream(dvdnav);
-	ddvd_playmode = PLAY;
+	audio_id = dvdnav_get_active_audio_stream(playerconfig->dvdnav);
+	playerconfig->playmode = PLAY;
 
 	dvdnav_highlight_event_t highlight_event;
 
-	ddvd_play_empty(FALSE);
+	ddvd_play_empty(playerconfig, FALSE);
 	ddvd_get_time();	//set timestamp
 
-	if (dvdnav_get_title_string(dvdnav, &dvd_titlestring) == DVDNAV_STATUS_OK)
+	if (dvdnav_get_title_string(playerconfig->dvdnav, &dvd_titlestring) == DVDNAV_STATUS_OK)
 		strncpy(playerconfig->title_string, dvd_titlestring, 96);
 	if (strlen(playerconfig->title_string) == 0) {
 		// DVD has no title set,, use dvd_path info
@@ -957,18 +1144,58 @@ enum ddvd_result ddvd_run(struct ddvd *playerconfig)
 	Debug(1, "DVD Title: %s  (DVD says: %s)\n", playerconfig->title_string, dvd_titlestring);
 
 	msg = DDVD_SHOWOSD_TITLESTRING;
-	safe_write(message_pipe, &msg, sizeof(int));
+	send_message(playerconfig, msg);
+
+	if (remux) {
+		Debug(1, "Remuxing title %d\n", playerconfig->remux_title);
+		if (dvdnav_title_play(playerconfig->dvdnav, playerconfig->remux_title) != DVDNAV_STATUS_OK) {
+			Debug(1, "Error on dvdnav_title_play: %s\n", dvdnav_err_to_string(playerconfig->dvdnav));
+			res = DDVD_INVAL;
+			goto err_dvdnav;
+		}
+	}
+	else if (!playerconfig->should_resume && playerconfig->run_mode == DDVD_RUN_MAIN_FEATURE && (i = ddvd_main_feature(playerconfig)) > 0) {
+		// no first play and no menu, they are reached with DDVD_KEY_MENU from the title
+		Debug(1, "Playing main feature: title %d, %d s\n", i, playerconfig->disc_info.title[i - 1].seconds);
+	}
+	else if (playerconfig->should_resume && ddvd_resume_valid(playerconfig) &&
+			dvdnav_part_play(playerconfig->dvdnav, playerconfig->resume_title, playerconfig->resume_chapter) == DVDNAV_STATUS_OK) {
+		// straight into the stored title, without first play, warnings and menus. The block is
+		// searched on its first cell change, like any later resume
+		Debug(1, "Resuming directly at title/chapter (%d/%d)\n", playerconfig->resume_title, playerconfig->resume_chapter);
+		first_vts_change = 0;
+		next_cell_change = 1;
+	}
+	else {
+		if( dvdnav_title_play(playerconfig->dvdnav, 1 ) != DVDNAV_STATUS_OK)
+			Debug(1, "cannot set title (can't decrypt DVD?)\n");
+
+		if( dvdnav_menu_call(playerconfig->dvdnav, DVD_MENU_Title ) != DVDNAV_STATUS_OK) {
+			/* Try going to menu root */
+			if( dvdnav_menu_call(playerconfig->dvdnav, DVD_MENU_Root) != DVDNAV_STATUS_OK)
+				Debug(1, "cannot go to dvd menu\n");
+		}
+	}
 
-	if( dvdnav_title_play(dvdnav, 1 ) != DVDNAV_STATUS_OK)
-		Debug(1, "cannot set title (can't decrypt DVD?)\n");
+	ddvd_clock_init(&playerconfig->clock);
+	ddvd_timeline_init(&playerconfig->timeline);
+	ddvd_aring_clear(&playerconfig->arings);
+
+	// the player sleeps in its event loop when it has nothing to read, write or display
+	struct ddvd_loop *loop = &playerconfig->loop;
+	if (ddvd_loop_init(loop, key_pipe) < 0) {
+		res = DDVD_NOMEM;
+		goto err_dvdnav;
+	}
 
-	if( dvdnav_menu_call(dvdnav, DVD_MENU_Title ) != DVDNAV_STATUS_OK) {
-		/* Try going to menu root */
-		if( dvdnav_menu_call(dvdnav, DVD_MENU_Root) != DVDNAV_STATUS_OK)
-			Debug(1, "cannot go to dvd menu\n");
+	// dvdnav is read by its own thread from here on, so a slow drive does not hold up the loop
+	struct ddvd_reader *reader = &playerconfig->reader;
+	if (ddvd_reader_start(reader, playerconfig->dvdnav, playerconfig->readahead) < 0) {
+		res = DDVD_NOMEM;
+		goto err_dvdnav;
 	}
 
-	/* the read loop which regularly calls dvdnav_get_next_block
+	/* the read loop which regularly gets the blocks read from dvdnav
 	 * and handles the returned events */
 	int reached_eof = 0;
 	int reached_sof = 0;
@@ -977,26 +1204,51 @@ enum ddvd_result ddvd_run(struct ddvd *playerconfig)
 	pci_t *pci = NULL;
 	dvdnav_still_event_t still_event;
 	int have_still_event = 0;
+	uint64_t nav_wait_end = 0;	// give up waiting for the decoder in DVDNAV_WAIT
+	int output_batch = 0;		// blocks with output in the sink queue
+	int backpressure = 0;		// the decoder does not take more output
+	int replaying = 0;			// the block is an audio pack played again after a switch
+	int idle = 0;				// the last round found nothing to read
+	int still_wait = 0;			// the last round found a still with its timer running
+	int nav_wait = 0;			// a DVDNAV_WAIT is held until the decoder caught up
 
 	while (!finished) {
 		dsi_t *dsi = 0;
 		int draw_osd = 0;
 
+		// sleep until a block, a key, the decoder or a timer needs us
+		if (idle || still_wait || nav_wait) {
+			int timeout = ddvd_next_timeout(playerconfig, ddvd_get_time());
+			// subtitles, highlights and stills follow the decoder time while it has data
+			int follow_decoder = !still_wait || ddvd_spu_play != ddvd_spu_ind || ddvd_wait_highlight;
+			if ((nav_wait || (follow_decoder && ddvd_timeline_buffered(&playerconfig->timeline) > 0)) && (timeout < 0 || timeout > LOOP_DECODER_MS))
+				timeout = LOOP_DECODER_MS;
+			// in a still or wait the reader only brings the same event again, the player keeps it
+			// (so the reader stays parked) and does not wait for it
+			if (backpressure || still_wait || nav_wait)
+				ddvd_loop_wait(loop, sink, timeout);
+			else if (ddvd_reader_sleep(reader, loop)) {
+				ddvd_loop_wait(loop, sink, timeout);
+				ddvd_reader_awake(reader);
+			}
+			idle = still_wait = 0;
+		}
+
 		/* the main reading function */
 		now = ddvd_get_time();
-		if (ddvd_playmode & (PLAY|STEP)) {	// Skip when not in play/step mode
+		if (playerconfig->playmode & (PLAY|STEP)) {	// Skip when not in play/step mode
 			// trickmode
-			if (ddvd_trickmode & (TRICKFW | TRICKBW) && now >= ddvd_trick_timer_end) {
+			if (playerconfig->trickmode & (TRICKFW | TRICKBW) && now >= playerconfig->trick_timer_end) {
 				uint32_t pos, len;
-				dvdnav_get_position(dvdnav, &pos, &len);
+				ddvd_reader_position(reader, &pos, &len);
 				if (!len)
 					len = 1;
 				// Backward: 90000 = 1 Sek. -> 45000 = 0.5 Sek.  -> Speed Faktor=2
 				// Forward:  90000 = 1 Sek. -> 22500 = 0.25 Sek. -> Speed Faktor=2
 				#define FORWARD_WAIT 300
 				#define BACKWARD_WAIT 500
-				int64_t offset = (ddvd_trickspeed - 1) * 90000L * (ddvd_trickmode & TRICKBW ? BACKWARD_WAIT : FORWARD_WAIT) / 1000;
-				int64_t newpos = (int64_t)pos +(offset + (int64_t)(vpts > pts ? pts - vpts : 0)) * (int64_t)len / ddvd_lastCellEventInfo.pgc_length;
+				int64_t offset = (playerconfig->trickspeed - 1) * 90000L * (playerconfig->trickmode & TRICKBW ? BACKWARD_WAIT : FORWARD_WAIT) / 1000;
+				int64_t newpos = ddvd_seek_block(playerconfig, pos, len, offset - ddvd_timeline_buffered(&playerconfig->timeline));
 				Debug(1, "FAST FW/BW: %d -> %lld - %lld - SPU clr=%d->%d vpts=%llu pts=%llu\n", pos, newpos, offset, ddvd_spu_play, ddvd_spu_ind, vpts, pts);
 				if (newpos <= 0) {	// reached begin of movie
 					newpos = 0;
@@ -1009,20 +1261,64 @@ enum ddvd_result ddvd_run(struct ddvd *playerconfig)
 					// msg = DDVD_SHOWOSD_TIME; // Is osd update needed every jump?
 				}
 				else
-					msg = ddvd_trickmode & TRICKFW ? DDVD_SHOWOSD_STATE_FFWD : DDVD_SHOWOSD_STATE_FBWD;
-				dvdnav_sector_search(dvdnav, newpos, SEEK_SET);
-				ddvd_trick_timer_end = now + (ddvd_trickmode & TRICKFW ? FORWARD_WAIT : BACKWARD_WAIT);
-				ddvd_lpcm_count = 0;
+					msg = playerconfig->trickmode & TRICKFW ? DDVD_SHOWOSD_STATE_FFWD : DDVD_SHOWOSD_STATE_FBWD;
+				ddvd_reader_lock(reader);
+				dvdnav_sector_search(playerconfig->dvdnav, newpos, SEEK_SET);
+				ddvd_reader_unlock(reader, 1);
+				playerconfig->trick_timer_end = now + (playerconfig->trickmode & TRICKFW ? FORWARD_WAIT : BACKWARD_WAIT);
+				playerconfig->lpcm_count = 0;
 				ddvd_spu_play = ddvd_spu_ind; // skip remaining subtitles
 			}
 
-			result = dvdnav_get_next_block(dvdnav, buf, &event, &len);
+			// a full decoder does not take more, the loop waits for it (or a key) instead of blocking in write
+			if (ddvd_sink_pending(sink))
+				ddvd_sink_flush(sink);
+			backpressure = ddvd_sink_pending(sink) != 0;
+
+			// write what the last blocks queued, a batch at a time while the reader is ahead
+			if (output_batch >= OUTPUT_BATCH || !ddvd_reader_ready(reader)) {
+				ddvd_sink_flush(sink);
+				ddvd_reader_recycle(reader);
+				output_batch = 0;
+			}
+
+			// the packs of a new audio stream the decoder has not played yet go before the reader
+			uint8_t *replay = backpressure ? NULL : ddvd_aring_next(&playerconfig->arings, &len);
+			// a jump drops the held wait, dvdnav brings a new one if the new place needs it
+			if (nav_wait && !ddvd_reader_held(reader))
+				nav_wait = nav_wait_end = 0;
+			struct ddvd_block *block = backpressure || replay || nav_wait ? NULL : ddvd_reader_get(reader, 0);
+			replaying = replay != NULL;
+			if (replaying) {
+				result = DVDNAV_STATUS_OK;
+				event = DVDNAV_BLOCK_OK;
+				buf = replay;
+			}
+			else if (nav_wait) {	// the wait is handled again without pulling it from dvdnav
+				result = DVDNAV_STATUS_OK;
+				event = DVDNAV_WAIT;
+				len = 0;
+			}
+			else if (block == NULL) {	// nothing read yet, keep subtitles, timers and keys going
+				idle = 1;
+				result = DVDNAV_STATUS_OK;
+				event = DVDNAV_NOP;
+				len = 0;
+			}
+			else {
+				ddvd_stats_add(&playerconfig->stats, DDVD_STAGE_READ, block->read_ns, NULL, 0);
+				output_batch++;
+				result = block->result;
+				event = block->event;
+				len = block->len;
+				buf = block->buf;
+			}
 			if (result == DVDNAV_STATUS_ERR) {
-				Debug(1, "Error getting next block: %s\n", dvdnav_err_to_string(dvdnav));
-				sprintf(osdtext, "Error: Getting next block: %s", dvdnav_err_to_string(dvdnav));
+				Debug(1, "Error getting next block: %s\n", dvdnav_err_to_string(playerconfig->dvdnav));
+				sprintf(osdtext, "Error: Getting next block: %s", dvdnav_err_to_string(playerconfig->dvdnav));
 				msg = DDVD_SHOWOSD_STRING;
-				safe_write(message_pipe, &msg, sizeof(int));
-				safe_write(message_pipe, &osdtext, sizeof(osdtext));
+				send_message(playerconfig, msg);
+				send_message_data(playerconfig, &osdtext, sizeof(osdtext));
 				res = DDVD_FAIL_READ;
 				goto err_dvdnav;
 			}
@@ -1034,21 +1330,21 @@ send_message:
 				switch (msg) {
 					case DDVD_SHOWOSD_TIME:
 						info = ddvd_get_osd_time(playerconfig);
-						safe_write(message_pipe, &msg, sizeof(int));
-						safe_write(message_pipe, &info, sizeof(struct ddvd_time));
-						Debug(4, "OSD_TIME vpts=%llu pts=%llu iframesend=%d\n", vpts, pts, ddvd_iframesend);
+						send_message(playerconfig, msg);
+						send_message_data(playerconfig, &info, sizeof(struct ddvd_time));
+						Trace(4, TRACE_OSD_TIME, vpts, pts, playerconfig->iframesend);
 						break;
 					case DDVD_SHOWOSD_STATE_FFWD:
 						info = ddvd_get_osd_time(playerconfig);
-						safe_write(message_pipe, &msg, sizeof(int));
-						safe_write(message_pipe, &ddvd_trickspeed, sizeof(int));
-						safe_write(message_pipe, &info, sizeof(struct ddvd_time));
+						send_message(playerconfig, msg);
+						send_message_data(playerconfig, &playerconfig->trickspeed, sizeof(int));
+						send_message_data(playerconfig, &info, sizeof(struct ddvd_time));
 						break;
 					case DDVD_SHOWOSD_STATE_FBWD:
 						info = ddvd_get_osd_time(playerconfig);
-						safe_write(message_pipe, &msg, sizeof(int));
-						safe_write(message_pipe, &ddvd_trickspeed, sizeof(int));
-						safe_write(message_pipe, &info, sizeof(struct ddvd_time));
+						send_message(playerconfig, msg);
+						send_message_data(playerconfig, &playerconfig->trickspeed, sizeof(int));
+						send_message_data(playerconfig, &info, sizeof(struct ddvd_time));
 						break;
 					default:
 						break;
@@ -1059,14 +1355,14 @@ send_message:
 			if (reached_eof) {
 				Debug(2, "EOF\n");
 				msg = DDVD_EOF_REACHED;
-				safe_write(message_pipe, &msg, sizeof(int));
+				send_message(playerconfig, msg);
 				reached_eof = 0;
 			}
 
 			if (reached_sof) {
 				Debug(2, "SOF\n");
 				msg = DDVD_SOF_REACHED;
-				safe_write(message_pipe, &msg, sizeof(int));
+				send_message(playerconfig, msg);
 				reached_sof = 0;
 			}
 
@@ -1077,24 +1373,24 @@ send_message:
 				goto send_message;
 			}
 			// send iFrame
-			if (ddvd_iframesend < 0) {
+			if (playerconfig->iframesend < 0) {
 #if CONFIG_API_VERSION == 1
-				ddvd_device_clear();
+				ddvd_device_clear(playerconfig);
 #endif
-				ddvd_iframesend = 0;
+				playerconfig->iframesend = 0;
 			}
 
-			if (ddvd_iframesend > 0) {
+			if (playerconfig->iframesend > 0) {
 #if CONFIG_API_VERSION == 1
-				ddvd_device_clear();
+				ddvd_device_clear(playerconfig);
 #endif
-				if (ddvd_still_frame && ddvd_last_iframe_len) {
+				if (playerconfig->still_frame && playerconfig->last_iframe_len && !remux) {
 #if 0
 					static int ifnum = 0;
 					static char ifname[255];
 					snprintf(ifname, 255, "/tmp/dvd.iframe.%3.3d.asm.pes", ifnum++);
 					FILE *f = fopen(ifname, "wb");
-					fwrite(last_iframe, 1, ddvd_last_iframe_len, f);
+					fwrite(last_iframe, 1, playerconfig->last_iframe_len, f);
 					fclose(f);
 #endif
 
@@ -1102,28 +1398,31 @@ send_message:
 					//that really sucks but there is no other way
 					int i;
 					for (i = 0; i < 10; i++)
-						safe_write(ddvd_output_fd, last_iframe, ddvd_last_iframe_len);
+						ddvd_sink_write(sink, DDVD_DEV_VIDEO, last_iframe, playerconfig->last_iframe_len);
 #else
-					safe_write(ddvd_output_fd, last_iframe, ddvd_last_iframe_len);
-					safe_write(ddvd_output_fd, last_iframe, ddvd_last_iframe_len); // send twice to avoid no-display...
+					ddvd_sink_write(sink, DDVD_DEV_VIDEO, last_iframe, playerconfig->last_iframe_len);
+					ddvd_sink_write(sink, DDVD_DEV_VIDEO, last_iframe, playerconfig->last_iframe_len); // send twice to avoid no-display...
 #endif
-					//Debug(1, "Show iframe with size: %d\n",ddvd_last_iframe_len);
-					ddvd_last_iframe_len = 0;
+					//Debug(1, "Show iframe with size: %d\n",playerconfig->last_iframe_len);
+					playerconfig->last_iframe_len = 0;
 				}
 
-				ddvd_iframesend = -1;
+				playerconfig->iframesend = -1;
 			}
 			// wait timer
-			if (ddvd_wait_timer_active && now >= ddvd_wait_timer_end) {
-				ddvd_wait_timer_active = 0;
-				dvdnav_still_skip(dvdnav);
+			if (playerconfig->wait_timer_active && now >= playerconfig->wait_timer_end) {
+				playerconfig->wait_timer_active = 0;
+				// the reader may hold the still event again already, it belongs to the skipped still
+				ddvd_reader_lock(reader);
+				dvdnav_still_skip(playerconfig->dvdnav);
+				ddvd_reader_unlock(reader, 1);
 				Debug(1, "wait timer done\n");
 			}
 			// SPU timer
-			if (ddvd_spu_timer_active && now >= ddvd_spu_timer_end) {
-				ddvd_spu_timer_active = 0;
-				Debug(3, "    set clear SPU backbuffer, SPU finished\n");
-				ddvd_clear_screen = 1;
+			if (playerconfig->spu_timer_active && now >= playerconfig->spu_timer_end) {
+				playerconfig->spu_timer_active = 0;
+				Trace(3, TRACE_SPU_FINISHED);
+				playerconfig->clear_screen = 1;
 			}
 
 			switch (event) {
@@ -1131,60 +1430,74 @@ send_message:
 				/* We have received a regular block of the currently playing MPEG stream.
 				 * So we do some demuxing and decoding. */
 				{
-					// collect audio data
-					int stream_type = buf[14 + buf[14 + 8] + 9];
-					if (((buf[14 + 3]) & 0xF0) == 0xC0)
-						playerconfig->audio_format[(buf[14 + 3]) - 0xC0] = DDVD_MPEG;
-					if ((buf[14 + 3]) == 0xBD && (stream_type & 0xF8) == 0x80)
-						playerconfig->audio_format[stream_type - 0x80] = DDVD_AC3;
-					if ((buf[14 + 3]) == 0xBD && (stream_type & 0xF8) == 0x88)
-						playerconfig->audio_format[stream_type - 0x88] = DDVD_DTS;
-					if ((buf[14 + 3]) == 0xBD && (stream_type & 0xF8) == 0xA0)
-						playerconfig->audio_format[stream_type - 0xA0] = DDVD_LPCM;
-
-					if ((buf[14 + 3] & 0xF0) == 0xE0) {	// video
-						int pes_len = ((buf[14 + 4] << 8) | buf[14 + 5]) + 6;
-						int padding = len - (14 + pes_len);
-						if (buf[14 + 7] & 128) {
-							/* damn gcc bug */
-							vpts = ((unsigned long long)(((buf[14 + 9] >> 1) & 7))) << 30;
-							vpts |= buf[14 + 10] << 22;
-							vpts |= (buf[14 + 11] >> 1) << 15;
-							vpts |= buf[14 + 12] << 7;
-							vpts |= (buf[14 + 13] >> 1);
-							//Debug(1, "VPTS=%llu\n", vpts);
+					// the header of the pack is parsed once, the stream id table gives the type
+					struct ddvd_pes pes;
+					int type = ddvd_demux_parse(buf, len, &pes);
+					// every audio stream is kept for switching
+					if (!replaying && type >= DDVD_DEMUX_MPEG && type <= DDVD_DEMUX_LPCM)
+						ddvd_aring_put(&playerconfig->arings, pes.index, buf, len, pes.has_pts,
+							pes.has_pts ? ddvd_timeline_time(&playerconfig->timeline, pes.pts) : 0);
+					if (pes.has_pts) {
+						if (type == DDVD_DEMUX_VIDEO) {
+							vpts = pes.pts;
+							ddvd_timeline_stream(&playerconfig->timeline, DDVD_TL_VIDEO, vpts);
+						}
+						else if (type != DDVD_DEMUX_SPU && pes.index == audio_id) {
+							apts = pes.pts;
+							ddvd_timeline_stream(&playerconfig->timeline, DDVD_TL_AUDIO, apts);
 						}
+					}
+
+					if (type == DDVD_DEMUX_VIDEO) {
+						int pes_len = pes.pes_len;
+						int padding = len - (DDVD_PACK_HEADER + pes_len);
+						uint16_t codes[DDVD_MAX_START_CODES];
+						int ncodes, c;
 #if CONFIG_API_VERSION == 1
 						// Eliminate 00 00 01 B4 sequence error packet because it breaks the pallas mpeg decoder
 						// This is very strange because the 00 00 01 B4 is partly inside the header extension ...
-						if (buf[21] == 0x00 && buf[22] == 0x00 && buf[23] == 0x01 && buf[24] == 0xB4)
+						if (buf[21] == 0x00 && buf[22] == 0x00 && buf[23] == 0x01 && buf[24] == 0xB4) {
+							buf = ddvd_reader_writable(reader);
 							buf[21] = 0x01;
-						if (buf[22] == 0x00 && buf[23] == 0x00 && buf[24] == 0x01 && buf[25] == 0xB4)
+						}
+						if (buf[22] == 0x00 && buf[23] == 0x00 && buf[24] == 0x01 && buf[25] == 0xB4) {
+							buf = ddvd_reader_writable(reader);
 							buf[22] = 0x01;
+						}
 #endif
 						// if we have 16:9 Zoom Mode on the DVD and we use a "always 16:9" mode on tv
 						// and patch the mpeg header and the Sequence Display Extension inside the Stream in some cases
 						if (dvd_aspect == 3 && (
 							(tv_aspect == DDVD_16_9 && (tv_mode == DDVD_PAN_SCAN || tv_mode == DDVD_LETTERBOX)) ||
 							(tv_aspect == DDVD_16_10 && (tv_mode2 == DDVD_PAN_SCAN || tv_mode2 == DDVD_LETTERBOX)) ) ) {
-							for (int z = 0; z < 2040; z++) {
-								if (buf[z] == 0x0 && buf[z + 1] == 0x0 && buf[z + 2] ==0x01 && buf[z + 3] == 0xB5 &&
-									(buf[z + 4] == 0x22 || buf[z + 4] == 0x23) ) {
+							// the block is only copied when there is something to patch, most packs have not
+							ncodes = ddvd_demux_start_codes(buf, pes.payload, len, codes, DDVD_MAX_START_CODES);
+							for (c = 0; c < ncodes; c++) {
+								int z = codes[c];
+								if (buf[z + 3] == 0xB5 && z + 4 < len && (buf[z + 4] == 0x22 || buf[z + 4] == 0x23)) {
 									z += (buf[z + 4] & 0x01) ? 8 : 5;
+									if (z + 3 >= len)
+										break;
+									buf = ddvd_reader_writable(reader);
 									buf[z]     = 0x0B;
 									buf[z + 1] = 0x42;
 									buf[z + 2] = 0x12;
 									buf[z + 3] = 0x00;
-									z += 3;
+									while (c + 1 < ncodes && codes[c + 1] <= z + 3)
+										c++;
 								}
 							}
-							if (buf[33] == 0 && buf[33 + 1] == 0 && buf[33 + 2] == 1 && buf[33 + 3] == 0xB3)
+							if (buf[33] == 0 && buf[33 + 1] == 0 && buf[33 + 2] == 1 && buf[33 + 3] == 0xB3) {
+								buf = ddvd_reader_writable(reader);
 								buf[33 + 7] = (buf[33 + 7] & 0xF) + 0x30;
-							if (buf[36] == 0 && buf[36 + 1] == 0 && buf[36 + 2] == 1 && buf[36 + 3] == 0xB3)
+							}
+							if (buf[36] == 0 && buf[36 + 1] == 0 && buf[36 + 2] == 1 && buf[36 + 3] == 0xB3) {
+								buf = ddvd_reader_writable(reader);
 								buf[36 + 7] = (buf[36 + 7] & 0xF) + 0x30;
+							}
 						}
 
-						// check yres for detecting ntsc/pal
+						// check yres for detecting ntsc/pal when the video attributes did not tell
 						if (ddvd_have_ntsc == -1) {
 							if ( (buf[33] == 0 && buf[33 + 1] == 0 && buf[33 + 2] == 1 && buf[33 + 3] == 0xB3 &&
 									( (buf[33 + 5] & 0xF) << 8) + buf[33 + 6] == 0x1E0)
@@ -1196,139 +1509,111 @@ send_message:
 								ddvd_have_ntsc = 0;
 						}
 
-						if (padding > 8) {
-							memcpy(buf + 14 + pes_len, "\x00\x00\x01\xE0\x00\x00\x80\x00\x00", 9);
-							pes_len += 9;
-						}
+						ddvd_sink_queue(sink, DDVD_DEV_VIDEO, buf + 14, pes_len);
 
-						safe_write(ddvd_output_fd, buf + 14, pes_len);
+						// empty video pes header behind the packet in place of the padding
+						if (padding)
+							ddvd_sink_queue(sink, DDVD_DEV_VIDEO, "\x00\x00\x01\xE0\x00\x00\x80\x00\x00", 9);
 
-						if (padding && padding < 9)
-							safe_write(ddvd_output_fd, "\x00\x00\x01\xE0\x00\x00\x80\x00\x00", 9);
+						// the start codes of the mpeg data in the payload, headers are skipped
+						// by moving data behind them, end shrinks behind a picture header
+						int data = pes.payload;
+						int end = pes.payload + pes.payload_len;
+						if (end > len)
+							end = len;
+						ncodes = ddvd_demux_start_codes(buf, data, end, codes, DDVD_MAX_START_CODES);
 
-						// 14+8 header_length
-						// 14+(header_length)+3  -> start mpeg header
-						// buf[14+buf[14+8]+3] start mpeg header
-
-						int datalen = (buf[19] + (buf[18] << 8) + 6) - buf[14 + 8];	// length mpeg packet
-						int data = buf[14 + buf[14 + 8] + 3];	// start mpeg packet(header)
-
-						int do_copy = (ddvd_iframerun == 0x01) && !(buf[data] == 0 && buf[data + 1] == 0 && buf[data + 2] == 1) ? 1 : 0;
+						int do_copy = (playerconfig->iframerun == 0x01) && !(ncodes && codes[0] == data) ? 1 : 0;
 						int have_pictureheader = 0;
 						int haveslice = 0;
 						int setrun = 0;
 
-						while (datalen > 3) {
-							if (buf[data] == 0 && buf[data + 1] == 0 && buf[data + 2] == 1) {
-								if (buf[data + 3] == 0x00 && datalen > 6) { //picture
-									if (!setrun) {
-										ddvd_iframerun = ((buf[data + 5] >> 3) & 0x07);
-										setrun = 1;
-									}
-									if (ddvd_iframerun < 0x01 || 0x03 < ddvd_iframerun) {
-										data++;
-										datalen--;
-										continue;
-									}
-									have_pictureheader = 1;
-									data += 5;
-									datalen -= 5;
-									datalen = 6;
-								}
-								else if (buf[data + 3] == 0xB3 && datalen >= 8) { //sequence header
-									ddvd_last_iframe_len = 0;	// clear iframe buffer
-									data += 7;
-									datalen -= 7;
-								}
-								else if (buf[data + 3] == 0xBE) { //padding stream
-									break;
-								}
-								else if (0x01 <= buf[data + 3] && buf[data + 3] <= 0xaf) { //slice ?
-									if (!have_pictureheader && ddvd_last_iframe_len == 0)
-										haveslice = 1;
+						for (c = 0; c < ncodes; c++) {
+							int p = codes[c];
+							if (p < data)
+								continue;
+							if (p + 3 >= end)
+								break;
+							if (buf[p + 3] == 0x00 && end - p > 6) { //picture
+								if (!setrun) {
+									playerconfig->iframerun = ((buf[p + 5] >> 3) & 0x07);
+									setrun = 1;
 								}
+								if (playerconfig->iframerun < 0x01 || 0x03 < playerconfig->iframerun)
+									continue;
+								have_pictureheader = 1;
+								data = p + 6;
+								end = p + 11;
+							}
+							else if (buf[p + 3] == 0xB3 && end - p >= 8) { //sequence header
+								playerconfig->last_iframe_len = 0;	// clear iframe buffer
+								data = p + 8;
+							}
+							else if (buf[p + 3] == 0xBE) { //padding stream
+								break;
+							}
+							else if (0x01 <= buf[p + 3] && buf[p + 3] <= 0xaf) { //slice ?
+								if (!have_pictureheader && playerconfig->last_iframe_len == 0)
+									haveslice = 1;
 							}
-							data++;
-							datalen--;
 						}
-						if ((ddvd_iframerun <= 0x01 || do_copy) && ddvd_still_frame) {
+						if ((playerconfig->iframerun <= 0x01 || do_copy) && playerconfig->still_frame) {
 							if (haveslice)
-								ddvd_iframerun = 0xFF;
-							else if (ddvd_last_iframe_len < (320 * 1024) - ((buf[19] + (buf[18] << 8) + 6) - buf[14 + 8])) {
-								int len = buf[19] + (buf[18] << 8) + 6;
-								int skip = buf[14 + 8] + 9; // skip complete pes header
-								len -= skip;
-								if (ddvd_last_iframe_len == 0) { // add simple pes header without pts
+								playerconfig->iframerun = 0xFF;
+							else if (playerconfig->last_iframe_len < (320 * 1024) - (pes_len - buf[14 + 8])) {
+								if (playerconfig->last_iframe_len == 0) { // add simple pes header without pts
 									memcpy(last_iframe, "\x00\x00\x01\xE0\x00\x00\x80\x00\x00", 9);
-									ddvd_last_iframe_len += 9;
+									playerconfig->last_iframe_len += 9;
 								}
-								memcpy(last_iframe + ddvd_last_iframe_len, buf + 14 + skip, len);
-								ddvd_last_iframe_len += len;
+								// skip complete pes header
+								memcpy(last_iframe + playerconfig->last_iframe_len, buf + pes.payload, pes.payload_len);
+								playerconfig->last_iframe_len += pes.payload_len;
 							}
 						}
 					}
-					else if ((buf[14 + 3]) == 0xC0 + audio_id) {	// mpeg audio
+					else if (type == DDVD_DEMUX_MPEG && pes.index == audio_id) {
 						if (audio_type != DDVD_MPEG) {
 							//Debug(1, "Switch to MPEG Audio\n");
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_AV_SYNC, 1) < 0)
+							if (ddvd_sink_ioctl_queued(sink, DDVD_DEV_AUDIO, AUDIO_SET_AV_SYNC, 1) < 0)
 								Perror("AUDIO_SET_AV_SYNC");
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_BYPASS_MODE, 1) < 0)
+							if (ddvd_sink_ioctl_queued(sink, DDVD_DEV_AUDIO, AUDIO_SET_BYPASS_MODE, 1) < 0)
 								Perror("AUDIO_SET_BYPASS_MODE");
 							audio_type = DDVD_MPEG;
 						}
 
-						if (buf[14 + 7] & 128) {
-							/* damn gcc bug */
-							apts = ((unsigned long long)(((buf[14 + 9] >> 1) & 7))) << 30;
-							apts |= buf[14 + 10] << 22;
-							apts |= (buf[14 + 11] >> 1) << 15;
-							apts |= buf[14 + 12] << 7;
-							apts |= (buf[14 + 13] >> 1);
-							//Debug(1, "APTS=%X\n",(int)apts);
-						}
-
-						safe_write(ddvd_ac3_fd, buf + 14, buf[19] + (buf[18] << 8) + 6);
+						ddvd_sink_queue(sink, DDVD_DEV_AUDIO, buf + DDVD_PACK_HEADER, pes.pes_len);
 					}
-					else if ((buf[14 + 3]) == 0xBD && (buf[14 + buf[14 + 8] + 9]) == 0xA0 + audio_id) {	// lpcm audio
+					else if (type == DDVD_DEMUX_LPCM && pes.index == audio_id) {
 						// autodetect bypass mode
-						static int lpcm_mode = -1;
 						if (lpcm_mode < 0) {
 							lpcm_mode = 6;
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_BYPASS_MODE, lpcm_mode) < 0)
+							if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_SET_BYPASS_MODE, lpcm_mode) < 0)
 								lpcm_mode = 0;
 						}
 
 						if (audio_type != DDVD_LPCM) {
 							//Debug(1, "Switch to LPCM Audio\n");
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_AV_SYNC, 1) < 0)
+							if (ddvd_sink_ioctl_queued(sink, DDVD_DEV_AUDIO, AUDIO_SET_AV_SYNC, 1) < 0)
 								Perror("AUDIO_SET_AV_SYNC");
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_BYPASS_MODE, lpcm_mode) < 0)
+							if (ddvd_sink_ioctl_queued(sink, DDVD_DEV_AUDIO, AUDIO_SET_BYPASS_MODE, lpcm_mode) < 0)
 								Perror("AUDIO_SET_BYPASS_MODE");
 							audio_type = DDVD_LPCM;
-							ddvd_lpcm_count = 0;
-						}
-						if (buf[14 + 7] & 128) {
-							/* damn gcc bug */
-							apts = ((unsigned long long)(((buf[14 + 9] >> 1) & 7))) << 30;
-							apts |= buf[14 + 10] << 22;
-							apts |= (buf[14 + 11] >> 1) << 15;
-							apts |= buf[14 + 12] << 7;
-							apts |= (buf[14 + 13] >> 1);
-							//Debug(1, "APTS=%X\n",(int)apts);
+							playerconfig->lpcm_count = 0;
 						}
-
 						if (lpcm_mode == 0) {
-							int i = 0;
-							char abuf[(((buf[18] << 8) | buf[19]) - buf[22] - 14)];
+							// samples start behind the 6 byte lpcm header following the substream id
+							const uint8_t *samples = buf + pes.payload + 6;
+							int i = 0, n = pes.payload_len - 10;
+							char abuf[n];
 #if BYTE_ORDER == BIG_ENDIAN
 							// just copy, byte order is correct on ppc machines
-							memcpy(abuf, buf + 14 + buf[14 + 8] + 9 + 7, (((buf[18] << 8) | buf[19]) - buf[22] - 14));
-							i = (((buf[18] << 8) | buf[19]) - buf[22] - 14);
+							memcpy(abuf, samples, n);
+							i = n;
 #else
 							// byte swapping .. we become the wrong byteorder on lpcm on the 7025
-							while (i < (((buf[18] << 8) | buf[19]) - buf[22] - 14)) {
-								abuf[i + 0] = (buf[14 + buf[14 + 8] + 9 + 7 + i + 1]);
-								abuf[i + 1] = (buf[14 + buf[14 + 8] + 9 + 7 + i + 0]);
+							while (i < n) {
+								abuf[i + 0] = samples[i + 1];
+								abuf[i + 1] = samples[i + 0];
 								i += 2;
 							}
 #endif
@@ -1336,14 +1621,16 @@ send_message:
 							// information to the decoder to get a sync. playing the pcm data via
 							// oss will break the pic/sound sync. So believe it or not, this is the
 							// smartest way to get a synced lpcm track ;-)
-							if (ddvd_lpcm_count == 0) {	// save mpeg header with pts
-								memcpy(mpa_data, buf + 14, buf[14 + 8] + 9);
-								mpa_header_length = buf[14 + 8] + 9;
+							if (playerconfig->lpcm_count == 0) {	// save mpeg header with pts
+								memcpy(mpa_data, buf + DDVD_PACK_HEADER, pes.header_len);
+								mpa_header_length = pes.header_len;
 							}
-							if (ddvd_lpcm_count + i >= 4608) {	//we have to send 4608 bytes to the encoder
-								memcpy(lpcm_data + ddvd_lpcm_count, abuf, 4608 - ddvd_lpcm_count);
+							if (playerconfig->lpcm_count + i >= 4608) {	//we have to send 4608 bytes to the encoder
+								memcpy(lpcm_data + playerconfig->lpcm_count, abuf, 4608 - playerconfig->lpcm_count);
 								//encode
-								mpa_count = ddvd_mpa_encode_frame(mpa_data + mpa_header_length, 4608, lpcm_data);
+								stage_start = ddvd_stats_clock();
+								mpa_count = ddvd_mpa_encode_frame(playerconfig->mpa, mpa_data + mpa_header_length, 4608, lpcm_data);
+								ddvd_stats_time(&playerconfig->stats, DDVD_STAGE_MPA_ENCODE, stage_start, NULL, 0);
 								//patch pes__packet_length
 								mpa_count = mpa_count + mpa_header_length - 6;
 								mpa_data[4] = mpa_count >> 8;
@@ -1351,57 +1638,49 @@ send_message:
 								//patch header type to mpeg
 								mpa_data[3] = 0xC0;
 								//write
-								safe_write(ddvd_ac3_fd, mpa_data, mpa_count + mpa_header_length);
-								memcpy(lpcm_data, abuf + (4608 - ddvd_lpcm_count), i - (4608 - ddvd_lpcm_count));
-								ddvd_lpcm_count = i - (4608 - ddvd_lpcm_count);
-								memcpy(mpa_data, buf + 14, buf[14 + 8] + 9);
-								mpa_header_length = buf[14 + 8] + 9;
+								ddvd_sink_write(sink, DDVD_DEV_AUDIO, mpa_data, mpa_count + mpa_header_length);
+								memcpy(lpcm_data, abuf + (4608 - playerconfig->lpcm_count), i - (4608 - playerconfig->lpcm_count));
+								playerconfig->lpcm_count = i - (4608 - playerconfig->lpcm_count);
+								memcpy(mpa_data, buf + DDVD_PACK_HEADER, pes.header_len);
+								mpa_header_length = pes.header_len;
 							}
 							else {
-								memcpy(lpcm_data + ddvd_lpcm_count, abuf, i);
-								ddvd_lpcm_count += i;
+								memcpy(lpcm_data + playerconfig->lpcm_count, abuf, i);
+								playerconfig->lpcm_count += i;
 							}
 						}
 						else
-							safe_write(ddvd_ac3_fd, buf + 14 , buf[19] + (buf[18] << 8) + 6);
+							ddvd_sink_queue(sink, DDVD_DEV_AUDIO, buf + DDVD_PACK_HEADER, pes.pes_len);
 					}
-					else if ((buf[14 + 3]) == 0xBD && (buf[14 + buf[14 + 8] + 9]) == 0x88 + audio_id) {	// dts audio
+					else if (type == DDVD_DEMUX_DTS && pes.index == audio_id) {
 						if (audio_type != DDVD_DTS) {
 							//Debug(1, "Switch to DTS Audio (thru)\n");
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_AV_SYNC, 1) < 0)
+							if (ddvd_sink_ioctl_queued(sink, DDVD_DEV_AUDIO, AUDIO_SET_AV_SYNC, 1) < 0)
 								Perror("AUDIO_SET_AV_SYNC");
 #ifdef CONVERT_TO_DVB_COMPLIANT_DTS
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_BYPASS_MODE, 2) < 0)	// DTS (dvb compliant)
+							if (ddvd_sink_ioctl_queued(sink, DDVD_DEV_AUDIO, AUDIO_SET_BYPASS_MODE, 2) < 0)	// DTS (dvb compliant)
 #else
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_BYPASS_MODE, 5) < 0)	// DTS VOB
+							if (ddvd_sink_ioctl_queued(sink, DDVD_DEV_AUDIO, AUDIO_SET_BYPASS_MODE, 5) < 0)	// DTS VOB
 #endif
 								Perror("AUDIO_SET_BYPASS_MODE");
 							audio_type = DDVD_DTS;
 						}
 
-						if (buf[14 + 7] & 128) {
-							/* damn gcc bug */
-							apts = ((unsigned long long)(((buf[14 + 9] >> 1) & 7))) << 30;
-							apts |= buf[14 + 10] << 22;
-							apts |= (buf[14 + 11] >> 1) << 15;
-							apts |= buf[14 + 12] << 7;
-							apts |= (buf[14 + 13] >> 1);
-							//Debug(1, "APTS=%X\n",(int)apts);
-						}
-
 #ifdef CONVERT_TO_DVB_COMPLIANT_DTS
-						unsigned short pes_len = (buf[14 + 4] << 8 | buf[14 + 5]);
+						unsigned short pes_len = pes.pes_len - 6;
 						pes_len -= 4;	// strip first 4 bytes of pes payload
+						if (!replaying)	// replayed packs are a copy already
+							buf = ddvd_reader_writable(reader);
 						buf[14 + 4] = pes_len >> 8;	// patch pes len
 						buf[15 + 4] = pes_len & 0xFF;
 
-						safe_write(ddvd_ac3_fd, buf + 14, 9 + buf[14 + 8]);	// write pes_header
-						safe_write(ddvd_ac3_fd, buf + 14 + 9 + buf[14 + 8] + 4, pes_len - (3 + buf[14 + 8]));	// write pes_payload
+						ddvd_sink_queue(sink, DDVD_DEV_AUDIO, buf + DDVD_PACK_HEADER, pes.header_len);	// write pes_header
+						ddvd_sink_queue(sink, DDVD_DEV_AUDIO, buf + pes.payload + 3, pes.payload_len - 3);	// write pes_payload
 #else
-						safe_write(ddvd_ac3_fd, buf + 14, buf[19] + (buf[18] << 8) + 6);
+						ddvd_sink_queue(sink, DDVD_DEV_AUDIO, buf + DDVD_PACK_HEADER, pes.pes_len);
 #endif
 					}
-					else if ((buf[14 + 3]) == 0xBD && (buf[14 + buf[14 + 8] + 9]) == 0x80 + audio_id) {	// ac3 audio
+					else if (type == DDVD_DEMUX_AC3 && pes.index == audio_id) {
 						if (audio_type != DDVD_AC3) {
 							//Debug(1, "Switch to AC3 Audio\n");
 							int bypassmode;
@@ -1413,34 +1692,26 @@ send_message:
 #endif
 							else
 								bypassmode = 1;
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_AV_SYNC, 1) < 0)
+							if (ddvd_sink_ioctl_queued(sink, DDVD_DEV_AUDIO, AUDIO_SET_AV_SYNC, 1) < 0)
 								Perror("AUDIO_SET_AV_SYNC");
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_BYPASS_MODE, bypassmode) < 0)
+							if (ddvd_sink_ioctl_queued(sink, DDVD_DEV_AUDIO, AUDIO_SET_BYPASS_MODE, bypassmode) < 0)
 									Perror("AUDIO_SET_BYPASS_MODE");
 							audio_type = DDVD_AC3;
 						}
 
-						if (buf[14 + 7] & 128) {
-							/* damn gcc bug */
-							apts = ((unsigned long long)(((buf[14 + 9] >> 1) & 7))) << 30;
-							apts |= buf[14 + 10] << 22;
-							apts |= (buf[14 + 11] >> 1) << 15;
-							apts |= buf[14 + 12] << 7;
-							apts |= (buf[14 + 13] >> 1);
-							//Debug(1, "APTS=%X\n",(int)apts);
-						}
-
 						if (ac3thru || !have_liba52) {	// !have_liba52 and !ac3thru should never happen, but who knows ;)
 #ifdef CONVERT_TO_DVB_COMPLIANT_AC3
-							unsigned short pes_len = (buf[14 + 4] << 8 | buf[14 + 5]);
+							unsigned short pes_len = pes.pes_len - 6;
 							pes_len -= 4;	// strip first 4 bytes of pes payload
+							if (!replaying)	// replayed packs are a copy already
+								buf = ddvd_reader_writable(reader);
 							buf[14 + 4] = pes_len >> 8;	// patch pes len
 							buf[15 + 4] = pes_len & 0xFF;
 
-							safe_write(ddvd_ac3_fd, buf + 14, 9 + buf[14 + 8]);	// write pes_header
-							safe_write(ddvd_ac3_fd, buf + 14 + 9 + buf[14 + 8] + 4, pes_len - (3 + buf[14 + 8]));	// write pes_payload
+							ddvd_sink_queue(sink, DDVD_DEV_AUDIO, buf + DDVD_PACK_HEADER, pes.header_len);	// write pes_header
+							ddvd_sink_queue(sink, DDVD_DEV_AUDIO, buf + pes.payload + 3, pes.payload_len - 3);	// write pes_payload
 #else
-							safe_write(ddvd_ac3_fd, buf + 14, buf[19] + (buf[18] << 8) + 6);
+							ddvd_sink_queue(sink, DDVD_DEV_AUDIO, buf + DDVD_PACK_HEADER, pes.pes_len);
 #endif
 							//fwrite(buf + buf[22] + 27, 1, ((buf[18] << 8) | buf[19]) - buf[22] - 7, fac3); //debugwrite
 						}
@@ -1450,13 +1721,15 @@ send_message:
 							// audio and send them with pts information to the decoder to get a sync.
 
 							// decode and convert ac3 to raw lpcm
-							ac3_len = ddvd_ac3_decode(buf + buf[22] + 27, ((buf[18] << 8) | buf[19]) - buf[22] - 7, ac3_tmp);
+							stage_start = ddvd_stats_clock();
+							ac3_len = ddvd_ac3_decode(&playerconfig->a52, buf + pes.payload + 3, pes.payload_len - 3, ac3_tmp);
+							ddvd_stats_time(&playerconfig->stats, DDVD_STAGE_AC3_DECODE, stage_start, NULL, 0);
 
 							// save the pes header incl. PTS
-							memcpy(mpa_data, buf + 14, buf[14 + 8] + 9);
-							mpa_header_length = buf[14 + 8] + 9;
+							memcpy(mpa_data, buf + DDVD_PACK_HEADER, pes.header_len);
+							mpa_header_length = pes.header_len;
 
-							//apts -= (((unsigned long long)(ddvd_lpcm_count) * 90) / 192);
+							//apts -= (((unsigned long long)(playerconfig->lpcm_count) * 90) / 192);
 
 							//mpa_data[14] = (int)((apts << 1) & 0xFF);
 							//mpa_data[12] = (int)((apts >> 7) & 0xFF);
@@ -1464,16 +1737,18 @@ send_message:
 							//mpa_data[10] = (int)((apts >> 22) & 0xFF);
 
 							// copy lpcm data into buffer for encoding
-							memcpy(lpcm_data + ddvd_lpcm_count, ac3_tmp, ac3_len);
-							ddvd_lpcm_count += ac3_len;
+							memcpy(lpcm_data + playerconfig->lpcm_count, ac3_tmp, ac3_len);
+							playerconfig->lpcm_count += ac3_len;
 
 							// encode the whole packet to mpa
 							mpa_count2 = mpa_count = 0;
-							while (ddvd_lpcm_count >= 4608) {
-								mpa_count = ddvd_mpa_encode_frame(mpa_data + mpa_header_length + mpa_count2, 4608, lpcm_data);
+							while (playerconfig->lpcm_count >= 4608) {
+								stage_start = ddvd_stats_clock();
+								mpa_count = ddvd_mpa_encode_frame(playerconfig->mpa, mpa_data + mpa_header_length + mpa_count2, 4608, lpcm_data);
+								ddvd_stats_time(&playerconfig->stats, DDVD_STAGE_MPA_ENCODE, stage_start, NULL, 0);
 								mpa_count2 += mpa_count;
-								ddvd_lpcm_count -= 4608;
-								memcpy(lpcm_data, lpcm_data + 4608, ddvd_lpcm_count);
+								playerconfig->lpcm_count -= 4608;
+								memcpy(lpcm_data, lpcm_data + 4608, playerconfig->lpcm_count);
 							}
 
 							// patch pes__packet_length
@@ -1485,23 +1760,22 @@ send_message:
 							mpa_data[3] = 0xC0;
 
 							// write to decoder
-							safe_write(ddvd_ac3_fd, mpa_data, mpa_count2 + mpa_header_length);
+							ddvd_sink_write(sink, DDVD_DEV_AUDIO, mpa_data, mpa_count2 + mpa_header_length);
 
 						}
 					}
-					else if ((buf[14 + 3]) == 0xBD && ((buf[14 + buf[14 + 8] + 9]) & 0xE0) == 0x20 && ((buf[14 + buf[14 + 8] + 9]) & 0x1F) == spu_active_id) {	// SPU packet
-						Debug(2, "DVD SPU BLOCK: spu_nr=%d/%d vpts=%llu pts=%llu highlight=%d\n", ddvd_spu_play, ddvd_spu_ind, vpts, pts, have_highlight);
-						if (buf[14 + 7] & 128) {
-							/* damn gcc bug */
-							spts = ((unsigned long long)(((buf[14 + 9] >> 1) & 7))) << 30;
-							spts |= buf[14 + 10] << 22;
-							spts |= (buf[14 + 11] >> 1) << 15;
-							spts |= buf[14 + 12] << 7;
-							spts |= (buf[14 + 13] >> 1);
+					else if (type == DDVD_DEMUX_SPU && pes.index == spu_active_id && remux) {	// SPU packet, passed on when remuxing
+						ddvd_sink_queue(sink, DDVD_DEV_SPU, buf + DDVD_PACK_HEADER, pes.pes_len);
+					}
+					else if (type == DDVD_DEMUX_SPU && pes.index == spu_active_id) {	// SPU packet
+						Trace(2, TRACE_SPU_BLOCK, ddvd_spu_play, ddvd_spu_ind, vpts, pts, have_highlight);
+						if (pes.has_pts) {
+							spu_time = ddvd_timeline_stream(&playerconfig->timeline, DDVD_TL_SPU, pes.pts);
+							spts = pes.pts;
 #if CONFIG_API_VERSION == 1
 							spts >>= 1;	// need a corrected "spts" because vulcan/pallas will give us a 32bit pts instead of 33bit
 #endif
-							Debug(2, "                                                                 SPTS=%llu  %3d:  %d:%02d:%02d.%05d\n", spts, ddvd_spu_ind, (int)(spts/90000/3600), (int)(spts/90000/60)%60, (int)(spts/90000)%60, (int)(spts%90000)*10/9);
+							Trace(2, TRACE_SPU_PTS, spts, ddvd_spu_ind, spts/90000/3600, (spts/90000/60)%60, (spts/90000)%60, (spts%90000)*10/9);
 						}
 
 						int i = ddvd_spu_ind % NUM_SPU_BACKBUFFER;
@@ -1510,16 +1784,16 @@ send_message:
 							ddvd_spu_play = ddvd_spu_ind - NUM_SPU_BACKBUFFER + 1;
 						}
 
-						int pck_len = 2048 - (buf[22] + 14 + 10);
-						if (ddvd_spu_ptr + pck_len > SPU_BUFLEN)
-							Debug(1, "SPU frame to long (%d > %d)\n", ddvd_spu_ptr + pck_len, SPU_BUFLEN);
+						int pck_len = 2048 - pes.payload;
+						if (playerconfig->spu_ptr + pck_len > SPU_BUFLEN)
+							Debug(1, "SPU frame to long (%d > %d)\n", playerconfig->spu_ptr + pck_len, SPU_BUFLEN);
 						else {
-							memcpy(ddvd_spu[i] + ddvd_spu_ptr, buf + buf[22] + 14 + 10, pck_len);
-							ddvd_spu_ptr += pck_len;
+							memcpy(ddvd_spu[i] + playerconfig->spu_ptr, buf + pes.payload, pck_len);
+							playerconfig->spu_ptr += pck_len;
 						}
 
 						int spulen = ddvd_spu[i][0] << 8 | ddvd_spu[i][1];
-						if (ddvd_spu_ptr >= spulen) {	// SPU packet complete ?
+						if (playerconfig->spu_ptr >= spulen) {	// SPU packet complete ?
 							int j = (i - 1) % NUM_SPU_BACKBUFFER;
 							if (spu_backpts[j] == spts && ddvd_spu_play < ddvd_spu_ind) {  // same spu. Copy data to previous buffer
 								memcpy(ddvd_spu[j], ddvd_spu[i], spulen);
@@ -1528,10 +1802,11 @@ send_message:
 							}
 							else {
 								spu_backpts[i] = spts;	// store pts
+								spu_backtime[i] = spu_time;
 								ddvd_spu_ind++;
 							}
-							memcpy(ddvd_pci[i], dvdnav_get_current_nav_pci(dvdnav), sizeof(pci_t));
-							ddvd_spu_ptr = 0;
+							memcpy(ddvd_pci[i], &reader->pci, sizeof(pci_t));
+							playerconfig->spu_ptr = 0;
 						}
 					}
 				}
@@ -1542,28 +1817,50 @@ send_message:
 				break;
 
 			case DVDNAV_STILL_FRAME:
-				if (ddvd_iframesend == 0 && ddvd_last_iframe_len)
-					ddvd_iframesend = 1;
+				if (remux) {	// nobody is watching
+					dvdnav_still_skip(playerconfig->dvdnav);
+					break;
+				}
+
+				if (playerconfig->iframesend == 0 && playerconfig->last_iframe_len)
+					playerconfig->iframesend = 1;
 
-				if (!ddvd_wait_timer_active && !have_still_event) {
+				if (!playerconfig->wait_timer_active && !have_still_event) {
 					// Save the still event so it can be processed when it is really time to be displayed!
 					// Need only to do so when no wait timer is active!
 					memcpy(&still_event, buf, sizeof(dvdnav_still_event_t));
 					have_still_event = 1;
-					Debug(4, "DVDNAV_STILL_FRAME: lenght=%d vpts=%llu pts=%llu\n", still_event.length, vpts, pts);
+					Trace(4, TRACE_STILL_FRAME, still_event.length, vpts, pts);
 				}
+				// dvdnav repeats the still until it is skipped, sleep until the timer or a key instead
+				if (playerconfig->wait_timer_active && playerconfig->iframesend <= 0)
+					still_wait = 1;
 				break;
 
 			case DVDNAV_WAIT:
 				/* We have reached a point in DVD playback, where timing is critical.
-				 * We dont use readahead, so we can simply skip the wait state. */
-				dvdnav_wait_skip(dvdnav);
+				 * The reader stops at every event, so all blocks before it are written.
+				 * Reading ahead, dvdnav also expects the decoder to have played them, it
+				 * repeats the event until we skip it. */
+				if (remux || !playerconfig->readahead) {
+					dvdnav_wait_skip(playerconfig->dvdnav);
+					break;
+				}
+				if (!nav_wait_end)
+					nav_wait_end = now + 1000;
+				if (pts + 10 >= vpts || now >= nav_wait_end) {
+					Trace(3, TRACE_NAV_WAIT, vpts, pts);
+					dvdnav_wait_skip(playerconfig->dvdnav);
+					nav_wait = nav_wait_end = 0;
+				}
+				else	// keep the event, the loop sleeps until the decoder moved on
+					nav_wait = 1;
 				break;
 
 			case DVDNAV_SPU_CLUT_CHANGE:
 				/* We received a new color lookup table so we read and store it */
 				{
-					Debug(2, "DVDNAV_SPU_CLUT_CHANGE vpts=%llu pts=%llu highlight=%d\n", vpts, pts, have_highlight);
+					Trace(2, TRACE_SPU_CLUT_CHANGE, vpts, pts, have_highlight);
 					int i = 0, i2 = 0;
 					uint8_t pal[16 * 4];
 #if BYTE_ORDER == BIG_ENDIAN
@@ -1597,9 +1894,9 @@ send_message:
 						int g = CLAMP((y - 53294 * cr - 25690 * cb) >> 16);
 						int b = CLAMP((y + 132278 * cb) >> 16);
 
-						ddvd_bl[i2] = b << 8;
-						ddvd_gn[i2] = g << 8;
-						ddvd_rd[i2] = r << 8;
+						playerconfig->bl[i2] = b << 8;
+						playerconfig->gn[i2] = g << 8;
+						playerconfig->rd[i2] = r << 8;
 						i += 4;
 						i2++;
 					}
@@ -1608,7 +1905,7 @@ send_message:
 				break;
 
 			case DVDNAV_SPU_STREAM_CHANGE:
-				Debug(2, "DVDNAV_SPU_STREAM_CHANGE vpts=%llu pts=%llu highlight=%d spu_lock=%d\n", vpts, pts, have_highlight, spu_lock);
+				Trace(2, TRACE_SPU_STREAM_CHANGE, vpts, pts, have_highlight, spu_lock);
 				/* We received a new SPU stream ID */
 				if (spu_lock)
 					break;
@@ -1643,13 +1940,13 @@ send_message:
 					spu_index = -1;
 				}
 				if (old_active_id != spu_active_id) {
-					Debug(3, "   clr spu frame spu_nr=%d->%d\n", ddvd_spu_play, ddvd_spu_ind);
+					Trace(3, TRACE_SPU_CLEAR, ddvd_spu_play, ddvd_spu_ind);
 					ddvd_spu_play = ddvd_spu_ind; // skip remaining subtitles
 				}
 				msg = DDVD_SHOWOSD_SUBTITLE;
-				safe_write(message_pipe, &msg, sizeof(int));
-				safe_write(message_pipe, &spu_index, sizeof(int));
-				safe_write(message_pipe, &spu_lang, sizeof(uint16_t));
+				send_message(playerconfig, msg);
+				send_message_data(playerconfig, &spu_index, sizeof(int));
+				send_message_data(playerconfig, &spu_lang, sizeof(uint16_t));
 				Debug(3, "SPU Stream change: w %d l: %d p: %d log: %d spu %d: active=%d prevactive=%d spu_lang=%04X %c%c\n", ev->physical_wide, ev->physical_letterbox, ev->physical_pan_scan, ev->logical, spu_index, spu_active_id, old_active_id, spu_lang, spu_lang >> 8, spu_lang & 0xFF);
 				spu_active_id &= 0x1F;
 				playerconfig->last_spu_id = spu_index;
@@ -1658,7 +1955,7 @@ send_message:
 			case DVDNAV_AUDIO_STREAM_CHANGE:
 				/* We received a new Audio stream ID  */
 				if (!audio_lock) {
-					audio_id = dvdnav_get_active_audio_stream(dvdnav);
+					audio_id = dvdnav_get_active_audio_stream(playerconfig->dvdnav);
 					report_audio_info = 1;
 				}
 				break;
@@ -1667,10 +1964,8 @@ send_message:
 				{
 					/* Prepare to display some Buttons */
 					dvdnav_highlight_event_t * hl = (dvdnav_highlight_event_t *) buf;
-					Debug(2, "DVDNAV_HIGHLIGHT vpts=%llu pts=%llu highlight=%d button=%d mode=%d, bpts=%u%s\n",
-								vpts, pts, have_highlight, hl->buttonN, hl->display, hl->pts,
-								(highlight_event.buttonN == hl->buttonN && highlight_event.pts == hl->pts) ?
-								 " -- probably same as previous" : "");
+					Trace(2, TRACE_HIGHLIGHT, vpts, pts, have_highlight, hl->buttonN, hl->display, hl->pts,
+								highlight_event.buttonN == hl->buttonN && highlight_event.pts == hl->pts);
 					memcpy(&highlight_event, buf, sizeof(dvdnav_highlight_event_t));
 					have_highlight = 1;
 					break;
@@ -1678,14 +1973,30 @@ send_message:
 
 			case DVDNAV_VTS_CHANGE:
 				{
-					Debug(2, "DVDNAV_VTS_CHANGE vpts=%llu pts=%llu highlight=%d\n", vpts, pts, have_highlight);
+					Trace(2, TRACE_VTS_CHANGE, vpts, pts, have_highlight);
 					/* Some status information like video aspect and video scale permissions do
 					 * not change inside a VTS. Therefore we will set it new at this place */
-					ddvd_play_empty(FALSE);
+					ddvd_play_empty(playerconfig, FALSE);
 					audio_lock = 0;	// reset audio & spu lock
 					spu_lock = 0;
+					// the audio formats and the video standard of the VTS from its attributes
 					for (i = 0; i < MAX_AUDIO; i++)
 						playerconfig->audio_format[i] = -1;
+					int logical_audio, stream_audio;
+					for (logical_audio = 0; logical_audio < MAX_AUDIO; logical_audio++) {
+						stream_audio = dvdnav_get_audio_logical_stream(playerconfig->dvdnav, logical_audio);
+						if (stream_audio >= 0 && stream_audio < MAX_AUDIO) {
+							int format = ddvd_probe_audio_type(dvdnav_audio_stream_format(playerconfig->dvdnav, logical_audio));
+							if (format != DDVD_UNKNOWN)
+								playerconfig->audio_format[stream_audio] = format;
+							Debug(2, "    %d: audio stream %d format %d\n", logical_audio, stream_audio, format);
+						}
+					}
+					uint32_t video_width, video_height;
+					if (dvdnav_get_video_resolution(playerconfig->dvdnav, &video_width, &video_height) == 0)
+						ddvd_have_ntsc = video_height == 480 || video_height == 240;
+					else
+						ddvd_have_ntsc = -1;
 					// fill spu_map with data
 					int logical_spu, stream_spu;
 					for (i = 0; i < MAX_SPU; i++)
@@ -1693,19 +2004,19 @@ send_message:
 					i = 0;
 					spu_index = -1;
 					for (logical_spu = 0; logical_spu < MAX_SPU; logical_spu++) {
-						stream_spu = dvdnav_get_spu_logical_stream(dvdnav, logical_spu);
+						stream_spu = dvdnav_get_spu_logical_stream(playerconfig->dvdnav, logical_spu);
 						if (stream_spu >= 0 && stream_spu < MAX_SPU) {
 							playerconfig->spu_map[i].logical_id = logical_spu;
 							playerconfig->spu_map[i].stream_id = stream_spu;
-							int lang = dvdnav_spu_stream_to_lang(dvdnav, logical_spu);
+							int lang = dvdnav_spu_stream_to_lang(playerconfig->dvdnav, logical_spu);
 							playerconfig->spu_map[i].lang = lang;
 #if FORCE_DEFAULT_SPULANG
 							if (spu_index == -1 && (lang >> 8) == playerconfig->language[0] && (lang & 0xff) == playerconfig->language[1]) {
 								spu_index = i;
 								msg = DDVD_SHOWOSD_SUBTITLE;
-								safe_write(message_pipe, &msg, sizeof(int));
-								safe_write(message_pipe, &spu_index, sizeof(int));
-								safe_write(message_pipe, &lang, sizeof(uint16_t));
+								send_message(playerconfig, msg);
+								send_message_data(playerconfig, &spu_index, sizeof(int));
+								send_message_data(playerconfig, &lang, sizeof(uint16_t));
 							}
 #endif
 							Debug(2, "    %d: MPEG spu stream %d -> logical stream %d - %04X %c%c\n", i, stream_spu, logical_spu, lang,
@@ -1721,8 +2032,8 @@ send_message:
 					}
 					playerconfig->last_spu_id = spu_index;
 
-					dvd_aspect = dvdnav_get_video_aspect(dvdnav);
-					dvd_scale_perm = dvdnav_get_video_scale_permission(dvdnav);
+					dvd_aspect = dvdnav_get_video_aspect(playerconfig->dvdnav);
+					dvd_scale_perm = dvdnav_get_video_scale_permission(playerconfig->dvdnav);
 					tv_scale = ddvd_check_aspect(dvd_aspect, dvd_scale_perm, tv_aspect, tv_mode);
 					Debug(3, "    DVD Aspect: %d TV Aspect: %d TV Scale: %d Allowed: %d TV Mode: %d, wanted langage: %c%c\n",
 								dvd_aspect, tv_aspect, tv_scale, dvd_scale_perm, tv_mode,
@@ -1734,18 +2045,38 @@ send_message:
 
 			case DVDNAV_CELL_CHANGE:
 				{
-					Debug(2, "DVDNAV_CELL_CHANGE vpts=%llu pts=%llu highlight=%d\n", vpts, pts, have_highlight);
+					Trace(2, TRACE_CELL_CHANGE, vpts, pts, have_highlight);
 					/* Store new cell information */
-					memcpy(&ddvd_lastCellEventInfo, buf, sizeof(dvdnav_cell_change_event_t));
+					memcpy(&playerconfig->last_cell_info, buf, sizeof(dvdnav_cell_change_event_t));
+
+					if (remux) {	// done when the title is left or starts over
+						int title = 0, part = 0;
+						dvdnav_current_title_info(playerconfig->dvdnav, &title, &part);
+						if (title != playerconfig->remux_title || part < remux_part) {
+							Debug(1, "Remuxing title %d done\n", playerconfig->remux_title);
+							finished = 1;
+							break;
+						}
+						remux_part = part;
+					}
+					else {	// the time map for seeking, only read when the PGC changes
+						int title = 0, part = 0;
+						dvdnav_current_title_info(playerconfig->dvdnav, &title, &part);
+						if (title > 0)
+							ddvd_tmap_load(&playerconfig->tmap, playerconfig->dvd_path, title, part);
+					}
 
-					if ((ddvd_still_frame & CELL_STILL) && ddvd_iframesend == 0 && ddvd_last_iframe_len)
-						ddvd_iframesend = 1;
+					if ((playerconfig->still_frame & CELL_STILL) && playerconfig->iframesend == 0 && playerconfig->last_iframe_len)
+						playerconfig->iframesend = 1;
 
-					ddvd_still_frame = (dvdnav_get_next_still_flag(dvdnav) != 0) ? CELL_STILL : 0;
+					playerconfig->still_frame = (dvdnav_get_next_still_flag(playerconfig->dvdnav) != 0) ? CELL_STILL : 0;
 
 					// resuming a dvd ?
 					if (playerconfig->should_resume && next_cell_change) {
-						if (dvdnav_sector_search(dvdnav, playerconfig->resume_block, SEEK_SET) == DVDNAV_STATUS_OK) {
+						ddvd_reader_lock(reader);
+						dvdnav_status_t resumed = dvdnav_sector_search(playerconfig->dvdnav, playerconfig->resume_block, SEEK_SET);
+						ddvd_reader_unlock(reader, resumed == DVDNAV_STATUS_OK);
+						if (resumed == DVDNAV_STATUS_OK) {
 							Debug(3, "    resuming to block %d\n", playerconfig->resume_block);
 							audio_id = playerconfig->resume_audio_id;
 							audio_lock = 1;//playerconfig->resume_audio_lock;
@@ -1771,9 +2102,9 @@ send_message:
 							}
 							playerconfig->last_spu_id = spu_index;
 							msg = DDVD_SHOWOSD_SUBTITLE;
-							safe_write(message_pipe, &msg, sizeof(int));
-							safe_write(message_pipe, &spu_index, sizeof(int));
-							safe_write(message_pipe, &spu_lang, sizeof(uint16_t));
+							send_message(playerconfig, msg);
+							send_message_data(playerconfig, &spu_index, sizeof(int));
+							send_message_data(playerconfig, &spu_lang, sizeof(uint16_t));
 							msg = DDVD_SHOWOSD_TIME; // send new position to the frontend
 						}
 						else
@@ -1792,11 +2123,11 @@ send_message:
 					}
 					// multiple angles ?
 					int num = 0, current = 0;
-					dvdnav_get_angle_info(dvdnav, &current, &num);
+					dvdnav_get_angle_info(playerconfig->dvdnav, &current, &num);
 					msg = DDVD_SHOWOSD_ANGLE;
-					safe_write(message_pipe, &msg, sizeof(int));
-					safe_write(message_pipe, &current, sizeof(int));
-					safe_write(message_pipe, &num, sizeof(int));
+					send_message(playerconfig, msg);
+					send_message_data(playerconfig, &current, sizeof(int));
+					send_message_data(playerconfig, &num, sizeof(int));
 				}
 				break;
 
@@ -1804,21 +2135,24 @@ send_message:
 				/* A NAV packet provides PTS discontinuity information, angle linking information and
 				 * button definitions for DVD menus. We have to handle some stilframes here */
 				// Debug(3, "DVDNAV_NAV_PACKJET vpts=%llu pts=%llu highlight=%d\n", vpts, pts, have_highlight);
-				if ((ddvd_still_frame & NAV_STILL) && ddvd_iframesend == 0 && ddvd_last_iframe_len)
-					ddvd_iframesend = 1;
+				if ((playerconfig->still_frame & NAV_STILL) && playerconfig->iframesend == 0 && playerconfig->last_iframe_len)
+					playerconfig->iframesend = 1;
+
+				// a VOBU not starting where the last one ended is a discontinuity of the pts
+				ddvd_timeline_nav(&playerconfig->timeline, reader->pci.pci_gi.vobu_s_ptm, reader->pci.pci_gi.vobu_e_ptm);
 
-				dsi = dvdnav_get_current_nav_dsi(dvdnav);
+				dsi = &reader->dsi;
 				if (dsi->vobu_sri.next_video == 0xbfffffff)
-					ddvd_still_frame |= NAV_STILL;	//|= 1;
+					playerconfig->still_frame |= NAV_STILL;	//|= 1;
 				else
-					ddvd_still_frame &= ~NAV_STILL;	//&= 1;
+					playerconfig->still_frame &= ~NAV_STILL;	//&= 1;
 				break;
 
 			case DVDNAV_HOP_CHANNEL:
 				/* This event is issued whenever a non-seamless operation has been executed.
 				 * So we drop our buffers */
 				Debug(2, "DVDNAV_HOP_CHANNEL vpts=%llu pts=%llu highlight=%d\n", vpts, pts, have_highlight);
-				ddvd_play_empty(TRUE);
+				ddvd_play_empty(playerconfig, TRUE);
 				break;
 
 			case DVDNAV_STOP:
@@ -1842,14 +2176,16 @@ send_message:
 			}
 		}
 
+		// nothing is displayed and no decoder sets the pace when remuxing, go straight to the commands
+		if (remux)
+			goto handle_keys;
+
 		// resuming a dvd ?
 		if (playerconfig->should_resume && !first_vts_change && !next_cell_change) {
-			int title_numbers, part_numbers;
-			dvdnav_get_number_of_titles(dvdnav, &title_numbers);
-			dvdnav_get_number_of_parts(dvdnav, playerconfig->resume_title, &part_numbers);
-			if (playerconfig->resume_title   > 0 && playerconfig->resume_title   <= title_numbers &&
-				playerconfig->resume_chapter > 0 && playerconfig->resume_chapter <= part_numbers) {
-				dvdnav_part_play(dvdnav, playerconfig->resume_title, playerconfig->resume_chapter);
+			if (ddvd_resume_valid(playerconfig)) {
+				ddvd_reader_lock(reader);
+				dvdnav_part_play(playerconfig->dvdnav, playerconfig->resume_title, playerconfig->resume_chapter);
+				ddvd_reader_unlock(reader, 1);
 				next_cell_change = 1;
 				Debug(3, "Resuming after first vts: going to chapter/title (%d/%d)\n",
                                playerconfig->resume_title, playerconfig->resume_chapter);
@@ -1870,18 +2206,22 @@ send_message:
 
 		// spu and highlight/button handling
 		unsigned long long spupts = spu_backpts[ddvd_spu_play % NUM_SPU_BACKBUFFER];
+		// the decoder is only asked for its time (and events) a few times per second
+		int clock_sampled = ddvd_clock_update(&playerconfig->clock, sink,
+				playerconfig->playmode == PLAY && playerconfig->trickmode == TOFF);
+		pts = ddvd_clock_pts(&playerconfig->clock);
 #if CONFIG_API_VERSION == 1
-		unsigned int tpts;
-		if (ioctl(ddvd_output_fd, VIDEO_GET_PTS, &tpts) < 0)
-			Perror("VIDEO_GET_PTS");
-		pts = (unsigned long long)tpts;
 		// we only have a 32bit pts on vulcan/pallas (instead of 33bit) so we need some
 		// tolerance on syncing SPU for menus so on non animated menus the buttons will
 		// be displayed to soon, but we we have to accept it
-		signed long long spudiff = pts - spupts + 255;
+		if (playerconfig->clock.valid)
+			ddvd_timeline_decoder(&playerconfig->timeline, pts << 1);
+		int64_t spu_slack = 2 * 255;
 #else
+		if (playerconfig->clock.valid)
+			ddvd_timeline_decoder(&playerconfig->timeline, pts);
 		struct video_event event;
-		if (!ioctl(ddvd_fdvideo, VIDEO_GET_EVENT, &event)) {
+		if (clock_sampled && !ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_GET_EVENT, &event)) {
 			switch(event.type) {
 				case VIDEO_EVENT_SIZE_CHANGED:
 				{
@@ -1890,8 +2230,8 @@ send_message:
 					evt.width = event.u.size.w;
 					evt.height = event.u.size.h;
 					evt.aspect = event.u.size.aspect_ratio;
-					safe_write(message_pipe, &msg, sizeof(int));
-					safe_write(message_pipe, &evt, sizeof(evt));
+					send_message(playerconfig, msg);
+					send_message_data(playerconfig, &evt, sizeof(evt));
 					Debug(3, "video size: %dx%d@%d\n", evt.width, evt.height, evt.aspect);
 					break;
 				}
@@ -1900,8 +2240,8 @@ send_message:
 					struct ddvd_framerate_evt evt;
 					int msg = DDVD_FRAMERATE_CHANGED;
 					evt.framerate = event.u.frame_rate;
-					safe_write(message_pipe, &msg, sizeof(int));
-					safe_write(message_pipe, &evt, sizeof(evt));
+					send_message(playerconfig, msg);
+					send_message_data(playerconfig, &evt, sizeof(evt));
 					Debug(3, "framerate: %d\n", evt.framerate);
 					break;
 				}
@@ -1910,68 +2250,63 @@ send_message:
 					struct ddvd_progressive_evt evt;
 					int msg = DDVD_PROGRESSIVE_CHANGED;
 					evt.progressive = event.u.frame_rate;
-					safe_write(message_pipe, &msg, sizeof(int));
-					safe_write(message_pipe, &evt, sizeof(evt));
+					send_message(playerconfig, msg);
+					send_message_data(playerconfig, &evt, sizeof(evt));
 					Debug(3, "progressive: %d\n", evt.progressive);
 					break;
 				}
 			}
 		}
-		if (ioctl(ddvd_fdvideo, VIDEO_GET_PTS, &pts) < 0)
-			Perror("VIDEO_GET_PTS");
 		// pts+10 to avoid decoder time rounding errors. Seen vpts=11555 and pts=11554 ...
-		signed long long spudiff = pts+10 - spupts;
+		int64_t spu_slack = 10;
 #endif
-		if (ddvd_playmode & STEP && pts > steppts) { // finish step
-			if (ioctl(ddvd_fdaudio, AUDIO_PAUSE) < 0)
+		if (playerconfig->playmode & STEP && pts > steppts) { // finish step
+			if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_PAUSE) < 0)
 				Perror("AUDIO_PAUSE");
-			if (ioctl(ddvd_fdvideo, VIDEO_FREEZE) < 0)
+			if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_FREEZE) < 0)
 				Perror("VIDEO_FREEZE");
 			Debug(3, "STEP mode done: go to PAUSE on %lld now %lld diff %lld %d:%02d:%02d/%02d\n", steppts, pts, pts - steppts,
 					(int)(pts/90000/3600), (int)(pts/90000/60)%60, (int)(pts/90000)%60,
 					(int)((pts%90000 + 1) * playerconfig->last_framerate.framerate / 90000 / 1000));
-			ddvd_playmode = PAUSE;
+			playerconfig->playmode = PAUSE;
 			msg = DDVD_SHOWOSD_STATE_PAUSE;
-			safe_write(message_pipe, &msg, sizeof(int));
-			ddvd_wait_for_user = 1; // don't waste cpu during pause
+			send_message(playerconfig, msg);
+			playerconfig->wait_for_user = 1; // don't waste cpu during pause
 		}
 
-		if (have_still_event && ddvd_iframesend <= 0 && pts <= vpts + 3600) {
-			/* It seems stills have a separate vpts (e.g. starting from 0 again, or a separate PGC)
+		if (have_still_event && playerconfig->iframesend <= 0 && ddvd_timeline_caught_up(&playerconfig->timeline, DDVD_TL_VIDEO)) {
+			/* Stills often have a separate vpts (e.g. starting from 0 again, or a separate PGC), the
+			 * decoder reached the still when it plays the segment of the last video.
 			 * Reached the time for a still frame. Start a timer to wait the amount of time specified by the
 			 * still's length while still handling user input to make menus and other interactive stills work.
 			 * A length of 0xff means an indefinite still which has to be skipped indirectly by some user interaction.
 			 */
-			if (!ddvd_wait_timer_active)
-				Debug(2, "DVDNAV_STILL_FRAME: activate: length=%d vpts=%llu pts=%llu\n", still_event.length, vpts, pts);
+			if (!playerconfig->wait_timer_active)
+				Trace(2, TRACE_STILL_ACTIVATE, still_event.length, vpts, pts);
 			if (still_event.length < 0xff) {
-				if (!ddvd_wait_timer_active) {
-					ddvd_wait_timer_active = 1;
-					ddvd_wait_timer_end = now + still_event.length * 1000; //ms
+				if (!playerconfig->wait_timer_active) {
+					playerconfig->wait_timer_active = 1;
+					playerconfig->wait_timer_end = now + still_event.length * 1000; //ms
 				}
 			}
 			else
-				ddvd_wait_for_user = 1;
+				playerconfig->wait_for_user = 1;
 			have_still_event = 0;
 		}
 		/*
-		 * When vpts > pts we are still in a normal stream so check on spudif is enough.
-		 * But when vpts < pts, libdvdnav already is working on a new video fragment (PGC) possible sending out PSU.
-		 * In that case we should only display the SPU if the spupts is still from the previous video (spupts > vpts)
-		 * and the SPU is within 2 seconds of the pts (spudiff < 2*90000).
-		 * (FIXME: why do we need this last check?, maybe doing this last check is just enough...)
-		 * Or when vpts < pts check that the previous_spupts < spupts ...
+		 * libdvdnav may already work on a new video fragment (PGC) with a pts starting over while
+		 * the decoder still plays the old one. The SPU and the decoder pts are compared on the
+		 * timeline, which knows to which fragment each belongs.
 		 */
-		if (ddvd_spu_play < ddvd_spu_ind && spudiff >= 0 && (vpts > pts || spupts+5 > vpts && spudiff < 2*90000)) {
-			memset(ddvd_lbb, 0, 720 * 576); // Clear decode buffer
-			cur_spu_return = ddvd_spu_decode_data(ddvd_lbb, ddvd_spu[ddvd_spu_play % NUM_SPU_BACKBUFFER], spupts); // decode
+		if (ddvd_spu_play < ddvd_spu_ind && ddvd_timeline_due(&playerconfig->timeline, spu_backtime[ddvd_spu_play % NUM_SPU_BACKBUFFER], spu_slack)) {
+			memset(playerconfig->lbb, 0, 720 * 576); // Clear decode buffer
+			stage_start = ddvd_stats_clock();
+			cur_spu_return = ddvd_spu_decode_data(playerconfig, playerconfig->lbb, ddvd_spu[ddvd_spu_play % NUM_SPU_BACKBUFFER], spupts); // decode
+			ddvd_stats_time(&playerconfig->stats, DDVD_STAGE_SPU_DECODE, stage_start, NULL, 0);
 			pci = ddvd_pci[ddvd_spu_play % NUM_SPU_BACKBUFFER];
-			Debug(2, "SPU current=%d pts=%llu spupts=%llu bbox: %dx%d %dx%d btns=%d highlight=%d displaytime=%d %s\n",
-				ddvd_spu_play, pts, spupts,
-				cur_spu_return.x_start, cur_spu_return.y_start,
-				cur_spu_return.x_end, cur_spu_return.y_end,
-				pci->hli.hl_gi.btn_ns, have_highlight, cur_spu_return.display_time,
-				cur_spu_return.force_hide == SPU_HIDE ? "hide" : cur_spu_return.force_hide == SPU_FORCE ? "force" : "show");
+			Trace(2, TRACE_SPU_DECODED, ddvd_spu_play, pts, spupts, cur_spu_return.display_time, cur_spu_return.force_hide,
+				pci->hli.hl_gi.btn_ns, have_highlight);
+			Trace(2, TRACE_SPU_BBOX, cur_spu_return.x_start, cur_spu_return.y_start, cur_spu_return.x_end, cur_spu_return.y_end);
 			ddvd_spu_play++;
 
 			// process spu data
@@ -1980,61 +2315,63 @@ send_message:
 				int buttonN;
 				if (!have_highlight) {
 					// got a Highlight SPU but no highlight event yet. Force getting one
-					dvdnav_get_current_highlight(dvdnav, &buttonN);
+					dvdnav_get_current_highlight(playerconfig->dvdnav, &buttonN);
 					if (buttonN == 0)
 						buttonN = 1;
 					if (buttonN > pci->hli.hl_gi.btn_ns)
 						buttonN = pci->hli.hl_gi.btn_ns;
-					dvdnav_button_select(dvdnav, pci, buttonN);
+					dvdnav_button_select(playerconfig->dvdnav, pci, buttonN);
 					ddvd_wait_highlight = 1; // still frame might already have set 'wait_for_user'. This will first wait for the highlight to be drawn
-					Debug(2, "FORCE highlight button %d\n", buttonN);
+					Trace(2, TRACE_FORCE_HIGHLIGHT, buttonN);
 				}
 				else
 					buttonN = highlight_event.buttonN;
 				in_menu = 1;
-				Debug(2, "Update highlight buttons - %d of %d, switching to menu\n", buttonN, pci->hli.hl_gi.btn_ns);
+				Trace(2, TRACE_UPDATE_HIGHLIGHT, buttonN, pci->hli.hl_gi.btn_ns);
 			}
 			else if (cur_spu_return.force_hide == SPU_SHOW) {
 				// subtitle
 				// overlapping spu timers not supported yet, so clear the screen in that case
-				if (ddvd_spu_timer_active || last_spu_return.display_time < 0) {
-					ddvd_clear_screen = 1;
-					Debug(3, "clear p_lfb, physical screen, new SPU, vpts=%llu pts=%llu spts=%llu highlight=%d spu_timer_active=%d lastsputime=%d\n", vpts, pts, spupts, have_highlight, ddvd_spu_timer_active, last_spu_return.display_time);
+				if (playerconfig->spu_timer_active || last_spu_return.display_time < 0) {
+					playerconfig->clear_screen = 1;
+					Trace(3, TRACE_SPU_NEW, vpts, pts, spupts, have_highlight, playerconfig->spu_timer_active, last_spu_return.display_time);
 				}
 				// dont display SPU if displaytime is <= 0 or the actual SPU track is marked as hide (bit 7)
-				if (cur_spu_return.display_time <= 0 || ((dvdnav_get_active_spu_stream(dvdnav) & 0x80) && !spu_lock)) {
-					ddvd_spu_timer_active = 0;
-					Debug(2, "do not display this spu: active stream=%u spulock=%d\n", dvdnav_get_active_spu_stream(dvdnav), spu_lock);
+				if (cur_spu_return.display_time <= 0 || ((dvdnav_get_active_spu_stream(playerconfig->dvdnav) & 0x80) && !spu_lock)) {
+					playerconfig->spu_timer_active = 0;
+					Trace(2, TRACE_SPU_SKIP, dvdnav_get_active_spu_stream(playerconfig->dvdnav), spu_lock);
 				}
 				else {
 					// set timer and prepare backbuffer
-					ddvd_spu_timer_active = 1;
-					ddvd_spu_timer_end = now + cur_spu_return.display_time * 10; //ms
-					Debug(3, "    drawing subtitle, vpts=%llu pts=%llu highlight=%d\n", vpts, pts, have_highlight);
+					playerconfig->spu_timer_active = 1;
+					playerconfig->spu_timer_end = now + cur_spu_return.display_time * 10; //ms
+					Trace(3, TRACE_SPU_DRAW, vpts, pts, have_highlight);
 					if (ddvd_screeninfo_bypp == 1) {
 						struct ddvd_color colnew;
 						int ctmp;
 						msg = DDVD_COLORTABLE_UPDATE;
-						safe_write(message_pipe, &msg, sizeof(int));
+						send_message(playerconfig, msg);
 						for (ctmp = 0; ctmp < 4; ctmp++) {
-							colnew.blue = ddvd_bl[ctmp + 252];
-							colnew.green = ddvd_gn[ctmp + 252];
-							colnew.red = ddvd_rd[ctmp + 252];
-							colnew.trans = ddvd_tr[ctmp + 252];
-							safe_write(message_pipe, &colnew, sizeof(struct ddvd_color));
+							colnew.blue = playerconfig->bl[ctmp + 252];
+							colnew.green = playerconfig->gn[ctmp + 252];
+							colnew.red = playerconfig->rd[ctmp + 252];
+							colnew.trans = playerconfig->tr[ctmp + 252];
+							send_message_data(playerconfig, &colnew, sizeof(struct ddvd_color));
 						}
 						msg = DDVD_NULL;
-						memcpy(ddvd_lbb2, ddvd_lbb, 720 * 576);
+						memcpy(playerconfig->lbb2, playerconfig->lbb, 720 * 576);
 					}
 					else {
-						ddvd_resize_pixmap = (ddvd_screeninfo_xres > 720) ?    // Set resize function
+						playerconfig->resize_pixmap = (playerconfig->screeninfo_xres > 720) ?    // Set resize function
 										&ddvd_resize_pixmap_xbpp : &ddvd_resize_pixmap_xbpp_smooth;
-						memset(ddvd_lbb2, 0, ddvd_screeninfo_stride * ddvd_screeninfo_yres);    // Clear backbuffer ..
+						memset(playerconfig->lbb2, 0, playerconfig->screeninfo_stride * playerconfig->screeninfo_yres);    // Clear backbuffer ..
 						int i = 0;
+						stage_start = ddvd_stats_clock();
 						for (i = cur_spu_return.y_start; i < cur_spu_return.y_end; ++i)
-							ddvd_blit_to_argb(ddvd_lbb2 + (i * 720 + cur_spu_return.x_start) * ddvd_screeninfo_bypp,
-												ddvd_lbb + i * 720 + cur_spu_return.x_start,
+							ddvd_blit_to_argb(playerconfig, playerconfig->lbb2 + (i * 720 + cur_spu_return.x_start) * ddvd_screeninfo_bypp,
+												playerconfig->lbb + i * 720 + cur_spu_return.x_start,
 												cur_spu_return.x_end - cur_spu_return.x_start);
+						ddvd_stats_time(&playerconfig->stats, DDVD_STAGE_BLIT, stage_start, NULL, 0);
 					}
 
 					blit_area.x_start = cur_spu_return.x_start;
@@ -2051,19 +2388,19 @@ send_message:
 
 		// highlight/button handling
 		if (in_menu && have_highlight) {
-			Debug(3, "HIGHLIGHT DRAW Selected button=%d mode=%d, bpts=%u vpts=%llu pts=%llu\n", highlight_event.buttonN, highlight_event.display, highlight_event.pts, vpts, pts);
+			Trace(3, TRACE_HIGHLIGHT_DRAW, highlight_event.buttonN, highlight_event.display, highlight_event.pts, vpts, pts);
 			dvdnav_highlight_area_t hl;
 			have_highlight = 0;
 			ddvd_wait_highlight = 0; // no need to hold 'wait_for_user' any longer
-			ddvd_clear_screen = 1;
+			playerconfig->clear_screen = 1;
 			blit_area.x_start = blit_area.x_end = blit_area.y_start = blit_area.y_end = 0;
 
 			if (!pci) // should not happen, is set when SPU is processed
-				pci = dvdnav_get_current_nav_pci(dvdnav);
+				pci = &reader->pci;
 
 			btni_t *btni = NULL;
 			if (pci->hli.hl_gi.btngr_ns) {
-				Debug(3, "DOBUTTON %d data from buttongroup\n", highlight_event.buttonN);
+				Trace(3, TRACE_BUTTON_GROUP, highlight_event.buttonN);
 				int btns_per_group = 36 / pci->hli.hl_gi.btngr_ns;
 				int modeMask = 1 << tv_scale;
 
@@ -2077,7 +2414,7 @@ send_message:
 					btni = &pci->hli.btnit[highlight_event.buttonN - 1];
 			}
 			if (btni) {
-				Debug(3, "DOBUTTON btni\n");
+				Trace(3, TRACE_BUTTON_BTNI);
 				hl.palette = btni->btn_coln == 0 ? 0 : pci->hli.btn_colit.btn_coli[btni->btn_coln - 1][0];
 				hl.sy = btni->y_start;
 				hl.ey = btni->y_end;
@@ -2088,10 +2425,10 @@ send_message:
 				int i;
 				if (ddvd_screeninfo_bypp == 1) {
 					msg = DDVD_COLORTABLE_UPDATE;
-					safe_write(message_pipe, &msg, sizeof(int));
+					send_message(playerconfig, msg);
 				}
 				else
-					ddvd_resize_pixmap = &ddvd_resize_pixmap_xbpp; // set resize function
+					playerconfig->resize_pixmap = &ddvd_resize_pixmap_xbpp; // set resize function
 
 				//CHANGE COLORMAP from highlight data, used in ddvd_blit_to_argb()
 				for (i = 0; i < 4; i++) {
@@ -2099,71 +2436,71 @@ send_message:
 					struct ddvd_color colnew;
 					tmp = ((hl.palette) >> (16 + 4 * i)) & 0xf;
 					tmp2 = ((hl.palette) >> (4 * i)) & 0xf;
-					colnew.blue = ddvd_bl[i + 252] = ddvd_bl[tmp];
-					colnew.green = ddvd_gn[i + 252] = ddvd_gn[tmp];
-					colnew.red = ddvd_rd[i + 252] = ddvd_rd[tmp];
-					colnew.trans = ddvd_tr[i + 252] = (0xF - tmp2) * 0x1111;
+					colnew.blue = playerconfig->bl[i + 252] = playerconfig->bl[tmp];
+					colnew.green = playerconfig->gn[i + 252] = playerconfig->gn[tmp];
+					colnew.red = playerconfig->rd[i + 252] = playerconfig->rd[tmp];
+					colnew.trans = playerconfig->tr[i + 252] = (0xF - tmp2) * 0x1111;
 					if (ddvd_screeninfo_bypp == 1)
-						safe_write(message_pipe, &colnew, sizeof(struct ddvd_color));
+						send_message_data(playerconfig, &colnew, sizeof(struct ddvd_color));
 				}
 				msg = DDVD_NULL;
 
-				memset(ddvd_lbb2, 0, ddvd_screeninfo_stride * ddvd_screeninfo_yres);	//clear backbuffer ..
-				Debug(4, "        clear ddvd_lbb2, backbuffer, new button to come\n");
+				memset(playerconfig->lbb2, 0, playerconfig->screeninfo_stride * playerconfig->screeninfo_yres);	//clear backbuffer ..
+				Trace(4, TRACE_BUTTON_CLEAR);
 				//copy button into screen
+				stage_start = ddvd_stats_clock();
 				for (i = hl.sy; i < hl.ey; i++) {
 					if (ddvd_screeninfo_bypp == 1)
-						memcpy(ddvd_lbb2 + hl.sx + 720 * i,
-								ddvd_lbb + hl.sx + 720 * i, hl.ex - hl.sx);
+						memcpy(playerconfig->lbb2 + hl.sx + 720 * i,
+								playerconfig->lbb + hl.sx + 720 * i, hl.ex - hl.sx);
 					else
-						ddvd_blit_to_argb(ddvd_lbb2 + (hl.sx + 720 * i) * ddvd_screeninfo_bypp,
-											ddvd_lbb + hl.sx + 720 * i, hl.ex - hl.sx);
+						ddvd_blit_to_argb(playerconfig, playerconfig->lbb2 + (hl.sx + 720 * i) * ddvd_screeninfo_bypp,
+											playerconfig->lbb + hl.sx + 720 * i, hl.ex - hl.sx);
 				}
+				ddvd_stats_time(&playerconfig->stats, DDVD_STAGE_BLIT, stage_start, NULL, 0);
 				blit_area.x_start = hl.sx;
 				blit_area.x_end = hl.ex;
 				blit_area.y_start = hl.sy;
 				blit_area.y_end = hl.ey;
 				draw_osd = 1;
-				Debug(3, "BUT new bbox: %dx%d %dx%d\n",
-						blit_area.x_start, blit_area.y_start,
-						blit_area.x_end, blit_area.y_end);
+				Trace(3, TRACE_BUTTON_BBOX, blit_area.x_start, blit_area.y_start, blit_area.x_end, blit_area.y_end);
 			}
 			else {
-				Debug(3, "DOBUTTON no info - no drawing!\n");
+				Trace(3, TRACE_BUTTON_NONE);
 				draw_osd = 0;
 			}
 		}
 
-		if (ddvd_clear_screen) {
-			Debug(3, "DODRAW DRAW clear screen area: %dx%d %dx%d\n",
-					last_blit_area.x_start, last_blit_area.y_start,
-					last_blit_area.x_end, last_blit_area.y_end);
-			memset(p_lfb, 0, ddvd_screeninfo_stride * ddvd_screeninfo_yres);	//clear screen ..
+		if (playerconfig->clear_screen) {
+			Trace(3, TRACE_DRAW_CLEAR, last_blit_area.x_start, last_blit_area.y_start, last_blit_area.x_end, last_blit_area.y_end);
+			memset(p_lfb, 0, playerconfig->screeninfo_stride * playerconfig->screeninfo_yres);	//clear screen ..
 			msg = DDVD_SCREEN_UPDATE;
-			safe_write(message_pipe, &msg, sizeof(int));
-			safe_write(message_pipe, &last_blit_area, sizeof(struct ddvd_resize_return));
-			ddvd_clear_screen = 0;
+			send_message(playerconfig, msg);
+			send_message_data(playerconfig, &last_blit_area, sizeof(struct ddvd_resize_return));
+			playerconfig->clear_screen = 0;
 		}
 		if (draw_osd) {
-			Debug(3, "DODRAW DRAW button/subtitle at: %dx%d %dx%d\n", blit_area.x_start, blit_area.y_start, blit_area.x_end, blit_area.y_end);
+			Trace(3, TRACE_DRAW, blit_area.x_start, blit_area.y_start, blit_area.x_end, blit_area.y_end);
 			int y_source = ddvd_have_ntsc ? 480 : 576; // correct ntsc overlay
-			int x_offset = calc_x_scale_offset(dvd_aspect, tv_mode, tv_mode2, tv_aspect);
-			int y_offset = calc_y_scale_offset(dvd_aspect, tv_mode, tv_mode2, tv_aspect);
+			int x_offset = calc_x_scale_offset(playerconfig, dvd_aspect, tv_mode, tv_mode2, tv_aspect);
+			int y_offset = calc_y_scale_offset(playerconfig, dvd_aspect, tv_mode, tv_mode2, tv_aspect);
 			int resized = 0;
 
-			if ((x_offset != 0 || y_offset != 0 || y_source != ddvd_screeninfo_yres ||
-				ddvd_screeninfo_xres != 720) && !playerconfig->canscale) {
+			if ((x_offset != 0 || y_offset != 0 || y_source != playerconfig->screeninfo_yres ||
+				playerconfig->screeninfo_xres != 720) && !playerconfig->canscale) {
 				// decide which resize routine we should use
 				// on 4bpp mode we use bicubic resize for sd skins because we get much better results
 				// with subtitles and the speed is ok for hd skins we use nearest neighbor resize because
 				// upscaling to hd is too slow with bicubic resize
 				//uint64_t start = ddvd_get_time(); // only to print resize stats later on
 				resized = 1;
-				blit_area = ddvd_resize_pixmap(ddvd_lbb2, 720, y_source, ddvd_screeninfo_xres, ddvd_screeninfo_yres,
+				stage_start = ddvd_stats_clock();
+				blit_area = playerconfig->resize_pixmap(playerconfig->lbb2, 720, y_source, playerconfig->screeninfo_xres, playerconfig->screeninfo_yres,
 												x_offset, y_offset, blit_area.x_start, blit_area.x_end,
 												blit_area.y_start, blit_area.y_end, ddvd_screeninfo_bypp);
+				ddvd_stats_time(&playerconfig->stats, DDVD_STAGE_BLIT, stage_start, NULL, 0);
 				//Debug(4, "needed time for resizing: %d ms\n", (int)(ddvd_get_time() - start));
-				Debug(4, "resized to: %dx%d %dx%d\n", blit_area.x_start, blit_area.y_start, blit_area.x_end, blit_area.y_end);
+				Trace(4, TRACE_RESIZED, blit_area.x_start, blit_area.y_start, blit_area.x_end, blit_area.y_end);
 			}
 
 			if (resized) {
@@ -2175,15 +2512,15 @@ send_message:
 			else {
 				blit_area.x_offset = x_offset;
 				blit_area.y_offset = y_offset;
-				blit_area.width = ddvd_screeninfo_xres;
-				blit_area.height = ddvd_screeninfo_yres;
+				blit_area.width = playerconfig->screeninfo_xres;
+				blit_area.height = playerconfig->screeninfo_yres;
 			}
-			memcpy(p_lfb, ddvd_lbb2, ddvd_screeninfo_xres * ddvd_screeninfo_yres * ddvd_screeninfo_bypp); //copy backbuffer into screen
-			Debug(4, "fill p_lfb from ddvd_lbb2, backbuffer with new button/subtitle\n");
+			memcpy(p_lfb, playerconfig->lbb2, playerconfig->screeninfo_xres * playerconfig->screeninfo_yres * ddvd_screeninfo_bypp); //copy backbuffer into screen
+			Trace(4, TRACE_DRAW_FILL);
 			int msg_old = msg; // Save and restore msg it may not be empty
 			msg = DDVD_SCREEN_UPDATE;
-			safe_write(message_pipe, &msg, sizeof(int));
-			safe_write(message_pipe, &blit_area, sizeof(struct ddvd_resize_return));
+			send_message(playerconfig, msg);
+			send_message_data(playerconfig, &blit_area, sizeof(struct ddvd_resize_return));
 			memcpy(&last_blit_area, &blit_area, sizeof(struct ddvd_resize_return)); // safe blit area for next wipe
 			msg = msg_old;
 			draw_osd = 0;
@@ -2191,18 +2528,18 @@ send_message:
 		}
 
 		// final menu status check
-		if (in_menu && !playerconfig->in_menu && (dvdnav_is_domain_vmgm(dvdnav) || dvdnav_is_domain_vtsm(dvdnav))) {
+		if (in_menu && !playerconfig->in_menu && (dvdnav_is_domain_vmgm(playerconfig->dvdnav) || dvdnav_is_domain_vtsm(playerconfig->dvdnav))) {
 			int bla = DDVD_MENU_OPENED;
-			safe_write(message_pipe, &bla, sizeof(int));
+			send_message(playerconfig, bla);
 			playerconfig->in_menu = 1;
-			Debug(3, "MENU_OPENED vpts=%llu, pts=%llu highlight=%d!!!\n", vpts, pts, have_highlight);
+			Trace(3, TRACE_MENU_OPENED, vpts, pts, have_highlight);
 		}
-		else if (playerconfig->in_menu && !(dvdnav_is_domain_vmgm(dvdnav) || dvdnav_is_domain_vtsm(dvdnav))) {
+		else if (playerconfig->in_menu && !(dvdnav_is_domain_vmgm(playerconfig->dvdnav) || dvdnav_is_domain_vtsm(playerconfig->dvdnav))) {
 			int bla = DDVD_MENU_CLOSED;
-			safe_write(message_pipe, &bla, sizeof(int));
+			send_message(playerconfig, bla);
 			playerconfig->in_menu = 0;
 			in_menu = 0;
-			Debug(3, "MENU_CLOSED vpts=%llu, pts=%llu highlight=%d!!!\n", vpts, pts, have_highlight);
+			Trace(3, TRACE_MENU_CLOSED, vpts, pts, have_highlight);
 		}
 
 		// report audio info
@@ -2210,33 +2547,38 @@ send_message:
 			if (playerconfig->audio_format[audio_id] > -1) {
 				uint16_t audio_lang = 0xFFFF;
 				int audio_id_logical;
-				audio_id_logical = dvdnav_get_audio_logical_stream(dvdnav, audio_id);
-				audio_lang = dvdnav_audio_stream_to_lang(dvdnav, audio_id_logical);
+				audio_id_logical = dvdnav_get_audio_logical_stream(playerconfig->dvdnav, audio_id);
+				audio_lang = dvdnav_audio_stream_to_lang(playerconfig->dvdnav, audio_id_logical);
 				if (audio_lang == 0xFFFF)
 					audio_lang = 0x2D2D;
 				int msg_old = msg; // Save and restore msg it may not bee empty
 				msg = DDVD_SHOWOSD_AUDIO;
-				safe_write(message_pipe, &msg, sizeof(int));
-				safe_write(message_pipe, &audio_id, sizeof(int));
-				safe_write(message_pipe, &audio_lang, sizeof(uint16_t));
-				safe_write(message_pipe, &playerconfig->audio_format[audio_id], sizeof(int));
+				send_message(playerconfig, msg);
+				send_message_data(playerconfig, &audio_id, sizeof(int));
+				send_message_data(playerconfig, &audio_lang, sizeof(uint16_t));
+				send_message_data(playerconfig, &playerconfig->audio_format[audio_id], sizeof(int));
 				msg = msg_old;
 				report_audio_info = 0;
 			}
 		}
 
 		//Userinput
-		if (ddvd_wait_for_user && !ddvd_wait_highlight) {
-			Debug(3, "Waiting for keypress - %spaused, vpts=%llu pts=%llu menu=%d playermenu=%d\n", ddvd_playmode & PAUSE ? "" : "not ", vpts, pts, in_menu, playerconfig->in_menu);
+		if (playerconfig->wait_for_user && !ddvd_wait_highlight) {
+			Trace(3, TRACE_WAIT_KEY, !!(playerconfig->playmode & PAUSE), vpts, pts, in_menu, playerconfig->in_menu);
 			struct pollfd pfd[1];	// Make new pollfd array
 			pfd[0].fd = key_pipe;
 			pfd[0].events = POLLIN | POLLPRI | POLLERR;
 			poll(pfd, 1, -1);
-			if (!(ddvd_playmode & PAUSE)) // start looping again
-				ddvd_wait_for_user = 0;
+			if (!(playerconfig->playmode & PAUSE)) // start looping again
+				playerconfig->wait_for_user = 0;
 		}
+handle_keys:
 		if (ddvd_readpipe(key_pipe, &rccode, sizeof(int), 0) == sizeof(int)) {
 			int keydone = 1;
+			// keys that jump around with dvdnav wait for the block being read, the rest does not
+			int nav_locked = ddvd_key_navigates(rccode);
+			if (nav_locked)
+				ddvd_reader_lock(reader);
 			Debug(2, "Got key %d menu %d playermenu %d\n", rccode, in_menu, playerconfig->in_menu);
 			switch (rccode) { // Actions inside and outside of menu
 				case DDVD_SET_MUTE:
@@ -2247,10 +2589,12 @@ send_message:
 					break;
 				case DDVD_KEY_MENU: // Dream
 				case DDVD_KEY_AUDIOMENU: // Audio
-					if (dvdnav_menu_call(dvdnav, rccode == DDVD_KEY_MENU ? DVD_MENU_Root : DVD_MENU_Audio) == DVDNAV_STATUS_OK) {
-						ddvd_play_empty(TRUE);
+					// a title started directly (main feature, resume) may have no root menu in its title set
+					if (dvdnav_menu_call(playerconfig->dvdnav, rccode == DDVD_KEY_MENU ? DVD_MENU_Root : DVD_MENU_Audio) == DVDNAV_STATUS_OK ||
+						(rccode == DDVD_KEY_MENU && dvdnav_menu_call(playerconfig->dvdnav, DVD_MENU_Title) == DVDNAV_STATUS_OK)) {
+						ddvd_play_empty(playerconfig, TRUE);
 						ddvd_spu_play = ddvd_spu_ind; // Skip remaining subtitles
-						ddvd_playmode = PLAY;
+						playerconfig->playmode = PLAY;
 						goto key_play;
 					}
 					break;
@@ -2258,7 +2602,7 @@ send_message:
 					keydone = 0;
 					break;
 			}
-			if (ddvd_playmode & PAUSE) {
+			if (playerconfig->playmode & PAUSE) {
 				switch (rccode) {    // Actions in PAUSE mode
 					case DDVD_KEY_PLAY:
 					case DDVD_KEY_PAUSE:
@@ -2275,19 +2619,19 @@ send_message:
 						steppts = pts;
 						Debug(3, "STEP mode on. play till %lld now %lld\n", steppts, pts);
 						msg = DDVD_SHOWOSD_STATE_PLAY;
-						safe_write(message_pipe, &msg, sizeof(int));
-						ddvd_wait_for_user = 0;
-						ddvd_playmode = STEP;
+						send_message(playerconfig, msg);
+						playerconfig->wait_for_user = 0;
+						playerconfig->playmode = STEP;
 						keydone = 1;
-						if (ioctl(ddvd_fdaudio, AUDIO_CONTINUE) < 0)
-							Perror("AUDIO_CONTINUE");
-						if (ioctl(ddvd_fdvideo, VIDEO_CONTINUE) < 0)
+						ddvd_audio_continue(playerconfig);
+						if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_CONTINUE) < 0)
 							Perror("VIDEO_CONTINUE");
 						break;
 					case DDVD_KEY_FASTFWD:
 					case DDVD_KEY_FASTBWD:
 					case DDVD_SKIP_FWD:
 					case DDVD_SKIP_BWD:
+					case DDVD_SEEK_ABS:
 					case DDVD_SET_TITLE:
 					case DDVD_SET_CHAPTER:
 						// we must empty the pipe here... and fall through
@@ -2300,27 +2644,27 @@ send_message:
 
 			if (!keydone && playerconfig->in_menu) {
 				if (!pci) // should not happen! Must be set when SPU is processed
-					pci = dvdnav_get_current_nav_pci(dvdnav);
+					pci = &reader->pci;
 				switch (rccode) {	// Actions inside a Menu
 					case DDVD_KEY_UP:	//Up
-						dvdnav_upper_button_select(dvdnav, pci);
+						dvdnav_upper_button_select(playerconfig->dvdnav, pci);
 						break;
 					case DDVD_KEY_DOWN:	//Down
-						dvdnav_lower_button_select(dvdnav, pci);
+						dvdnav_lower_button_select(playerconfig->dvdnav, pci);
 						break;
 					case DDVD_KEY_LEFT:	//left
-						dvdnav_left_button_select(dvdnav, pci);
+						dvdnav_left_button_select(playerconfig->dvdnav, pci);
 						break;
 					case DDVD_KEY_RIGHT:	//right
-						dvdnav_right_button_select(dvdnav, pci);
+						dvdnav_right_button_select(playerconfig->dvdnav, pci);
 						break;
 					case DDVD_KEY_OK:	//OK
 						Debug(3, "'OK' clear screen, clear buttons\n");
-						ddvd_wait_for_user = 0;
-						ddvd_play_empty(TRUE);
-						if (ddvd_wait_timer_active)
-							ddvd_wait_timer_active = 0;
-						dvdnav_button_activate(dvdnav, pci);
+						playerconfig->wait_for_user = 0;
+						ddvd_play_empty(playerconfig, TRUE);
+						if (playerconfig->wait_timer_active)
+							playerconfig->wait_timer_active = 0;
+						dvdnav_button_activate(playerconfig->dvdnav, pci);
 						in_menu = 0; // expext a new SPU packet to enable menus again
 						break;
 					case DDVD_KEY_EXIT:	//Exit
@@ -2337,6 +2681,7 @@ send_message:
 						break;
 					case DDVD_SKIP_FWD:
 					case DDVD_SKIP_BWD:
+					case DDVD_SEEK_ABS:
 					case DDVD_SET_TITLE:
 					case DDVD_SET_CHAPTER:
 						// we must empty the pipe here...
@@ -2354,8 +2699,8 @@ send_message:
 					case DDVD_KEY_RIGHT:
 					{
 						int titleNo, totalChapters, chapterNo;
-						dvdnav_current_title_info(dvdnav, &titleNo, &chapterNo);
-						dvdnav_get_number_of_parts(dvdnav, titleNo, &totalChapters);
+						dvdnav_current_title_info(playerconfig->dvdnav, &titleNo, &chapterNo);
+						dvdnav_get_number_of_parts(playerconfig->dvdnav, titleNo, &totalChapters);
 						if (rccode == DDVD_SET_CHAPTER)
 							ddvd_readpipe(key_pipe, &chapterNo, sizeof(int), 1);
 						else if (rccode == DDVD_KEY_PREV_CHAPTER || rccode == DDVD_KEY_LEFT)
@@ -2367,8 +2712,8 @@ send_message:
 						if (chapterNo <= 0)
 							chapterNo = totalChapters;
 						Debug(1, "DDVD_SET_CHAPTER %d/%d in title %d\n", chapterNo, totalChapters, titleNo);
-						ddvd_play_empty(TRUE);
-						dvdnav_part_play(dvdnav, titleNo, chapterNo);
+						ddvd_play_empty(playerconfig, TRUE);
+						dvdnav_part_play(playerconfig->dvdnav, titleNo, chapterNo);
 						msg = DDVD_SHOWOSD_TIME;
 						Debug(1, "                 clr spu frame spu_nr=%d->%d\n", ddvd_spu_play, ddvd_spu_ind);
 						ddvd_spu_play = ddvd_spu_ind; // skip remaining subtitles
@@ -2381,8 +2726,8 @@ send_message:
 					case DDVD_KEY_UP:
 					{
 						int titleNo, totalTitles, chapterNo;
-						dvdnav_current_title_info(dvdnav, &titleNo, &chapterNo);
-						dvdnav_get_number_of_titles(dvdnav, &totalTitles);
+						dvdnav_current_title_info(playerconfig->dvdnav, &titleNo, &chapterNo);
+						dvdnav_get_number_of_titles(playerconfig->dvdnav, &totalTitles);
 						if (rccode == DDVD_SET_TITLE)
 							ddvd_readpipe(key_pipe, &titleNo, sizeof(int), 1);
 						else if (rccode == DDVD_KEY_PREV_TITLE || rccode == DDVD_KEY_DOWN)
@@ -2394,8 +2739,8 @@ send_message:
 						if (titleNo <= 0)
 							titleNo = totalTitles;
 						Debug(1, "DDVD_SET_TITLE %d/%d\n", titleNo, totalTitles);
-						ddvd_play_empty(TRUE);
-						dvdnav_part_play(dvdnav, titleNo, 1);
+						ddvd_play_empty(playerconfig, TRUE);
+						dvdnav_part_play(playerconfig->dvdnav, titleNo, 1);
 						msg = DDVD_SHOWOSD_TIME;
 						Debug(1, "                 clr spu frame spu_nr=%d->%d\n", ddvd_spu_play, ddvd_spu_ind);
 						ddvd_spu_play = ddvd_spu_ind; // skip remaining subtitles
@@ -2403,71 +2748,70 @@ send_message:
 					}
 					case DDVD_KEY_PAUSE:	// Pause
 					{
-						Debug(3, "DDVD_KEY_PAUSE on %s\n", ddvd_playmode & PLAY ? "play" : "pause");
-						if (ddvd_playmode == PLAY) { // no bitfield check, need real pause here
-							ddvd_playmode = PAUSE;
-							if (ioctl(ddvd_fdaudio, AUDIO_PAUSE) < 0)
+						Debug(3, "DDVD_KEY_PAUSE on %s\n", playerconfig->playmode & PLAY ? "play" : "pause");
+						if (playerconfig->playmode == PLAY) { // no bitfield check, need real pause here
+							playerconfig->playmode = PAUSE;
+							if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_PAUSE) < 0)
 								Perror("AUDIO_PAUSE");
-							if (ioctl(ddvd_fdvideo, VIDEO_FREEZE) < 0)
+							if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_FREEZE) < 0)
 								Perror("VIDEO_FREEZE");
-							if (ddvd_trickmode != TOFF) {
-								if (ddvd_trickmode & (FASTFW|FASTBW))
-									if (ioctl(ddvd_fdvideo, VIDEO_FAST_FORWARD, 0))
+							if (playerconfig->trickmode != TOFF) {
+								if (playerconfig->trickmode & (FASTFW|FASTBW))
+									if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_FAST_FORWARD, 0))
 										Perror("VIDEO_FAST_FORWARD");
-								if (ddvd_trickmode & (SLOWFW|SLOWBW))
-									if (ioctl(ddvd_fdvideo, VIDEO_SLOWMOTION, 0) < 0)
+								if (playerconfig->trickmode & (SLOWFW|SLOWBW))
+									if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_SLOWMOTION, 0) < 0)
 										Perror("VIDEO_SLOWMOTION");
 								if (!ismute)
-									if (ioctl(ddvd_fdaudio, AUDIO_SET_MUTE, 0) < 0)
+									if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_SET_MUTE, 0) < 0)
 										Perror("AUDIO_SET_MUTE");
-								ddvd_trickmode = TOFF;
-								ddvd_trickspeed = 0;
+								playerconfig->trickmode = TOFF;
+								playerconfig->trickspeed = 0;
 							}
 
 							msg = DDVD_SHOWOSD_STATE_PAUSE;
-							safe_write(message_pipe, &msg, sizeof(int));
-							ddvd_wait_for_user = 1; // don't waste cpu during pause
+							send_message(playerconfig, msg);
+							playerconfig->wait_for_user = 1; // don't waste cpu during pause
 							break;
 						}
-						else if (ddvd_playmode != PAUSE) // no bitfield check, need may be play+pause
+						else if (playerconfig->playmode != PAUSE) // no bitfield check, need may be play+pause
 							break;
 						// fall through to PLAY
 					}
 					case DDVD_KEY_PLAY:	// Play
 					{
-						Debug(3, "DDVD_KEY_PLAY on %s\n", ddvd_playmode & PLAY ? "play" : "pause fallthrough");
-						if (ddvd_playmode & PAUSE || ddvd_trickmode != TOFF) {
-							if (ddvd_playmode & PAUSE)
-								ddvd_wait_for_user = 0;
-							ddvd_playmode = PLAY;
+						Debug(3, "DDVD_KEY_PLAY on %s\n", playerconfig->playmode & PLAY ? "play" : "pause fallthrough");
+						if (playerconfig->playmode & PAUSE || playerconfig->trickmode != TOFF) {
+							if (playerconfig->playmode & PAUSE)
+								playerconfig->wait_for_user = 0;
+							playerconfig->playmode = PLAY;
 key_play:
 #if CONFIG_API_VERSION == 1
-							ddvd_device_clear();
+							ddvd_device_clear(playerconfig);
 #endif
-							if (ddvd_trickmode & (FASTFW|FASTBW)) {
+							if (playerconfig->trickmode & (FASTFW|FASTBW)) {
 								Debug(3, "DDVD_KEY_PLAY reset fast forward\n");
-								if (ioctl(ddvd_fdvideo, VIDEO_FAST_FORWARD, 0))
+								if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_FAST_FORWARD, 0))
 									Perror("VIDEO_FAST_FORWARD");
 							}
-							if (ddvd_trickmode & (SLOWFW|SLOWBW)) {
+							if (playerconfig->trickmode & (SLOWFW|SLOWBW)) {
 								Debug(3, "DDVD_KEY_PLAY reset slow motion\n");
-								if (ioctl(ddvd_fdvideo, VIDEO_SLOWMOTION, 0) < 0)
+								if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_SLOWMOTION, 0) < 0)
 									Perror("VIDEO_SLOWMOTION");
 							}
-							if (ddvd_trickmode != TOFF && !ismute)
-								if (ioctl(ddvd_fdaudio, AUDIO_SET_MUTE, 0) < 0)
+							if (playerconfig->trickmode != TOFF && !ismute)
+								if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_SET_MUTE, 0) < 0)
 									Perror("AUDIO_SET_MUTE");
-							if (ddvd_playmode & PLAY || ddvd_trickmode & (FASTFW|FASTBW|SLOWFW|SLOWBW)) {
+							if (playerconfig->playmode & PLAY || playerconfig->trickmode & (FASTFW|FASTBW|SLOWFW|SLOWBW)) {
 								Debug(3, "DDVD_KEY_PLAY cont audio and video\n");
-								if (ioctl(ddvd_fdaudio, AUDIO_CONTINUE) < 0)
-									Perror("AUDIO_CONTINUE");
-								if (ioctl(ddvd_fdvideo, VIDEO_CONTINUE) < 0)
+								ddvd_audio_continue(playerconfig);
+								if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_CONTINUE) < 0)
 									Perror("VIDEO_CONTINUE");
 								msg = DDVD_SHOWOSD_STATE_PLAY;
-								safe_write(message_pipe, &msg, sizeof(int));
+								send_message(playerconfig, msg);
 							}
-							ddvd_trickmode = TOFF;
-							ddvd_trickspeed = 0;
+							playerconfig->trickmode = TOFF;
+							playerconfig->trickspeed = 0;
 							msg = DDVD_SHOWOSD_TIME;
 						}
 						break;
@@ -2477,9 +2821,9 @@ key_play:
 						Debug(1, "DDVD_KEY_EXIT (save resume info)\n");
 						int resume_title, resume_chapter; //safe resume info
 						uint32_t resume_block, total_block;
-						if (dvdnav_current_title_info(dvdnav, &resume_title, &resume_chapter) &&
+						if (dvdnav_current_title_info(playerconfig->dvdnav, &resume_title, &resume_chapter) &&
 							resume_title != 0 &&
-							dvdnav_get_position (dvdnav, &resume_block, &total_block) == DVDNAV_STATUS_OK) {
+							ddvd_reader_position(reader, &resume_block, &total_block) == DVDNAV_STATUS_OK) {
 								playerconfig->resume_title = resume_title;
 								playerconfig->resume_chapter = resume_chapter;
 								playerconfig->resume_block = resume_block;
@@ -2495,119 +2839,123 @@ key_play:
 					}
 					case DDVD_KEY_SLOWFWD:
 					case DDVD_KEY_SLOWBWD:
-						ddvd_readpipe(key_pipe, &ddvd_trickspeed, sizeof(int), 1);
-						if (ddvd_trickspeed <= 0) // no slow backward yet
+						ddvd_readpipe(key_pipe, &playerconfig->trickspeed, sizeof(int), 1);
+						if (playerconfig->trickspeed <= 0) // no slow backward yet
 							goto key_play;
-						if (!(ddvd_trickmode & SLOWFW)) {
-							if (ddvd_trickmode & (FASTFW|FASTBW)) {
-								if (ioctl(ddvd_fdvideo, VIDEO_FAST_FORWARD, 0))
+						if (!(playerconfig->trickmode & SLOWFW)) {
+							if (playerconfig->trickmode & (FASTFW|FASTBW)) {
+								if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_FAST_FORWARD, 0))
 									Perror("VIDEO_FAST_FORWARD");
 							}
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_MUTE, 1) < 0)
+							if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_SET_MUTE, 1) < 0)
 								Perror("AUDIO_SET_MUTE");
-							ddvd_trickmode = SLOWFW;
+							playerconfig->trickmode = SLOWFW;
 						}
-						if (ioctl(ddvd_fdvideo, VIDEO_SLOWMOTION, ddvd_trickspeed) < 0)
-							Debug(1, "VIDEO_SLOWMOTION(%d) failed\n", ddvd_trickspeed);
-						if (ioctl(ddvd_fdvideo, VIDEO_CONTINUE) < 0)
+						if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_SLOWMOTION, playerconfig->trickspeed) < 0)
+							Debug(1, "VIDEO_SLOWMOTION(%d) failed\n", playerconfig->trickspeed);
+						if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_CONTINUE) < 0)
 							Perror("VIDEO_CONTINUE");
-						if (ddvd_playmode == PAUSE) {
-							ddvd_playmode = PLAY;
-							ddvd_wait_for_user = 0;
-							if (ioctl(ddvd_fdaudio, AUDIO_CONTINUE) < 0)
-								Perror("AUDIO_CONTINUE");
+						if (playerconfig->playmode == PAUSE) {
+							playerconfig->playmode = PLAY;
+							playerconfig->wait_for_user = 0;
+							ddvd_audio_continue(playerconfig);
 						}
-						Debug(3, "SLOW%cWD speed %dx\n", ddvd_trickmode & SLOWFW ? 'F' : 'B', ddvd_trickspeed);
-						msg = ddvd_trickmode & (SLOWFW) ? DDVD_SHOWOSD_STATE_SFWD : DDVD_SHOWOSD_STATE_SBWD;
+						Debug(3, "SLOW%cWD speed %dx\n", playerconfig->trickmode & SLOWFW ? 'F' : 'B', playerconfig->trickspeed);
+						msg = playerconfig->trickmode & (SLOWFW) ? DDVD_SHOWOSD_STATE_SFWD : DDVD_SHOWOSD_STATE_SBWD;
 						break;
 					case DDVD_KEY_FASTFWD:
 					case DDVD_KEY_FASTBWD:
-						ddvd_readpipe(key_pipe, &ddvd_trickspeed, sizeof(int), 1);
-						Debug(3, "FAST%cWD speed %dx\n", ddvd_trickmode & (TRICKFW|FASTFW) ? 'F' : 'B', ddvd_trickspeed);
-						if (ddvd_trickspeed == 0)
+						ddvd_readpipe(key_pipe, &playerconfig->trickspeed, sizeof(int), 1);
+						Debug(3, "FAST%cWD speed %dx\n", playerconfig->trickmode & (TRICKFW|FASTFW) ? 'F' : 'B', playerconfig->trickspeed);
+						if (playerconfig->trickspeed == 0)
 							goto key_play;
-						if (!(ddvd_trickmode & (FASTFW|FASTBW|TRICKFW|TRICKBW))) {
-							if (ddvd_trickmode & (SLOWFW|SLOWBW)) {
-								if (ioctl(ddvd_fdvideo, VIDEO_SLOWMOTION, 0) < 0)
+						if (!(playerconfig->trickmode & (FASTFW|FASTBW|TRICKFW|TRICKBW))) {
+							if (playerconfig->trickmode & (SLOWFW|SLOWBW)) {
+								if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_SLOWMOTION, 0) < 0)
 									Perror("VIDEO_SLOWMOTION");
 							}
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_MUTE, 1) < 0)
+							if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_SET_MUTE, 1) < 0)
 								Perror("AUDIO_SET_MUTE");
 						}
 						// determine if flip to/from driver (smooth) or trick fast forward
-						if (ddvd_trickspeed > 0 && ddvd_trickspeed < 7) { // higher speeds cannot be handled reliably by driver
-							ddvd_trickmode = FASTFW;
-							if (ioctl(ddvd_fdvideo, VIDEO_FAST_FORWARD, ddvd_trickspeed) < 0)
+						if (playerconfig->trickspeed > 0 && playerconfig->trickspeed < 7) { // higher speeds cannot be handled reliably by driver
+							playerconfig->trickmode = FASTFW;
+							if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_FAST_FORWARD, playerconfig->trickspeed) < 0)
 								Perror("VIDEO_FAST_FORWARD");
-							if (ioctl(ddvd_fdvideo, VIDEO_CONTINUE) < 0)
+							if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_CONTINUE) < 0)
 								Perror("VIDEO_CONTINUE");
 						}
 						else {
-							if (ddvd_trickmode & FASTFW) {
-								if (ioctl(ddvd_fdvideo, VIDEO_FAST_FORWARD, 0) < 0)
+							if (playerconfig->trickmode & FASTFW) {
+								if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_FAST_FORWARD, 0) < 0)
 									Perror("VIDEO_FAST_FORWARD");
-								if (ioctl(ddvd_fdvideo, VIDEO_CONTINUE) < 0)
+								if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_CONTINUE) < 0)
 									Perror("VIDEO_CONTINUE");
 							}
-							ddvd_trickmode = (ddvd_trickspeed < 0 ? TRICKBW : TRICKFW);
+							playerconfig->trickmode = (playerconfig->trickspeed < 0 ? TRICKBW : TRICKFW);
 						}
-						Debug(3, "FAST%cWD speed %dx\n", ddvd_trickmode & (TRICKFW|FASTFW) ? 'F' : 'B', ddvd_trickspeed);
-						msg = ddvd_trickmode & (TRICKBW|FASTBW) ? DDVD_SHOWOSD_STATE_FBWD : DDVD_SHOWOSD_STATE_FFWD;
+						Debug(3, "FAST%cWD speed %dx\n", playerconfig->trickmode & (TRICKFW|FASTFW) ? 'F' : 'B', playerconfig->trickspeed);
+						msg = playerconfig->trickmode & (TRICKBW|FASTBW) ? DDVD_SHOWOSD_STATE_FBWD : DDVD_SHOWOSD_STATE_FFWD;
 						break;
 					case DDVD_KEY_FFWD:	//FastForward
 					case DDVD_KEY_FBWD:	//FastBackward
 					{
-						if (ddvd_trickmode == TOFF) {
-							if (ioctl(ddvd_fdaudio, AUDIO_SET_MUTE, 1) < 0)
+						if (playerconfig->trickmode == TOFF) {
+							if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_SET_MUTE, 1) < 0)
 								Perror("AUDIO_SET_MUTE");
-							ddvd_trickspeed = 2;
-							ddvd_trickmode = (rccode == DDVD_KEY_FBWD ? TRICKBW : FASTFW);
+							playerconfig->trickspeed = 2;
+							playerconfig->trickmode = (rccode == DDVD_KEY_FBWD ? TRICKBW : FASTFW);
 						}
-						else if (ddvd_trickmode & (rccode == DDVD_KEY_FBWD ? (TRICKFW|FASTFW) : TRICKBW)) {
-							ddvd_trickspeed /= 2;
-							if (ddvd_trickspeed == 1) {
-								ddvd_trickspeed = 0;
+						else if (playerconfig->trickmode & (rccode == DDVD_KEY_FBWD ? (TRICKFW|FASTFW) : TRICKBW)) {
+							playerconfig->trickspeed /= 2;
+							if (playerconfig->trickspeed == 1) {
+								playerconfig->trickspeed = 0;
 								goto key_play;
 							}
 						}
-						else if (ddvd_trickspeed < 64)
-							ddvd_trickspeed *= 2;
-
-						Debug(3, "FAST%cWD speed %dx\n", ddvd_trickmode & (TRICKFW|FASTFW) ? 'F' : 'B', ddvd_trickspeed);
-						if (ddvd_trickmode & (TRICKFW|FASTFW)) {
-							if (ddvd_trickspeed < 7) { // higher speeds cannot be handled reliably by driver
-								ddvd_trickmode = FASTFW; // Driver fast forward
-								if (ioctl(ddvd_fdvideo, VIDEO_FAST_FORWARD, ddvd_trickspeed) < 0)
+						else if (playerconfig->trickspeed < 64)
+							playerconfig->trickspeed *= 2;
+
+						Debug(3, "FAST%cWD speed %dx\n", playerconfig->trickmode & (TRICKFW|FASTFW) ? 'F' : 'B', playerconfig->trickspeed);
+						if (playerconfig->trickmode & (TRICKFW|FASTFW)) {
+							if (playerconfig->trickspeed < 7) { // higher speeds cannot be handled reliably by driver
+								playerconfig->trickmode = FASTFW; // Driver fast forward
+								if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_FAST_FORWARD, playerconfig->trickspeed) < 0)
 									Perror("VIDEO_FAST_FORWARD");
-								if (ioctl(ddvd_fdvideo, VIDEO_CONTINUE) < 0)
+								if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_CONTINUE) < 0)
 									Perror("VIDEO_CONTINUE");
 							}
 							else {
-								if (ddvd_trickmode & FASTFW) {
-									if (ioctl(ddvd_fdvideo, VIDEO_FAST_FORWARD, 0) < 0)
+								if (playerconfig->trickmode & FASTFW) {
+									if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_FAST_FORWARD, 0) < 0)
 										Perror("VIDEO_FAST_FORWARD");
-									if (ioctl(ddvd_fdvideo, VIDEO_CONTINUE) < 0)
+									if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_CONTINUE) < 0)
 										Perror("VIDEO_CONTINUE");
 								}
-								ddvd_trickmode = TRICKFW; // Trick fast forward
+								playerconfig->trickmode = TRICKFW; // Trick fast forward
 							}
 						}
-						msg = ddvd_trickmode & (TRICKBW|FASTBW) ? DDVD_SHOWOSD_STATE_FBWD : DDVD_SHOWOSD_STATE_FFWD;
+						msg = playerconfig->trickmode & (TRICKBW|FASTBW) ? DDVD_SHOWOSD_STATE_FBWD : DDVD_SHOWOSD_STATE_FFWD;
 						break;
 					}
 					case DDVD_SKIP_FWD:
 					case DDVD_SKIP_BWD:
+					case DDVD_SEEK_ABS:
 					{
 						int skip;
 						ddvd_readpipe(key_pipe, &skip, sizeof(int), 1);
-						if (ddvd_trickmode != (TRICKFW|TRICKBW)) {
+						if (playerconfig->trickmode != (TRICKFW|TRICKBW)) {
 							uint32_t pos, len;
-							dvdnav_get_position(dvdnav, &pos, &len);
+							ddvd_reader_position(reader, &pos, &len);
 							// 90000 = 1 Sek.
 							if (!len)
 								len = 1;
-							int64_t newpos = pos + (skip * 90000L + (int64_t)(vpts > pts ? pts - vpts : 0)) * (int64_t)len / ddvd_lastCellEventInfo.pgc_length;
-							Debug(3, "DDVD_SKIP skip=%d oldpos=%u len=%u pgc=%lld newpos=%lld vpts=%llu pts=%llu\n", skip, pos, len, ddvd_lastCellEventInfo.pgc_length, newpos, vpts, pts);
+							int64_t newpos;
+							if (rccode == DDVD_SEEK_ABS)
+								newpos = ddvd_seek_block(playerconfig, 0, len, skip * 90000LL);
+							else	// from what the decoder shows, not from what was read ahead
+								newpos = ddvd_seek_block(playerconfig, pos, len, skip * 90000LL - ddvd_timeline_buffered(&playerconfig->timeline));
+							Debug(3, "DDVD_SKIP skip=%d oldpos=%u len=%u pgc=%lld newpos=%lld vpts=%llu pts=%llu\n", skip, pos, len, playerconfig->last_cell_info.pgc_length, newpos, vpts, pts);
 							if (newpos >= len) {	// reached end of movie
 								newpos = len - 250;
 								reached_eof = 1;
@@ -2616,8 +2964,8 @@ key_play:
 								newpos = 0;
 								reached_sof = 1;
 							}
-							dvdnav_sector_search(dvdnav, newpos, SEEK_SET);
-							ddvd_play_empty(1);
+							dvdnav_sector_search(playerconfig->dvdnav, newpos, SEEK_SET);
+							ddvd_play_empty(playerconfig, 1);
 							msg = DDVD_SHOWOSD_TIME;
 							Debug(1, "                 clr spu frame spu_nr=%d->%d\n", ddvd_spu_play, ddvd_spu_ind);
 							ddvd_spu_play = ddvd_spu_ind; // skip remaining subtitles
@@ -2643,9 +2991,15 @@ key_play:
 						}
 						Debug(1, "DDVD_SET_AUDIO %i\n", audio_id);
 						report_audio_info = 1;
-						ddvd_play_empty(TRUE);
 						audio_lock = 1;
-						ddvd_lpcm_count = 0;
+						// only the audio decoder starts over, with the packs of the new stream
+						// from what is shown now on, the video and what was read ahead stay
+						ddvd_audio_clear(playerconfig);
+						if (!(playerconfig->playmode & PAUSE))	// else the play key starts it with the video
+							ddvd_audio_continue(playerconfig);
+						playerconfig->lpcm_count = 0;
+						if (playerconfig->timeline.decoder_valid)
+							ddvd_aring_replay(&playerconfig->arings, audio_id, playerconfig->timeline.decoder_time);
 						break;
 					}
 					case DDVD_KEY_SUBTITLE:	//jump to next spu track
@@ -2672,28 +3026,28 @@ key_play:
 						spu_lock = 1;
 						playerconfig->last_spu_id = spu_index;
 						msg = DDVD_SHOWOSD_SUBTITLE;
-						safe_write(message_pipe, &msg, sizeof(int));
-						safe_write(message_pipe, &spu_index, sizeof(int));
-						safe_write(message_pipe, &spu_lang, sizeof(uint16_t));
+						send_message(playerconfig, msg);
+						send_message_data(playerconfig, &spu_index, sizeof(int));
+						send_message_data(playerconfig, &spu_lang, sizeof(uint16_t));
 						break;
 					}
 					case DDVD_KEY_ANGLE: //change angle
 					case DDVD_GET_ANGLE: //frontend wants angle info
 					{
 						int num = 0, current = 0;
-						dvdnav_get_angle_info(dvdnav, &current, &num);
+						dvdnav_get_angle_info(playerconfig->dvdnav, &current, &num);
 						if (rccode == DDVD_KEY_ANGLE) {
 							if (num != 0) {
 								current++;
 								if (current > num)
 									current = 1;
-								dvdnav_angle_change(dvdnav, current);
+								dvdnav_angle_change(playerconfig->dvdnav, current);
 							}
 						}
 						msg = DDVD_SHOWOSD_ANGLE;
-						safe_write(message_pipe, &msg, sizeof(int));
-						safe_write(message_pipe, &current, sizeof(int));
-						safe_write(message_pipe, &num, sizeof(int));
+						send_message(playerconfig, msg);
+						send_message_data(playerconfig, &current, sizeof(int));
+						send_message_data(playerconfig, &num, sizeof(int));
 						break;
 					}
 					case DDVD_GET_TIME:	// frontend wants actual time
@@ -2703,46 +3057,50 @@ key_play:
 						break;
 				}
 			}
+			if (nav_locked)
+				ddvd_reader_unlock(reader, 0);
 		}
 	}
 
 err_dvdnav:
+	ddvd_sink_flush(sink);	// the queue points into the reader slots
+	ddvd_aring_free(&playerconfig->arings);
+	ddvd_reader_stop(&playerconfig->reader);
+	ddvd_loop_close(&playerconfig->loop);
+	ddvd_tmap_close(&playerconfig->tmap);
 	/* destroy dvdnav handle */
-	if (dvdnav_close(dvdnav) != DVDNAV_STATUS_OK)
-		Debug(1, "Error on dvdnav_close: %s\n", dvdnav_err_to_string(dvdnav));
+	if (dvdnav_close(playerconfig->dvdnav) != DVDNAV_STATUS_OK)
+		Debug(1, "Error on dvdnav_close: %s\n", dvdnav_err_to_string(playerconfig->dvdnav));
+	playerconfig->dvdnav = NULL;
 
 err_dvdnav_open:
-	ddvd_device_clear();
-	if (ioctl(ddvd_fdvideo, VIDEO_SELECT_SOURCE, VIDEO_SOURCE_DEMUX) < 0)
+	ddvd_device_clear(playerconfig);
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_SELECT_SOURCE, VIDEO_SOURCE_DEMUX) < 0)
 		Perror("VIDEO_SELECT_SOURCE");
-	if (ioctl(ddvd_fdaudio, AUDIO_SELECT_SOURCE, AUDIO_SOURCE_DEMUX) < 0)
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_SELECT_SOURCE, AUDIO_SOURCE_DEMUX) < 0)
 		Perror("AUDIO_SELECT_SOURCE");
-	close(ddvd_ac3_fd);
-err_open_ac3_fd:
-	close(ddvd_fdaudio);
-err_open_fdaudio:
-	close(ddvd_fdvideo);
-err_open_fdvideo:
-	close(ddvd_output_fd);
-err_open_output_fd:
+	ddvd_sink_close(sink);
+err_open_output:
 
+	ddvd_mpa_free(playerconfig->mpa);
+	playerconfig->mpa = NULL;
 	if (have_liba52) {
-		a52_free(state);
+		ddvd_a52_free(&playerconfig->a52);
 		ddvd_close_liba52();
 	}
 
 	//Clear Screen
 	blit_area.x_start = blit_area.y_start = 0;
-	blit_area.x_end = ddvd_screeninfo_xres - 1;
-	blit_area.y_end = ddvd_screeninfo_yres - 1;
+	blit_area.x_end = playerconfig->screeninfo_xres - 1;
+	blit_area.y_end = playerconfig->screeninfo_yres - 1;
 	blit_area.x_offset = 0;
 	blit_area.y_offset = 0;
-	blit_area.width = ddvd_screeninfo_xres;
-	blit_area.height = ddvd_screeninfo_yres;
-	memset(p_lfb, 0, ddvd_screeninfo_stride * ddvd_screeninfo_yres);
+	blit_area.width = playerconfig->screeninfo_xres;
+	blit_area.height = playerconfig->screeninfo_yres;
+	memset(p_lfb, 0, playerconfig->screeninfo_stride * playerconfig->screeninfo_yres);
 	msg = DDVD_SCREEN_UPDATE;
-	safe_write(message_pipe, &msg, sizeof(int));
-	safe_write(message_pipe, &blit_area, sizeof(struct ddvd_resize_return));
+	send_message(playerconfig, msg);
+	send_message_data(playerconfig, &blit_area, sizeof(struct ddvd_resize_return));
 
 err_malloc:
 	// clean up
@@ -2752,16 +3110,18 @@ err_malloc:
 		if (ddvd_pci[i] != NULL)
 			free(ddvd_pci[i]);
 	}
-	if (ddvd_lbb != NULL)
-		free(ddvd_lbb);
-	if (ddvd_lbb2 != NULL)
-		free(ddvd_lbb2);
+	if (playerconfig->lbb != NULL)
+		free(playerconfig->lbb);
+	if (playerconfig->lbb2 != NULL)
+		free(playerconfig->lbb2);
+	playerconfig->lbb = playerconfig->lbb2 = NULL;
 	if (last_iframe != NULL)
 		free(last_iframe);
 
-#if CONFIG_API_VERSION == 3
-	ddvd_unset_pcr_offset();
-#endif
+	if (DebugLevel > 2) {	// the player loop events were only recorded, print them now
+		fflush(stdout);
+		ddvd_trace_dump(STDOUT_FILENO);
+	}
 	Debug(1, "EXIT\n");
 	return res;
 }
@@ -2798,6 +3158,35 @@ static int ddvd_readpipe(int pipefd, void *dest, size_t bytes, int blocked_read)
 	return bytes_completed;
 }
 
+// start the longest title, from the disc info of ddvd_probe or read now, returns the title or 0
+static int ddvd_main_feature(struct ddvd *playerconfig)
+{
+	if (!playerconfig->probe_done || playerconfig->probe_result != DDVD_OK) {
+		memset(&playerconfig->disc_info, 0, sizeof(struct ddvd_disc_info));
+		if (ddvd_probe_titles(&playerconfig->tmap, playerconfig->dvd_path, &playerconfig->disc_info) < 0)
+			return 0;
+	}
+
+	int title = ddvd_probe_main_title(&playerconfig->disc_info);
+	if (title == 0 || dvdnav_title_play(playerconfig->dvdnav, title) != DVDNAV_STATUS_OK) {
+		Debug(1, "cannot start the main feature (title %d), going to the menu\n", title);
+		return 0;
+	}
+	return title;
+}
+
+// the resume title and chapter are on the disc
+static int ddvd_resume_valid(struct ddvd *playerconfig)
+{
+	int title_numbers = 0, part_numbers = 0;
+
+	dvdnav_get_number_of_titles(playerconfig->dvdnav, &title_numbers);
+	if (playerconfig->resume_title <= 0 || playerconfig->resume_title > title_numbers)
+		return 0;
+	dvdnav_get_number_of_parts(playerconfig->dvdnav, playerconfig->resume_title, &part_numbers);
+	return playerconfig->resume_chapter > 0 && playerconfig->resume_chapter <= part_numbers;
+}
+
 // get actual playing time
 static struct ddvd_time ddvd_get_osd_time(struct ddvd *playerconfig)
 {
@@ -2808,15 +3197,22 @@ static struct ddvd_time ddvd_get_osd_time(struct ddvd *playerconfig)
 	info.pos_minutes = info.pos_hours = info.pos_seconds = info.pos_chapter = info.pos_title = 0;
 	info.end_minutes = info.end_hours = info.end_seconds = info.end_chapter = 0;
 
-	dvdnav_get_number_of_titles(dvdnav, &info.end_title);
-	dvdnav_current_title_info(dvdnav, &titleNo, &info.pos_chapter);
+	dvdnav_get_number_of_titles(playerconfig->dvdnav, &info.end_title);
+	dvdnav_current_title_info(playerconfig->dvdnav, &titleNo, &info.pos_chapter);
 
 	if (titleNo) {
-		dvdnav_get_number_of_parts(dvdnav, titleNo, &info.end_chapter);
-		dvdnav_get_position_in_title(dvdnav, &pos, &len);
+		dvdnav_get_number_of_parts(playerconfig->dvdnav, titleNo, &info.end_chapter);
+		dvdnav_get_position_in_title(playerconfig->dvdnav, &pos, &len);
 
-		uint64_t len_s = ddvd_lastCellEventInfo.pgc_length / 90000;
-		uint64_t pos_s = ((ddvd_lastCellEventInfo.pgc_length / len) * pos) / 90000;
+		uint64_t len_s, pos_s;
+		if (ddvd_tmap_valid(&playerconfig->tmap, len)) {
+			len_s = playerconfig->tmap.cur->length / 90000;
+			pos_s = ddvd_tmap_time(&playerconfig->tmap, pos) / 90000;
+		}
+		else {
+			len_s = playerconfig->last_cell_info.pgc_length / 90000;
+			pos_s = ((playerconfig->last_cell_info.pgc_length / len) * pos) / 90000;
+		}
 
 		info.pos_seconds = pos_s % 60;
 		info.pos_minutes = (pos_s / 60) % 60;
@@ -2831,6 +3227,21 @@ static struct ddvd_time ddvd_get_osd_time(struct ddvd *playerconfig)
 	return info;
 }
 
+// block offset 90 kHz ticks away from block pos, len is the length of the PGC in blocks
+static int64_t ddvd_seek_block(struct ddvd *playerconfig, uint32_t pos, uint32_t len, int64_t offset)
+{
+	struct ddvd_tmap *tmap = &playerconfig->tmap;
+
+	if (ddvd_tmap_valid(tmap, len)) {
+		int64_t time = (int64_t)ddvd_tmap_time(tmap, pos) + offset;
+		if (time < 0)
+			return -1;
+		return ddvd_tmap_block(tmap, time);
+	}
+	// no time map, assume a constant bitrate
+	return (int64_t)pos + offset * (int64_t)len / playerconfig->last_cell_info.pgc_length;
+}
+
 // video out aspect/scale
 static int ddvd_check_aspect(int dvd_aspect, int dvd_scale_perm, int tv_aspect, int tv_mode)
 {
@@ -2849,7 +3260,7 @@ static int ddvd_check_aspect(int dvd_aspect, int dvd_scale_perm, int tv_aspect,
 }
 
 // get timestamp
-static uint64_t ddvd_get_time(void)
+uint64_t ddvd_get_time(void)
 {
 	static time_t t0 = 0;
 	struct timeval t;
@@ -2863,55 +3274,137 @@ static uint64_t ddvd_get_time(void)
 	return 0;
 }
 
+// ms until the next player timer runs out, 0 when one is due and -1 when none is running
+static int ddvd_next_timeout(struct ddvd *playerconfig, uint64_t now)
+{
+	uint64_t end[4];
+	int n = 0, i, timeout = -1;
+
+	if (playerconfig->wait_timer_active)
+		end[n++] = playerconfig->wait_timer_end;
+	if (playerconfig->spu_timer_active)
+		end[n++] = playerconfig->spu_timer_end;
+	if (playerconfig->trickmode & (TRICKFW | TRICKBW))
+		end[n++] = playerconfig->trick_timer_end;
+	if (playerconfig->playmode & (PLAY | STEP))
+		end[n++] = playerconfig->next_time_update;
+
+	for (i = 0; i < n; i++) {
+		int t = end[i] > now ? (int)(end[i] - now) : 0;
+		if (timeout < 0 || t < timeout)
+			timeout = t;
+	}
+	return timeout;
+}
+
 // Empty all Buffers
-static void ddvd_play_empty(int device_clear)
+static void ddvd_play_empty(struct ddvd *playerconfig, int device_clear)
 {
 	Debug(3, "ddvd_play_empty clear=%d\n", device_clear);
-	ddvd_wait_for_user = 0;
-	ddvd_lpcm_count = 0;
-	ddvd_iframerun = 0;
-	ddvd_still_frame = 0;
-	ddvd_iframesend = 0;
-	ddvd_last_iframe_len = 0;
-	ddvd_spu_ptr = 0;
+	// what was read ahead belongs to the old position as well
+	ddvd_reader_lock(&playerconfig->reader);
+	ddvd_reader_unlock(&playerconfig->reader, 1);
+	playerconfig->wait_for_user = 0;
+	playerconfig->lpcm_count = 0;
+	playerconfig->iframerun = 0;
+	playerconfig->still_frame = 0;
+	playerconfig->iframesend = 0;
+	playerconfig->last_iframe_len = 0;
+	playerconfig->spu_ptr = 0;
 
-	ddvd_wait_timer_active = 0;
-	ddvd_wait_timer_end = 0;
+	playerconfig->wait_timer_active = 0;
+	playerconfig->wait_timer_end = 0;
 
-	ddvd_spu_timer_active = 0;
-	ddvd_spu_timer_end = 0;
+	playerconfig->spu_timer_active = 0;
+	playerconfig->spu_timer_end = 0;
 
-	ddvd_clear_screen = 1;
+	playerconfig->clear_screen = 1;
 
 	if (device_clear)
-		ddvd_device_clear();
+		ddvd_device_clear(playerconfig);
 }
 
 // Empty Device Buffers
-static void ddvd_device_clear(void)
+static void ddvd_device_clear(struct ddvd *playerconfig)
 {
+	struct ddvd_sink *sink = &playerconfig->sink;
+
 	Debug(3, "device_clear: clear audio and video buffers\n");
+	ddvd_clock_resync(&playerconfig->clock);
+	ddvd_timeline_flush(&playerconfig->timeline);
+	ddvd_aring_clear(&playerconfig->arings);
 
-	if (ioctl(ddvd_fdaudio, AUDIO_CLEAR_BUFFER) < 0)
-		Perror("AUDIO_CLEAR_BUFFER");
-	if (ioctl(ddvd_fdaudio, AUDIO_PLAY) < 0)
-		Perror("AUDIO_PLAY");
-	if (ioctl(ddvd_fdaudio, AUDIO_CONTINUE) < 0)
-		Perror("AUDIO_CONTINUE");
+	ddvd_audio_clear(playerconfig);
+	ddvd_audio_continue(playerconfig);
 
-	if (ioctl(ddvd_fdvideo, VIDEO_CLEAR_BUFFER) < 0)
+	ddvd_sink_discard(sink, DDVD_DEV_VIDEO);
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_CLEAR_BUFFER) < 0)
 		Perror("VIDEO_CLEAR_BUFFER");
-	if (ioctl(ddvd_fdvideo, VIDEO_PLAY) < 0)
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_PLAY) < 0)
 		Perror("VIDEO_PLAY");
-	if (ioctl(ddvd_fdvideo, VIDEO_CONTINUE) < 0)
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_VIDEO, VIDEO_CONTINUE) < 0)
 		Perror("VIDEO_CONTINUE");
 
-	if (ioctl(ddvd_fdaudio, AUDIO_SET_AV_SYNC, 1) < 0)
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_SET_AV_SYNC, 1) < 0)
 		Perror("AUDIO_SET_AV_SYNC");
 }
 
+// Keys whose handling may call dvdnav or ddvd_play_empty, the reader must not get a block meanwhile
+static int ddvd_key_navigates(int key)
+{
+	switch (key) {
+		case DDVD_KEY_MENU:
+		case DDVD_KEY_AUDIOMENU:
+		case DDVD_KEY_UP:
+		case DDVD_KEY_DOWN:
+		case DDVD_KEY_LEFT:
+		case DDVD_KEY_RIGHT:
+		case DDVD_KEY_OK:
+		case DDVD_KEY_EXIT:
+		case DDVD_KEY_PREV_CHAPTER:
+		case DDVD_KEY_NEXT_CHAPTER:
+		case DDVD_KEY_PREV_TITLE:
+		case DDVD_KEY_NEXT_TITLE:
+		case DDVD_SET_CHAPTER:
+		case DDVD_SET_TITLE:
+		case DDVD_SKIP_FWD:
+		case DDVD_SKIP_BWD:
+		case DDVD_SEEK_ABS:
+		case DDVD_KEY_ANGLE:
+		case DDVD_GET_ANGLE:
+			return 1;
+		default:	// mute, play, pause, trick speeds, audio and subtitle streams, time
+			return 0;
+	}
+}
+
+// Empty the audio decoder only, what is queued for it is dropped
+static void ddvd_audio_clear(struct ddvd *playerconfig)
+{
+	struct ddvd_sink *sink = &playerconfig->sink;
+
+	ddvd_sink_discard(sink, DDVD_DEV_AUDIO);
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_CLEAR_BUFFER) < 0)
+		Perror("AUDIO_CLEAR_BUFFER");
+	playerconfig->audio_stopped = 1;
+}
+
+// Let the audio decoder play on, after ddvd_audio_clear it is started first
+static void ddvd_audio_continue(struct ddvd *playerconfig)
+{
+	struct ddvd_sink *sink = &playerconfig->sink;
+
+	if (playerconfig->audio_stopped) {
+		if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_PLAY) < 0)
+			Perror("AUDIO_PLAY");
+		playerconfig->audio_stopped = 0;
+	}
+	if (ddvd_sink_ioctl(sink, DDVD_DEV_AUDIO, AUDIO_CONTINUE) < 0)
+		Perror("AUDIO_CONTINUE");
+}
+
 // SPU Decoder
-static struct ddvd_spu_return ddvd_spu_decode_data(char *spu_buf, const uint8_t * buffer, unsigned long long pts)
+struct ddvd_spu_return ddvd_spu_decode_data(struct ddvd *playerconfig, char *spu_buf, const uint8_t * buffer, unsigned long long pts)
 {
 	int x1spu, x2spu, y1spu, y2spu, xspu, yspu;
 	int offset[2], param_len;
@@ -2950,21 +3443,21 @@ static struct ddvd_spu_return ddvd_spu_decode_data(char *spu_buf, const uint8_t
 				ddvd_spudec_clut_t *clut = (ddvd_spudec_clut_t *) (buffer + i + 1);
 				Debug(4, "update palette %d %d %d %d\n", clut->entry0, clut->entry1, clut->entry2, clut->entry3);
 
-				ddvd_bl[3 + 252] = ddvd_bl[clut->entry0];
-				ddvd_gn[3 + 252] = ddvd_gn[clut->entry0];
-				ddvd_rd[3 + 252] = ddvd_rd[clut->entry0];
+				playerconfig->bl[3 + 252] = playerconfig->bl[clut->entry0];
+				playerconfig->gn[3 + 252] = playerconfig->gn[clut->entry0];
+				playerconfig->rd[3 + 252] = playerconfig->rd[clut->entry0];
 
-				ddvd_bl[2 + 252] = ddvd_bl[clut->entry1];
-				ddvd_gn[2 + 252] = ddvd_gn[clut->entry1];
-				ddvd_rd[2 + 252] = ddvd_rd[clut->entry1];
+				playerconfig->bl[2 + 252] = playerconfig->bl[clut->entry1];
+				playerconfig->gn[2 + 252] = playerconfig->gn[clut->entry1];
+				playerconfig->rd[2 + 252] = playerconfig->rd[clut->entry1];
 
-				ddvd_bl[1 + 252] = ddvd_bl[clut->entry2];
-				ddvd_gn[1 + 252] = ddvd_gn[clut->entry2];
-				ddvd_rd[1 + 252] = ddvd_rd[clut->entry2];
+				playerconfig->bl[1 + 252] = playerconfig->bl[clut->entry2];
+				playerconfig->gn[1 + 252] = playerconfig->gn[clut->entry2];
+				playerconfig->rd[1 + 252] = playerconfig->rd[clut->entry2];
 
-				ddvd_bl[0 + 252] = ddvd_bl[clut->entry3];
-				ddvd_gn[0 + 252] = ddvd_gn[clut->entry3];
-				ddvd_rd[0 + 252] = ddvd_rd[clut->entry3];
+				playerconfig->bl[0 + 252] = playerconfig->bl[clut->entry3];
+				playerconfig->gn[0 + 252] = playerconfig->gn[clut->entry3];
+				playerconfig->rd[0 + 252] = playerconfig->rd[clut->entry3];
 
 				i += 3;
 				break;
@@ -2974,10 +3467,10 @@ static struct ddvd_spu_return ddvd_spu_decode_data(char *spu_buf, const uint8_t
 				ddvd_spudec_clut_t *clut = (ddvd_spudec_clut_t *) (buffer + i + 1);
 				Debug(4, "update transp palette %d %d %d %d\n", clut->entry0, clut->entry1, clut->entry2, clut->entry3);
 
-				ddvd_tr[0 + 252] = (0xF - clut->entry3) * 0x1111;
-				ddvd_tr[1 + 252] = (0xF - clut->entry2) * 0x1111;
-				ddvd_tr[2 + 252] = (0xF - clut->entry1) * 0x1111;
-				ddvd_tr[3 + 252] = (0xF - clut->entry0) * 0x1111;
+				playerconfig->tr[0 + 252] = (0xF - clut->entry3) * 0x1111;
+				playerconfig->tr[1 + 252] = (0xF - clut->entry2) * 0x1111;
+				playerconfig->tr[2 + 252] = (0xF - clut->entry1) * 0x1111;
+				playerconfig->tr[3 + 252] = (0xF - clut->entry0) * 0x1111;
 
 				i += 3;
 				break;
@@ -3068,9 +3561,9 @@ static struct ddvd_spu_return ddvd_spu_decode_data(char *spu_buf, const uint8_t
 }
 
 // blit to argb in 32bit mode
-static void ddvd_blit_to_argb(void *_dst, const void *_src, int pix)
+void ddvd_blit_to_argb(struct ddvd *playerconfig, void *_dst, const void *_src, int pix)
 {
-	unsigned long *dst = _dst;
+	uint32_t *dst = _dst;
 	const unsigned char *src = _src;
 	while (pix--) {
 		int p = (*src++);
@@ -3079,34 +3572,15 @@ static void ddvd_blit_to_argb(void *_dst, const void *_src, int pix)
 			r = g = b = a = 0;	//clear screen (transparency)
 		}
 		else {
-			a = 0xFF - (ddvd_tr[p] >> 8);
-			r = ddvd_rd[p] >> 8;
-			g = ddvd_gn[p] >> 8;
-			b = ddvd_bl[p] >> 8;
+			a = 0xFF - (playerconfig->tr[p] >> 8);
+			r = playerconfig->rd[p] >> 8;
+			g = playerconfig->gn[p] >> 8;
+			b = playerconfig->bl[p] >> 8;
 		}
 		*dst++ = (a << 24) | (r << 16) | (g << 8) | (b << 0);
 	}
 }
 
-#if CONFIG_API_VERSION == 3
-
-// set decoder buffer offsets to a minimum
-static void ddvd_set_pcr_offset(void)
-{
-	write_string("/proc/stb/pcr/pcr_stc_offset", "200");
-	write_string("/proc/stb/vmpeg/0/sync_offset", "200");
-}
-
-// reset decoder buffer offsets
-static void ddvd_unset_pcr_offset(void)
-{
-	write_string("/proc/stb/pcr/pcr_stc_offset", "2710");
-	write_string("/proc/stb/vmpeg/0/sync_offset", "2710");
-}
-
-#endif
-
-
 // "nearest neighbor" pixmap resizing
 struct ddvd_resize_return ddvd_resize_pixmap_xbpp(unsigned char *pixmap, int xsource, int ysource, int xdest, int ydest, int xoffset, int yoffset, int xstart, int xend, int ystart, int yend, int colors)
 {
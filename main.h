@@ -39,6 +39,8 @@
 #define CONVERT_TO_DVB_COMPLIANT_DTS
 
 #define NUM_SPU_BACKBUFFER 8
+#define OUTPUT_BATCH 8		// blocks queued in the sink before they are written, when read ahead
+#define LOOP_DECODER_MS 20	// longest sleep while the decoder plays, subtitles follow its time
 
 #include <fcntl.h>
 #include <stdio.h>
@@ -59,6 +61,17 @@
 
 #include <dvdnav/dvdnav.h>
 #include "ddvdlib.h"
+#include "sink.h"
+#include "reader.h"
+#include "loop.h"
+#include "clock.h"
+#include "timeline.h"
+#include "aring.h"
+#include "tmap.h"
+#include "probe.h"
+#include "demux.h"
+#include "trace.h"
+#include "ddvd_internal.h"
 
 #if SHOW_START_SCREEN == 1
 #include "logo.h" // startup screen 
@@ -68,28 +81,9 @@
 #error "no BYTE_ORDER defined!!!!"
 #endif
 
-#if defined(HAVE_LINUX_DVB_VERSION_H)
-#include <linux/dvb/video.h>
-#include <linux/dvb/audio.h>
-#define CONFIG_API_VERSION 3
-#elif defined(HAVE_OST_DMX_H)
-#include <ost/video.h>
-#include <ost/audio.h>
-#define CONFIG_API_VERSION 1
-#endif
-
 #define BUFFER_SIZE 4096
 #define AC3_BUFFER_SIZE (6*1024*16)
 
-#if CONFIG_API_VERSION == 1
-#define VIDEO_GET_PTS           _IOR('o', 1, unsigned int*)
-#endif
-#if CONFIG_API_VERSION == 3
-#ifndef VIDEO_GET_PTS
-#define VIDEO_GET_PTS              _IOR('o', 57, unsigned long long)
-#endif
-#endif
-
 #define CLAMP(x)     ((x < 0) ? 0 : ((x > 255) ? 255 : x))
 #define CELL_STILL       0x02
 #define NAV_STILL        0x04
@@ -120,41 +114,6 @@ typedef struct ddvd_spudec_clut_struct {
 #endif
 } ddvd_spudec_clut_t;
 
-enum {SPU_NOP, SPU_SHOW, SPU_HIDE, SPU_FORCE};
-struct ddvd_spu_return {
-	int display_time;
-	int x_start;
-	int x_end;
-	int y_start;
-	int y_end;
-	int force_hide;
-	unsigned long long pts;
-};
-
-struct ddvd_resize_return {
-	int x_start;
-	int x_end;
-	int y_start;
-	int y_end;	
-	
-	int x_offset, y_offset, width, height;
-};
-
-// some global stuff 
-
-dvdnav_t *dvdnav;
-dvdnav_cell_change_event_t ddvd_lastCellEventInfo;
-
-int ddvd_wait_for_user;
-int ddvd_lpcm_count;
-int ddvd_iframerun;
-int ddvd_still_frame;
-int ddvd_iframesend;
-int ddvd_last_iframe_len;
-int ddvd_spu_ptr;
-int ddvd_lbb_changed;
-int ddvd_clear_screen;
-
 enum {
 	TOFF    = 0x00,
 	FASTFW  = 0x01,
@@ -165,8 +124,6 @@ enum {
 	SLOWBW  = 0x20
 };
 
-int ddvd_trickmode, ddvd_trickspeed;
-
 enum {
 	STOP  = 0x00,
 	PLAY  = 0x01,
@@ -174,24 +131,6 @@ enum {
 	STEP  = 0x04
 };
 
-int ddvd_playmode;
-
-int ddvd_wait_timer_active;
-uint64_t ddvd_wait_timer_end;
-
-int ddvd_spu_timer_active;
-uint64_t ddvd_spu_timer_end;
-
-int ddvd_trick_timer_active;
-uint64_t ddvd_trick_timer_end;
-
-unsigned char *ddvd_lbb, *ddvd_lbb2;
-int ddvd_output_fd, ddvd_fdvideo, ddvd_fdaudio, ddvd_ac3_fd;
-
-int ddvd_screeninfo_xres, ddvd_screeninfo_yres, ddvd_screeninfo_stride;
-
-unsigned short ddvd_rd[256],ddvd_gn[256],ddvd_bl[256],ddvd_tr[256];
-
 struct ddvd_size_evt {
 	int width;
 	int height;
@@ -232,6 +171,34 @@ struct ddvd {
 	int message_pipe[2];			// pipe for getting player status, osd time and text as well as 8bit color tables
 	char *dvd_path;					// the path of a dvd block device ("/dev/dvd"), an iso-file ("/hdd/dvd.iso")
 									// or a dvd file structure ("/hdd/dvd/mymovie") to play 
+	char *cache_dir;				// where the seek index of a disc is kept between runs, NULL for nowhere
+	char *css_cache_dir;			// DVDCSS_CACHE for libdvdcss, NULL leaves it to the environment
+	int sink_type;					// output backend, see sink enum in ddvdlib.h
+	char *sink_path;				// file prefix for the file backend
+	struct ddvd_sink sink;			// the output backend while playing
+	struct ddvd_stats_ctx stats;	// performance counters, see ddvd_get_stats
+	struct ddvd_reader reader;		// reads dvdnav ahead of the player loop while playing
+	struct ddvd_loop loop;			// the player sleeps here while playing
+	struct ddvd_clock clock;		// decoder time while playing
+	struct ddvd_timeline timeline;	// pts segments of what was sent to the decoder
+	struct ddvd_arings arings;		// last packs of every audio stream
+	struct ddvd_tmap tmap;			// time map of the playing title, for seeking and the osd time
+	int readahead;					// play from the dvdnav read-ahead cache, see ddvd_set_readahead
+	int nonblock_output;			// non-blocking decoder writes, see ddvd_set_nonblock_output
+	int run_mode;					// see run mode enum in ddvdlib.h
+	int remux_title;				// title to remux in DDVD_RUN_REMUX mode
+	pthread_t probe_thread;			// see ddvd_probe
+	int probe_started;				// probe_thread is to be joined
+	int probe_done;					// disc_info is there, atomic, set under probe_mutex
+	pthread_mutex_t probe_mutex;
+	pthread_cond_t probe_cond;		// signalled when probe_done is set
+	enum ddvd_result probe_result;
+	int probe_a52;					// liba52 reference the probe took for ddvd_run
+	pthread_t css_thread;			// fetches the CSS keys after the probe, with a dvdread handle of its own
+	int css_started;				// css_thread is to be joined
+	int css_stop;					// css_thread stops after the current title set, atomic
+	char *css_path;					// the disc css_thread reads
+	struct ddvd_disc_info disc_info;
 	/* buffer for actual states */
 	char title_string[96];
 	struct ddvd_color last_col[4];	// colortable (8Bit mode), 4 colors
@@ -263,23 +230,50 @@ struct ddvd {
 
 	int audio_format[MAX_AUDIO];
 	struct spu_map_t spu_map[MAX_SPU];
+
+	/* player state while running, each handle has its own so players can run concurrently */
+	dvdnav_t *dvdnav;
+	dvdnav_cell_change_event_t last_cell_info;
+	int wait_for_user;
+	int lpcm_count;
+	int iframerun;
+	int still_frame;
+	int iframesend;
+	int last_iframe_len;
+	int spu_ptr;
+	int lbb_changed;
+	int clear_screen;
+	int trickmode, trickspeed;
+	int playmode;
+	int audio_stopped;				// the audio decoder was cleared and needs AUDIO_PLAY to go on
+	int wait_timer_active;
+	uint64_t wait_timer_end;
+	int spu_timer_active;
+	uint64_t spu_timer_end;
+	int trick_timer_active;
+	uint64_t trick_timer_end;
+	unsigned char *lbb, *lbb2;		// spu decode buffer and screen backbuffer
+	int screeninfo_xres, screeninfo_yres, screeninfo_stride;
+	unsigned short rd[256], gn[256], bl[256], tr[256];	// spu/menu palette
+	struct	ddvd_resize_return (*resize_pixmap)(unsigned char *pixmap, int xsource, int ysource, int xdest, int ydest, int xoffset, int yoffset, int xstart, int xend, int ystart, int yend, int colors);
+	struct ddvd_a52 a52;			// soft ac3 decoder
+	ddvd_mpa_context *mpa;			// mp2 encoder for lpcm and soft decoded ac3
 };
 
 /* internal functions */
 static struct 	ddvd_time ddvd_get_osd_time(struct ddvd *playerconfig);
 static int 		ddvd_readpipe(int pipefd, void *dest, size_t bytes, int blocked_read);
 static int 		ddvd_check_aspect(int dvd_aspect, int dvd_scale_perm, int tv_aspect, int tv_mode);
-static uint64_t	ddvd_get_time(void);
-static void 	ddvd_play_empty(int device_clear);
-static void 	ddvd_device_clear(void);
-static struct 	ddvd_spu_return	ddvd_spu_decode_data(char *spu_buf, const uint8_t * buffer, unsigned long long pts);
-static void 	ddvd_blit_to_argb(void *_dst, const void *_src, int pix);
-#if CONFIG_API_VERSION == 3
-static void 	ddvd_set_pcr_offset(void);
-static void 	ddvd_unset_pcr_offset(void);
-#endif
-struct 	ddvd_resize_return	ddvd_resize_pixmap_xbpp(unsigned char *pixmap, int xsource, int ysource, int xdest, int ydest, int xoffset, int yoffset, int xstart, int xend, int ystart, int yend, int colors);
-struct 	ddvd_resize_return	ddvd_resize_pixmap_xbpp_smooth(unsigned char *pixmap, int xsource, int ysource, int xdest, int ydest, int xoffset, int yoffset, int xstart, int xend, int ystart, int yend, int colors);
-struct	ddvd_resize_return	ddvd_resize_pixmap_1bpp(unsigned char *pixmap, int xsource, int ysource, int xdest, int ydest, int xoffset, int yoffset, int xstart, int xend, int ystart, int yend, int colors);
-struct	ddvd_resize_return	(*ddvd_resize_pixmap)(unsigned char *pixmap, int xsource, int ysource, int xdest, int ydest, int xoffset, int yoffset, int xstart, int xend, int ystart, int yend, int colors);
+static void 	ddvd_play_empty(struct ddvd *playerconfig, int device_clear);
+static void 	ddvd_device_clear(struct ddvd *playerconfig);
+static void 	ddvd_audio_clear(struct ddvd *playerconfig);
+static void 	ddvd_audio_continue(struct ddvd *playerconfig);
+static int 		ddvd_key_navigates(int key);
+static int 		ddvd_next_timeout(struct ddvd *playerconfig, uint64_t now);
+static void 	ddvd_probe_join(struct ddvd *playerconfig);
+static void 	ddvd_probe_wait(struct ddvd *playerconfig);
+static void 	ddvd_css_setup(struct ddvd *playerconfig);
+static int 		ddvd_resume_valid(struct ddvd *playerconfig);
+static int 		ddvd_main_feature(struct ddvd *playerconfig);
+static int64_t	ddvd_seek_block(struct ddvd *playerconfig, uint32_t pos, uint32_t len, int64_t offset);
 #endif
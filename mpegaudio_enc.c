@@ -23,61 +23,18 @@
  */
 
 
-#include "mpegaudio_enc.h"
-
+#include <pthread.h>
 
-void ddvd_mpa_init(int init_freq, int init_bitrate)
-{
-	int i, v, table;
-    float a;
-	
-	ddvd_mpa_freq=init_freq;
-	ddvd_mpa_bit_rate=init_bitrate;
-	
-	ddvd_mpa_lsf = 0;
-    for(i=0;i<3;i++) {
-        if (ddvd_mpa_ff_mpa_freq_tab[i] == ddvd_mpa_freq)
-            break;
-        if ((ddvd_mpa_ff_mpa_freq_tab[i] / 2) == ddvd_mpa_freq) {
-            ddvd_mpa_lsf = 1;
-            break;
-        }
-    }
-    if (i == 3){
-        return;
-    }
-    ddvd_mpa_freq_index = i;
-		
-	/* encoding bitrate & frequency */
-    for(i=0;i<15;i++) {
-        if (ddvd_mpa_ff_mpa_bitrate_tab[ddvd_mpa_lsf][1][i] == ddvd_mpa_bit_rate/1000)
-            break;
-    }
-    if (i == 15){
-        return;
-    }
-    ddvd_mpa_bitrate_index = i;
-
-	/* compute total header size & pad bit */
-
-    a = (float)(ddvd_mpa_bit_rate * MPA_FRAME_SIZE) / (ddvd_mpa_freq * 8.0);
-    ddvd_mpa_frame_size = ((int)a) * 8;
+#include "mpegaudio_enc.h"
 
-	/* frame fractional size to compute padding */
-    ddvd_mpa_frame_frac = 0;
-    ddvd_mpa_frame_frac_incr = (int)((a - FLOOR(a)) * 65536.0);
 
-    /* select the right allocation table */
-    table = ddvd_mpa_ff_mpa_l2_select_table(ddvd_mpa_bit_rate/1000, NB_CHANNELS, ddvd_mpa_freq, ddvd_mpa_lsf);
-
-    /* number of used subbands */
-    ddvd_mpa_sblimit = ddvd_mpa_ff_mpa_sblimit_table[table];
-    ddvd_mpa_alloc_table = ddvd_mpa_ff_mpa_alloc_tables[table];
+/* the tables only depend on constants, they are shared by all encoders */
+static pthread_once_t ddvd_mpa_tables_once = PTHREAD_ONCE_INIT;
 
+static void ddvd_mpa_init_tables(void)
+{
+	int i, v;
 
-    for(i=0;i<NB_CHANNELS;i++)
-        ddvd_mpa_samples_offset[i] = 0;
-	
     for(i=0;i<257;i++) {
         int v;
         v = ddvd_mpa_ff_mpa_enwindow[i];
@@ -123,6 +80,75 @@ void ddvd_mpa_init(int init_freq, int init_bitrate)
     }
 }
 
+ddvd_mpa_context *ddvd_mpa_init(int init_freq, int init_bitrate)
+{
+	ddvd_mpa_context *s;
+	int i, table;
+    float a;
+
+	pthread_once(&ddvd_mpa_tables_once, ddvd_mpa_init_tables);
+
+	s = calloc(1, sizeof(ddvd_mpa_context));
+	if (s == NULL)
+		return NULL;
+	
+	s->freq=init_freq;
+	s->bit_rate=init_bitrate;
+	
+	s->lsf = 0;
+    for(i=0;i<3;i++) {
+        if (ddvd_mpa_ff_mpa_freq_tab[i] == s->freq)
+            break;
+        if ((ddvd_mpa_ff_mpa_freq_tab[i] / 2) == s->freq) {
+            s->lsf = 1;
+            break;
+        }
+    }
+    if (i == 3){
+        free(s);
+        return NULL;
+    }
+    s->freq_index = i;
+		
+	/* encoding bitrate & frequency */
+    for(i=0;i<15;i++) {
+        if (ddvd_mpa_ff_mpa_bitrate_tab[s->lsf][1][i] == s->bit_rate/1000)
+            break;
+    }
+    if (i == 15){
+        free(s);
+        return NULL;
+    }
+    s->bitrate_index = i;
+
+	/* compute total header size & pad bit */
+
+    a = (float)(s->bit_rate * MPA_FRAME_SIZE) / (s->freq * 8.0);
+    s->frame_size = ((int)a) * 8;
+
+	/* frame fractional size to compute padding */
+    s->frame_frac = 0;
+    s->frame_frac_incr = (int)((a - FLOOR(a)) * 65536.0);
+
+    /* select the right allocation table */
+    table = ddvd_mpa_ff_mpa_l2_select_table(s->bit_rate/1000, NB_CHANNELS, s->freq, s->lsf);
+
+    /* number of used subbands */
+    s->sblimit = ddvd_mpa_ff_mpa_sblimit_table[table];
+    s->alloc_table = ddvd_mpa_ff_mpa_alloc_tables[table];
+
+
+    for(i=0;i<NB_CHANNELS;i++)
+        s->samples_offset[i] = 0;
+
+    return s;
+}
+
+void ddvd_mpa_free(ddvd_mpa_context *s)
+{
+	free(s);
+}
+
 
 /* 32 point floating point IDCT without 1/sqrt(2) coef zero scaling */
 static void ddvd_mpa_idct32(int *out, int *tab)
@@ -246,7 +272,7 @@ static void ddvd_mpa_idct32(int *out, int *tab)
 
 
 
-static void ddvd_mpa_filter(int ch, short *samples, int incr)
+static void ddvd_mpa_filter(ddvd_mpa_context *s, int ch, short *samples, int incr)
 {
     short *p, *q;
     int sum, offset, i, j;
@@ -256,17 +282,17 @@ static void ddvd_mpa_filter(int ch, short *samples, int incr)
 
     //    print_pow1(samples, 1152);
 
-    offset = ddvd_mpa_samples_offset[ch];
-    out = &ddvd_mpa_sb_samples[ch][0][0][0];
+    offset = s->samples_offset[ch];
+    out = &s->sb_samples[ch][0][0][0];
     for(j=0;j<36;j++) {
         /* 32 samples at once */
         for(i=0;i<32;i++) {
-            ddvd_mpa_samples_buf[ch][offset + (31 - i)] = samples[0];
+            s->samples_buf[ch][offset + (31 - i)] = samples[0];
             samples += incr;
         }
 
         /* filter */
-        p = ddvd_mpa_samples_buf[ch] + offset;
+        p = s->samples_buf[ch] + offset;
         q = ddvd_mpa_filter_bank;
         /* maxsum = 23169 */
         for(i=0;i<64;i++) {
@@ -293,12 +319,12 @@ static void ddvd_mpa_filter(int ch, short *samples, int incr)
         out += 32;
         /* handle the wrap around */
         if (offset < 0) {
-            memmove(ddvd_mpa_samples_buf[ch] + SAMPLES_BUF_SIZE - (512 - 32),
-                    ddvd_mpa_samples_buf[ch], (512 - 32) * 2);
+            memmove(s->samples_buf[ch] + SAMPLES_BUF_SIZE - (512 - 32),
+                    s->samples_buf[ch], (512 - 32) * 2);
             offset = SAMPLES_BUF_SIZE - 512;
         }
     }
-    ddvd_mpa_samples_offset[ch] = offset;
+    s->samples_offset[ch] = offset;
 
     //    print_pow(s->sb_samples, 1152);
 }
@@ -422,11 +448,11 @@ static void ddvd_mpa_compute_scale_factors(unsigned char ddvd_mpa_scale_code[SBL
 /* The most important function : psycho acoustic module. In this
    encoder there is basically none, so this is the worst you can do,
    but also this is the simpler. */
-static void ddvd_mpa_psycho_acoustic_model(short smr[SBLIMIT])
+static void ddvd_mpa_psycho_acoustic_model(ddvd_mpa_context *s, short smr[SBLIMIT])
 {
     int i;
 
-    for(i=0;i<ddvd_mpa_sblimit;i++) {
+    for(i=0;i<s->sblimit;i++) {
         smr[i] = (int)(ddvd_mpa_fixed_smr[i] * 10);
     }
 }
@@ -434,7 +460,8 @@ static void ddvd_mpa_psycho_acoustic_model(short smr[SBLIMIT])
 /* Try to maximize the smr while using a number of bits inferior to
    the frame size. I tried to make the code simpler, faster and
    smaller than other encoders :-) */
-static void ddvd_mpa_compute_bit_allocation(short smr1[MPA_MAX_CHANNELS][SBLIMIT],
+static void ddvd_mpa_compute_bit_allocation(ddvd_mpa_context *s,
+                                   short smr1[MPA_MAX_CHANNELS][SBLIMIT],
                                    unsigned char bit_alloc[MPA_MAX_CHANNELS][SBLIMIT],
                                    int *padding)
 {
@@ -449,20 +476,20 @@ static void ddvd_mpa_compute_bit_allocation(short smr1[MPA_MAX_CHANNELS][SBLIMIT
     memset(bit_alloc, 0, NB_CHANNELS * SBLIMIT);
 
     /* compute frame size and padding */
-    max_frame_size = ddvd_mpa_frame_size;
-    ddvd_mpa_frame_frac += ddvd_mpa_frame_frac_incr;
-    if (ddvd_mpa_frame_frac >= 65536) {
-        ddvd_mpa_frame_frac -= 65536;
-        ddvd_mpa_do_padding = 1;
+    max_frame_size = s->frame_size;
+    s->frame_frac += s->frame_frac_incr;
+    if (s->frame_frac >= 65536) {
+        s->frame_frac -= 65536;
+        s->do_padding = 1;
         max_frame_size += 8;
     } else {
-        ddvd_mpa_do_padding = 0;
+        s->do_padding = 0;
     }
 
     /* compute the header + bit alloc size */
     current_frame_size = 32;
-    alloc = ddvd_mpa_alloc_table;
-    for(i=0;i<ddvd_mpa_sblimit;i++) {
+    alloc = s->alloc_table;
+    for(i=0;i<s->sblimit;i++) {
         incr = alloc[0];
         current_frame_size += incr * NB_CHANNELS;
         alloc += 1 << incr;
@@ -473,7 +500,7 @@ static void ddvd_mpa_compute_bit_allocation(short smr1[MPA_MAX_CHANNELS][SBLIMIT
         max_ch = -1;
         max_smr = 0x80000000;
         for(ch=0;ch<NB_CHANNELS;ch++) {
-            for(i=0;i<ddvd_mpa_sblimit;i++) {
+            for(i=0;i<s->sblimit;i++) {
                 if (smr[ch][i] > max_smr && subband_status[ch][i] != SB_NOMORE) {
                     max_smr = smr[ch][i];
                     max_sb = i;
@@ -487,14 +514,14 @@ static void ddvd_mpa_compute_bit_allocation(short smr1[MPA_MAX_CHANNELS][SBLIMIT
 
         /* find alloc table entry (XXX: not optimal, should use
            pointer table) */
-        alloc = ddvd_mpa_alloc_table;
+        alloc = s->alloc_table;
         for(i=0;i<max_sb;i++) {
             alloc += 1 << alloc[0];
         }
 
         if (subband_status[max_ch][max_sb] == SB_NOTALLOCATED) {
             /* nothing was coded for this band: add the necessary bits */
-            incr = 2 + ddvd_mpa_nb_scale_factors[ddvd_mpa_scale_code[max_ch][max_sb]] * 6;
+            incr = 2 + ddvd_mpa_nb_scale_factors[s->scale_code[max_ch][max_sb]] * 6;
             incr += ddvd_mpa_total_quant_bits[alloc[1]];
         } else {
             /* increments bit allocation */
@@ -525,23 +552,24 @@ static void ddvd_mpa_compute_bit_allocation(short smr1[MPA_MAX_CHANNELS][SBLIMIT
 
 }
 
-static void ddvd_mpa_encode_frame_internal(unsigned char bit_alloc[MPA_MAX_CHANNELS][SBLIMIT],
+static void ddvd_mpa_encode_frame_internal(ddvd_mpa_context *s,
+                         unsigned char bit_alloc[MPA_MAX_CHANNELS][SBLIMIT],
                          int padding)
 {
     int i, j, k, l, bit_alloc_bits, b, ch;
     unsigned char *sf;
     int q[3];
-    ddvd_mpa_PutBitContext *p = &pb;
+    ddvd_mpa_PutBitContext *p = &s->pb;
 
     /* header */
 
     ddvd_mpa_put_bits(p, 12, 0xfff);
-    ddvd_mpa_put_bits(p, 1, 1 - ddvd_mpa_lsf); /* 1 = mpeg1 ID, 0 = mpeg2 lsf ID */
+    ddvd_mpa_put_bits(p, 1, 1 - s->lsf); /* 1 = mpeg1 ID, 0 = mpeg2 lsf ID */
     ddvd_mpa_put_bits(p, 2, 4-2);  /* layer 2 */
     ddvd_mpa_put_bits(p, 1, 1); /* no error protection */
-    ddvd_mpa_put_bits(p, 4, ddvd_mpa_bitrate_index);
-    ddvd_mpa_put_bits(p, 2, ddvd_mpa_freq_index);
-    ddvd_mpa_put_bits(p, 1, ddvd_mpa_do_padding); /* use padding */
+    ddvd_mpa_put_bits(p, 4, s->bitrate_index);
+    ddvd_mpa_put_bits(p, 2, s->freq_index);
+    ddvd_mpa_put_bits(p, 1, s->do_padding); /* use padding */
     ddvd_mpa_put_bits(p, 1, 0);             /* private_bit */
     ddvd_mpa_put_bits(p, 2, NB_CHANNELS == 2 ? MPA_STEREO : MPA_MONO);
     ddvd_mpa_put_bits(p, 2, 0); /* mode_ext */
@@ -551,8 +579,8 @@ static void ddvd_mpa_encode_frame_internal(unsigned char bit_alloc[MPA_MAX_CHANN
 
     /* bit allocation */
     j = 0;
-    for(i=0;i<ddvd_mpa_sblimit;i++) {
-        bit_alloc_bits = ddvd_mpa_alloc_table[j];
+    for(i=0;i<s->sblimit;i++) {
+        bit_alloc_bits = s->alloc_table[j];
         for(ch=0;ch<NB_CHANNELS;ch++) {
             ddvd_mpa_put_bits(p, bit_alloc_bits, bit_alloc[ch][i]);
         }
@@ -560,19 +588,19 @@ static void ddvd_mpa_encode_frame_internal(unsigned char bit_alloc[MPA_MAX_CHANN
     }
 
     /* scale codes */
-    for(i=0;i<ddvd_mpa_sblimit;i++) {
+    for(i=0;i<s->sblimit;i++) {
         for(ch=0;ch<NB_CHANNELS;ch++) {
             if (bit_alloc[ch][i])
-                ddvd_mpa_put_bits(p, 2, ddvd_mpa_scale_code[ch][i]);
+                ddvd_mpa_put_bits(p, 2, s->scale_code[ch][i]);
         }
     }
 
     /* scale factors */
-    for(i=0;i<ddvd_mpa_sblimit;i++) {
+    for(i=0;i<s->sblimit;i++) {
         for(ch=0;ch<NB_CHANNELS;ch++) {
             if (bit_alloc[ch][i]) {
-                sf = &ddvd_mpa_scale_factors[ch][i][0];
-                switch(ddvd_mpa_scale_code[ch][i]) {
+                sf = &s->scale_factors[ch][i][0];
+                switch(s->scale_code[ch][i]) {
                 case 0:
                     ddvd_mpa_put_bits(p, 6, sf[0]);
                     ddvd_mpa_put_bits(p, 6, sf[1]);
@@ -596,22 +624,22 @@ static void ddvd_mpa_encode_frame_internal(unsigned char bit_alloc[MPA_MAX_CHANN
     for(k=0;k<3;k++) {
         for(l=0;l<12;l+=3) {
             j = 0;
-            for(i=0;i<ddvd_mpa_sblimit;i++) {
-                bit_alloc_bits = ddvd_mpa_alloc_table[j];
+            for(i=0;i<s->sblimit;i++) {
+                bit_alloc_bits = s->alloc_table[j];
                 for(ch=0;ch<NB_CHANNELS;ch++) {
                     b = bit_alloc[ch][i];
                     if (b) {
                         int qindex, steps, m, sample, bits;
                         /* we encode 3 sub band samples of the same sub band at a time */
-                        qindex = ddvd_mpa_alloc_table[j+b];
+                        qindex = s->alloc_table[j+b];
                         steps = ddvd_mpa_ff_mpa_quant_steps[qindex];
                         for(m=0;m<3;m++) {
-                            sample = ddvd_mpa_sb_samples[ch][k][l + m][i];
+                            sample = s->sb_samples[ch][k][l + m][i];
                             /* divide by scale factor */
 
                             {
                                 int q1, e, shift, mult;
-                                e = ddvd_mpa_scale_factors[ch][i][k];
+                                e = s->scale_factors[ch][i][k];
                                 shift = ddvd_mpa_scale_factor_shift[e];
                                 mult = ddvd_mpa_scale_factor_mult[e];
 
@@ -658,7 +686,7 @@ static void ddvd_mpa_encode_frame_internal(unsigned char bit_alloc[MPA_MAX_CHANN
     ddvd_mpa_flush_put_bits(p);
 }
 
-int ddvd_mpa_encode_frame(unsigned char *frame, int buf_size, void *data)
+int ddvd_mpa_encode_frame(ddvd_mpa_context *s, unsigned char *frame, int buf_size, void *data)
 {
     short *samples = data;
     short smr[MPA_MAX_CHANNELS][SBLIMIT];
@@ -666,23 +694,23 @@ int ddvd_mpa_encode_frame(unsigned char *frame, int buf_size, void *data)
     int padding, i;
 
     for(i=0;i<NB_CHANNELS;i++) {
-        ddvd_mpa_filter(i, samples + i, NB_CHANNELS);
+        ddvd_mpa_filter(s, i, samples + i, NB_CHANNELS);
     }
 
     for(i=0;i<NB_CHANNELS;i++) {
-        ddvd_mpa_compute_scale_factors(ddvd_mpa_scale_code[i], ddvd_mpa_scale_factors[i],
-                              ddvd_mpa_sb_samples[i], ddvd_mpa_sblimit);
+        ddvd_mpa_compute_scale_factors(s->scale_code[i], s->scale_factors[i],
+                              s->sb_samples[i], s->sblimit);
     }
     for(i=0;i<NB_CHANNELS;i++) {
-        ddvd_mpa_psycho_acoustic_model(smr[i]);
+        ddvd_mpa_psycho_acoustic_model(s, smr[i]);
     }
-    ddvd_mpa_compute_bit_allocation(smr, bit_alloc, &padding);
+    ddvd_mpa_compute_bit_allocation(s, smr, bit_alloc, &padding);
 
-    ddvd_mpa_init_put_bits(&pb, frame, MPA_MAX_CODED_FRAME_SIZE);
+    ddvd_mpa_init_put_bits(&s->pb, frame, MPA_MAX_CODED_FRAME_SIZE);
 
-    ddvd_mpa_encode_frame_internal(bit_alloc, padding);
+    ddvd_mpa_encode_frame_internal(s, bit_alloc, padding);
 
-    ddvd_mpa_nb_samples += MPA_FRAME_SIZE;
-    return ddvd_mpa_pbBufPtr(&pb) - pb.buf;
+    s->nb_samples += MPA_FRAME_SIZE;
+    return ddvd_mpa_pbBufPtr(&s->pb) - s->pb.buf;
 }
 
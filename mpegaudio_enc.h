@@ -468,22 +468,25 @@ static inline void ddvd_mpa_put_bits(ddvd_mpa_PutBitContext *s, int n, unsigned
 }
 
 
-int ddvd_mpa_samples_offset[MPA_MAX_CHANNELS];       /* offset in samples_buf */
-int ddvd_mpa_sb_samples[MPA_MAX_CHANNELS][3][12][SBLIMIT];
-short ddvd_mpa_samples_buf[MPA_MAX_CHANNELS][SAMPLES_BUF_SIZE]; /* buffer for filter */
-int ddvd_mpa_sblimit;
-unsigned char ddvd_mpa_scale_factors[MPA_MAX_CHANNELS][SBLIMIT][3]; /* scale factors */
-/* code to group 3 scale factors */
-unsigned char ddvd_mpa_scale_code[MPA_MAX_CHANNELS][SBLIMIT];
-int ddvd_mpa_frame_size; /* frame size, in bits, without padding */
-int ddvd_mpa_frame_frac, ddvd_mpa_frame_frac_incr, ddvd_mpa_do_padding;
-const unsigned char *ddvd_mpa_alloc_table;
-ddvd_mpa_PutBitContext pb;
-int ddvd_mpa_lsf;           /* 1 if mpeg2 low bitrate selected */
-int ddvd_mpa_bitrate_index; /* bit rate */
-int ddvd_mpa_freq_index;
-int ddvd_mpa_freq;
-int ddvd_mpa_bit_rate;
-int64_t ddvd_mpa_nb_samples;
+/* encoder state, one per player */
+typedef struct ddvd_mpa_context {
+    int samples_offset[MPA_MAX_CHANNELS];       /* offset in samples_buf */
+    int sb_samples[MPA_MAX_CHANNELS][3][12][SBLIMIT];
+    short samples_buf[MPA_MAX_CHANNELS][SAMPLES_BUF_SIZE]; /* buffer for filter */
+    int sblimit;
+    unsigned char scale_factors[MPA_MAX_CHANNELS][SBLIMIT][3]; /* scale factors */
+    /* code to group 3 scale factors */
+    unsigned char scale_code[MPA_MAX_CHANNELS][SBLIMIT];
+    int frame_size; /* frame size, in bits, without padding */
+    int frame_frac, frame_frac_incr, do_padding;
+    const unsigned char *alloc_table;
+    ddvd_mpa_PutBitContext pb;
+    int lsf;           /* 1 if mpeg2 low bitrate selected */
+    int bitrate_index; /* bit rate */
+    int freq_index;
+    int freq;
+    int bit_rate;
+    int64_t nb_samples;
+} ddvd_mpa_context;
 
 #endif
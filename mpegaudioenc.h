@@ -27,7 +27,11 @@
 
 #define __MPEGAUDIOENC_H__
 
-void ddvd_mpa_init(int init_freq, int init_bitrate);
-int ddvd_mpa_encode_frame(unsigned char *frame, int buf_size, void *data);
+// the encoder keeps its state in a context, so every player can have its own
+typedef struct ddvd_mpa_context ddvd_mpa_context;
+
+ddvd_mpa_context *ddvd_mpa_init(int init_freq, int init_bitrate);
+void ddvd_mpa_free(ddvd_mpa_context *s);
+int ddvd_mpa_encode_frame(ddvd_mpa_context *s, unsigned char *frame, int buf_size, void *data);
 
 #endif
@@ -0,0 +1,153 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#include <string.h>
+
+#include <dvdread/ifo_read.h>
+
+#include "probe.h"
+#include "debug.h"
+
+// the player reports unknown languages as "--" too
+static unsigned short probe_lang(int lang_type, uint16_t lang_code)
+{
+	return lang_type == 1 && lang_code ? lang_code : 0x2D2D;
+}
+
+int ddvd_probe_audio_type(int audio_format)
+{
+	switch (audio_format) {
+		case 0:
+			return DDVD_AC3;
+		case 2:
+		case 3:
+			return DDVD_MPEG;
+		case 4:
+			return DDVD_LPCM;
+		case 6:
+			return DDVD_DTS;
+		default:
+			return DDVD_UNKNOWN;
+	}
+}
+
+// sum of the PGCs the chapters of title ttn of a title set play, each PGC counted once
+static int probe_title_seconds(const ifo_handle_t *vts, int ttn)
+{
+	const vts_ptt_srpt_t *ptt_srpt = vts->vts_ptt_srpt;
+	const pgcit_t *pgcit = vts->vts_pgcit;
+	uint64_t time = 0;
+	int i, j;
+
+	if (ptt_srpt == NULL || pgcit == NULL || ttn < 1 || ttn > ptt_srpt->nr_of_srpts)
+		return 0;
+	const ttu_t *ttu = &ptt_srpt->title[ttn - 1];
+	for (i = 0; i < ttu->nr_of_ptts; i++) {
+		int pgcn = ttu->ptt[i].pgcn;
+		for (j = 0; j < i && ttu->ptt[j].pgcn != pgcn; j++)
+			;
+		if (j < i || pgcn < 1 || pgcn > pgcit->nr_of_pgci_srp || pgcit->pgci_srp[pgcn - 1].pgc == NULL)
+			continue;
+		time += ddvd_tmap_dvd_time(&pgcit->pgci_srp[pgcn - 1].pgc->playback_time);
+	}
+	return time / 90000;
+}
+
+int ddvd_probe_titles(struct ddvd_tmap *tmap, const char *path, struct ddvd_disc_info *info)
+{
+	const struct ddvd_disc_info *cached = ddvd_tmap_info(tmap);
+	const ifo_handle_t *vmg;
+	int i, j;
+
+	if (cached != NULL) {
+		info->titles = cached->titles;
+		memcpy(info->title, cached->title, sizeof(info->title));
+		Debug(2, "probe: %d titles from the cache\n", info->titles);
+		return 0;
+	}
+
+	vmg = ddvd_tmap_ifo(tmap, path, 0);
+	if (vmg == NULL || vmg->tt_srpt == NULL)
+		return -1;
+
+	info->titles = vmg->tt_srpt->nr_of_srpts < DDVD_MAX_TITLES ? vmg->tt_srpt->nr_of_srpts : DDVD_MAX_TITLES;
+	for (i = 0; i < info->titles; i++) {
+		const title_info_t *ti = &vmg->tt_srpt->title[i];
+		struct ddvd_title_info *title = &info->title[i];
+
+		title->chapters = ti->nr_of_ptts;
+		title->angles = ti->nr_of_angles;
+		// the titles of a title set are mostly next to each other, so each VTS is read about once
+		const ifo_handle_t *vts = ti->title_set_nr ? ddvd_tmap_ifo(tmap, path, ti->title_set_nr) : NULL;
+		if (vts == NULL || vts->vtsi_mat == NULL)
+			continue;
+		const vtsi_mat_t *mat = vts->vtsi_mat;
+
+		title->seconds = probe_title_seconds(vts, ti->vts_ttn);
+
+		title->audio_count = mat->nr_of_vts_audio_streams < DDVD_MAX_AUDIO ? mat->nr_of_vts_audio_streams : DDVD_MAX_AUDIO;
+		for (j = 0; j < title->audio_count; j++) {
+			title->audio_lang[j] = probe_lang(mat->vts_audio_attr[j].lang_type, mat->vts_audio_attr[j].lang_code);
+			title->audio_type[j] = ddvd_probe_audio_type(mat->vts_audio_attr[j].audio_format);
+		}
+		title->spu_count = mat->nr_of_vts_subp_streams < DDVD_MAX_SPU ? mat->nr_of_vts_subp_streams : DDVD_MAX_SPU;
+		for (j = 0; j < title->spu_count; j++)
+			title->spu_lang[j] = probe_lang(mat->vts_subp_attr[j].type, mat->vts_subp_attr[j].lang_code);
+	}
+	ddvd_tmap_set_info(tmap, info);
+	Debug(2, "probe: %d titles\n", info->titles);
+	return 0;
+}
+
+int ddvd_probe_main_title(const struct ddvd_disc_info *info)
+{
+	int i, main_title = 0;
+
+	for (i = 0; i < info->titles; i++) {
+		if (info->title[i].seconds > 0 && (main_title == 0 || info->title[i].seconds > info->title[main_title - 1].seconds))
+			main_title = i + 1;
+	}
+	return main_title;
+}
+
+void ddvd_probe_css_keys(const char *path, const int *stop)
+{
+	dvd_reader_t *dvd = DVDOpen(path);
+	ifo_handle_t *vmg;
+	int vtsn = 1;
+
+	if (dvd == NULL)
+		return;
+	vmg = ifoOpen(dvd, 0);
+	if (vmg != NULL && vmg->vmgi_mat != NULL) {
+		for (; vtsn <= vmg->vmgi_mat->vmg_nr_of_title_sets && !__atomic_load_n(stop, __ATOMIC_RELAXED); vtsn++) {
+			dvd_file_t *file = DVDOpenFile(dvd, vtsn, DVD_READ_TITLE_VOBS);
+			if (file != NULL)
+				DVDCloseFile(file);
+		}
+		Debug(2, "probe: css keys of %d title sets ready\n", vtsn - 1);
+	}
+	if (vmg != NULL)
+		ifoClose(vmg);
+	DVDClose(dvd);
+}
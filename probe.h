@@ -0,0 +1,54 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __PROBE_H__
+#define __PROBE_H__
+
+#include "ddvdlib.h"
+#include "tmap.h"
+
+/*
+ * disc info for ddvd_probe, read from the IFO files of the disc
+ *
+ * Chapters and angles come from the title table of the VMG, the audio and subtitle streams
+ * from the attributes of the title set each title is in. The playback time of a title is that
+ * of the PGCs its chapters are in.
+ */
+
+// fill the title table of info, from the cache of tmap when it has one, else from the IFO files
+// (and keep it for the cache), returns -1 if the VMG cannot be read
+int		ddvd_probe_titles(struct ddvd_tmap *tmap, const char *path, struct ddvd_disc_info *info);
+
+// DDVD_AC3 ... of an IFO audio format (audio_attr_t, dvdnav_audio_stream_format), DDVD_UNKNOWN
+// for the formats the player cannot play
+int		ddvd_probe_audio_type(int audio_format);
+
+// the title with the longest playback time, 0 without titles
+int		ddvd_probe_main_title(const struct ddvd_disc_info *info);
+
+// have dvdread fetch the CSS title keys of all title sets of a scrambled disc, so libdvdcss
+// puts them into its key cache (DVDCSS_CACHE) and the player finds them there. Opens the disc
+// with its own dvdread handle, so it can run next to the player, and stops when *stop is set
+void	ddvd_probe_css_keys(const char *path, const int *stop);
+
+#endif
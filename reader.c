@@ -0,0 +1,342 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include "reader.h"
+#include "stats.h"
+#include "debug.h"
+
+#define SLEEP_READER	1
+#define SLEEP_PLAYER	2
+
+// all flags and indices that decide about sleeping are accessed sequentially consistent, so
+// either the waker sees the sleeper or the sleeper sees the new state
+#define LOAD(x)			__atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define STORE(x, v)		__atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+
+static void reader_wake(struct ddvd_reader *r)
+{
+	if (LOAD(r->sleeping)) {
+		pthread_mutex_lock(&r->mutex);
+		pthread_cond_broadcast(&r->cond);
+		pthread_mutex_unlock(&r->mutex);
+	}
+}
+
+// give a block of the dvdnav cache back, the cache has its own lock
+static void reader_release(struct ddvd_reader *r, struct ddvd_block *b)
+{
+	if (b->cache) {
+		dvdnav_free_cache_block(r->dvdnav, b->cache);
+		b->cache = NULL;
+	}
+	b->buf = b->data;
+}
+
+// release the slots from first up to last (exclusive)
+static void reader_release_range(struct ddvd_reader *r, unsigned int first, unsigned int last)
+{
+	for (; first != last; first++)
+		reader_release(r, &r->slot[first % DDVD_READER_SLOTS]);
+}
+
+static int reader_may_read(struct ddvd_reader *r)
+{
+	return LOAD(r->quit) || (!LOAD(r->paused) && !LOAD(r->parked) && r->head - LOAD(r->tail) < DDVD_READER_SLOTS);
+}
+
+static void *reader_thread(void *arg)
+{
+	struct ddvd_reader *r = arg;
+
+	for (;;) {
+		if (!reader_may_read(r)) {
+			pthread_mutex_lock(&r->mutex);
+			__atomic_fetch_or(&r->sleeping, SLEEP_READER, __ATOMIC_SEQ_CST);
+			while (!reader_may_read(r))
+				pthread_cond_wait(&r->cond, &r->mutex);
+			__atomic_fetch_and(&r->sleeping, ~SLEEP_READER, __ATOMIC_SEQ_CST);
+			pthread_mutex_unlock(&r->mutex);
+		}
+		if (LOAD(r->quit))
+			break;
+
+		STORE(r->reading, 1);
+		if (!reader_may_read(r)) {	// the player took the reader in between
+			STORE(r->reading, 0);
+			reader_wake(r);
+			continue;
+		}
+
+		struct ddvd_block *b = &r->slot[r->head % DDVD_READER_SLOTS];
+		uint64_t start = ddvd_stats_clock();
+		// events are always written to the buffer we pass, blocks come from the cache unless
+		// the cache is out of chunks and dvdnav reads into our buffer as well
+		b->buf = b->data;
+		if (r->cache_blocks)
+		{
+			b->result = dvdnav_get_next_cache_block(r->dvdnav, &b->buf, &b->event, &b->len);
+			b->cache = b->buf != b->data ? b->buf : NULL;
+		}
+		else
+			b->result = dvdnav_get_next_block(r->dvdnav, b->data, &b->event, &b->len);
+		b->read_ns = ddvd_stats_clock() - start;
+		if (b->result == DVDNAV_STATUS_OK && b->event == DVDNAV_NAV_PACKET) {
+			memcpy(&b->pci, dvdnav_get_current_nav_pci(r->dvdnav), sizeof(pci_t));
+			memcpy(&b->dsi, dvdnav_get_current_nav_dsi(r->dvdnav), sizeof(dsi_t));
+			b->nav_ok = dvdnav_get_position(r->dvdnav, &b->nav_pos, &b->nav_len) == DVDNAV_STATUS_OK;
+		}
+		if (b->result != DVDNAV_STATUS_OK ||
+			(b->event != DVDNAV_BLOCK_OK && b->event != DVDNAV_NAV_PACKET && b->event != DVDNAV_NOP)) {
+			STORE(r->park_at, r->head + 1);
+			STORE(r->parked, 1);
+		}
+		STORE(r->head, r->head + 1);
+		STORE(r->reading, 0);
+		reader_wake(r);
+		struct ddvd_loop *loop = LOAD(r->loop);
+		if (loop)
+			ddvd_loop_wake(loop);
+	}
+
+	return NULL;
+}
+
+int ddvd_reader_start(struct ddvd_reader *r, dvdnav_t *dvdnav, int cache_blocks)
+{
+	pthread_condattr_t attr;
+	int i;
+
+	memset(r, 0, sizeof(struct ddvd_reader));
+	r->dvdnav = dvdnav;
+	r->cache_blocks = cache_blocks;
+	r->slot = malloc(DDVD_READER_SLOTS * sizeof(struct ddvd_block));
+	if (r->slot == NULL) {
+		Perror("malloc reader slots");
+		return -1;
+	}
+	for (i = 0; i < DDVD_READER_SLOTS; i++) {
+		r->slot[i].buf = r->slot[i].data;
+		r->slot[i].cache = NULL;
+	}
+
+	pthread_mutex_init(&r->mutex, NULL);
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&r->cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	if (pthread_create(&r->thread, NULL, reader_thread, r) != 0) {
+		Perror("pthread_create reader");
+		pthread_cond_destroy(&r->cond);
+		pthread_mutex_destroy(&r->mutex);
+		free(r->slot);
+		r->slot = NULL;
+		return -1;
+	}
+	r->running = 1;
+	return 0;
+}
+
+void ddvd_reader_stop(struct ddvd_reader *r)
+{
+	if (!r->running)
+		return;
+
+	STORE(r->quit, 1);
+	pthread_mutex_lock(&r->mutex);
+	pthread_cond_broadcast(&r->cond);
+	pthread_mutex_unlock(&r->mutex);
+	pthread_join(r->thread, NULL);
+	reader_release_range(r, r->tail, r->head);
+
+	pthread_cond_destroy(&r->cond);
+	pthread_mutex_destroy(&r->mutex);
+	free(r->slot);
+	r->slot = NULL;
+	r->cur = NULL;
+	r->running = 0;
+}
+
+struct ddvd_block *ddvd_reader_get(struct ddvd_reader *r, int timeout_ms)
+{
+	unsigned int next = r->next;
+
+	if (r->cur) {	// done with the block of the last call
+		next = r->flush ? r->flush_to : next + 1;
+		r->flush = 0;
+		r->cur = NULL;
+		r->next = next;
+	}
+
+	if (LOAD(r->head) == next) {
+		// everything up to the event that stopped the reader is handled, let it go on
+		if (LOAD(r->parked) && LOAD(r->park_at) == next) {
+			STORE(r->parked, 0);
+			reader_wake(r);
+		}
+
+		struct timespec deadline;
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += timeout_ms / 1000;
+		deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
+		if (deadline.tv_nsec >= 1000000000) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000;
+		}
+
+		pthread_mutex_lock(&r->mutex);
+		__atomic_fetch_or(&r->sleeping, SLEEP_PLAYER, __ATOMIC_SEQ_CST);
+		while (LOAD(r->head) == next)
+			if (pthread_cond_timedwait(&r->cond, &r->mutex, &deadline) == ETIMEDOUT)
+				break;
+		__atomic_fetch_and(&r->sleeping, ~SLEEP_PLAYER, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&r->mutex);
+
+		if (LOAD(r->head) == next)
+			return NULL;
+	}
+
+	r->cur = &r->slot[next % DDVD_READER_SLOTS];
+	if (r->cur->result == DVDNAV_STATUS_OK && r->cur->event == DVDNAV_NAV_PACKET) {
+		memcpy(&r->pci, &r->cur->pci, sizeof(pci_t));
+		memcpy(&r->dsi, &r->cur->dsi, sizeof(dsi_t));
+		r->pos_valid = r->cur->nav_ok;
+		r->pos = r->cur->nav_pos;
+		r->pos_len = r->cur->nav_len;
+	}
+	else if (r->cur->result == DVDNAV_STATUS_OK && r->cur->event == DVDNAV_BLOCK_OK)
+		r->pos++;
+	else if (r->cur->result != DVDNAV_STATUS_OK || r->cur->event != DVDNAV_NOP)
+		r->pos_valid = 0;	// the reader stopped at the event, dvdnav is where the player is
+	return r->cur;
+}
+
+int ddvd_reader_held(struct ddvd_reader *r)
+{
+	return r->cur && !r->flush;
+}
+
+uint8_t *ddvd_reader_writable(struct ddvd_reader *r)
+{
+	struct ddvd_block *b = r->cur;
+
+	if (b->buf != b->data) {	// the cache block is given back with the slot
+		memcpy(b->data, b->buf, DVD_VIDEO_LB_LEN);
+		b->buf = b->data;
+	}
+	return b->data;
+}
+
+void ddvd_reader_recycle(struct ddvd_reader *r)
+{
+	if (!r->running || r->tail == r->next)
+		return;
+
+	reader_release_range(r, r->tail, r->next);
+	STORE(r->tail, r->next);
+	reader_wake(r);
+}
+
+dvdnav_status_t ddvd_reader_position(struct ddvd_reader *r, uint32_t *pos, uint32_t *len)
+{
+	if (!r->running || !r->pos_valid)
+		return dvdnav_get_position(r->dvdnav, pos, len);
+	*pos = r->pos < r->pos_len ? r->pos : r->pos_len;
+	*len = r->pos_len;
+	return DVDNAV_STATUS_OK;
+}
+
+int ddvd_reader_ready(struct ddvd_reader *r)
+{
+	unsigned int next = r->next;
+
+	if (r->cur)
+		next = r->flush ? r->flush_to : next + 1;
+	return r->running && LOAD(r->head) != next;
+}
+
+int ddvd_reader_sleep(struct ddvd_reader *r, struct ddvd_loop *loop)
+{
+	if (!r->running)
+		return 1;
+
+	STORE(r->loop, loop);
+	if (ddvd_reader_ready(r)) {	// the reader was faster
+		STORE(r->loop, NULL);
+		return 0;
+	}
+	return 1;
+}
+
+void ddvd_reader_awake(struct ddvd_reader *r)
+{
+	if (r->running)
+		STORE(r->loop, NULL);
+}
+
+void ddvd_reader_lock(struct ddvd_reader *r)
+{
+	if (!r->running || r->locked++)
+		return;
+
+	STORE(r->paused, 1);
+	if (LOAD(r->reading)) {
+		pthread_mutex_lock(&r->mutex);
+		__atomic_fetch_or(&r->sleeping, SLEEP_PLAYER, __ATOMIC_SEQ_CST);
+		while (LOAD(r->reading))
+			pthread_cond_wait(&r->cond, &r->mutex);
+		__atomic_fetch_and(&r->sleeping, ~SLEEP_PLAYER, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&r->mutex);
+	}
+}
+
+void ddvd_reader_unlock(struct ddvd_reader *r, int flush)
+{
+	if (!r->running)
+		return;
+
+	r->flush_pending |= flush;
+	if (--r->locked)
+		return;
+
+	if (r->flush_pending) {	// the reader is idle, head does not move
+		if (r->cur) {	// the player may still look at its block, drop the rest with the next get
+			r->flush = 1;
+			r->flush_to = r->head;
+		}
+		else	// queued output may still point into the dropped slots, recycle frees them
+			r->next = r->head;
+		// the reader stays parked when the player is still handling the event that parked it
+		if (!r->cur || LOAD(r->park_at) != r->next + 1)
+			STORE(r->parked, 0);
+		r->flush_pending = 0;
+		r->pos_valid = 0;	// until the first nav packet after the jump
+	}
+	STORE(r->paused, 0);
+	reader_wake(r);
+}
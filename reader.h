@@ -0,0 +1,135 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __READER_H__
+#define __READER_H__
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include <dvdnav/dvdnav.h>
+
+#include "loop.h"
+
+/*
+ * reader thread, reads blocks and nav events from dvdnav ahead of the player loop
+ *
+ * The blocks go into a ring with a single producer (the reader) and a single consumer (the
+ * player loop). head and tail are only written by their owner, so filling and draining the
+ * ring needs no lock. The mutex and condition are only used to sleep on a full or empty ring.
+ *
+ * Blocks, nav packets and NOPs are read ahead. After any other event the reader stops until
+ * the player has handled it, because the player asks dvdnav about the new state (title,
+ * streams, still flag, ...) and does the jumps the event asks for. Jumps done by the player
+ * itself (keys, trick mode, resume) go between ddvd_reader_lock and ddvd_reader_unlock, which
+ * throws away what was read before the jump.
+ *
+ * Drained slots are only handed back to the reader by ddvd_reader_recycle, so the output can
+ * queue pieces of several blocks without copying them and write them at once.
+ *
+ * With cache blocks the reader takes the blocks from the read-ahead cache of dvdnav instead
+ * of copying them into the slot. The cache block is given back when the slot is recycled,
+ * blocks the player wants to change are copied first (ddvd_reader_writable).
+ */
+
+#define DDVD_READER_SLOTS	64	// 128 KB of MPEG data ahead
+
+struct ddvd_block {
+	dvdnav_status_t result;
+	int event;
+	int len;
+	uint8_t *buf;					// the block, data or cache
+	uint8_t *cache;					// block of the dvdnav cache to give back, or NULL
+	uint64_t read_ns;				// time dvdnav_get_next_block took
+	pci_t pci;						// DVDNAV_NAV_PACKET: the nav data of this packet, the
+	dsi_t dsi;						// ones of dvdnav already belong to a later packet
+	int nav_ok;						// DVDNAV_NAV_PACKET: dvdnav_get_position of the packet
+	uint32_t nav_pos, nav_len;
+	uint8_t data[DVD_VIDEO_LB_LEN];
+};
+
+struct ddvd_reader {
+	dvdnav_t *dvdnav;
+	int cache_blocks;				// use dvdnav_get_next_cache_block
+	struct ddvd_block *slot;		// DDVD_READER_SLOTS
+	unsigned int head;				// next slot to fill, written by the reader
+	unsigned int tail;				// slots before are free again, written by the player
+	unsigned int next;				// next slot to drain, player only
+	struct ddvd_block *cur;			// slot the player is working on, released by the next get
+	pci_t pci;						// nav data of the last nav packet the player got
+	dsi_t dsi;
+	int pos_valid;					// pos is the dvdnav position of the block the player got last
+	uint32_t pos, pos_len;
+	int parked;						// reader waits for the player to handle an event
+	unsigned int park_at;			// next once the event is handled
+	int flush;						// the next get continues at flush_to
+	unsigned int flush_to;
+	int paused;						// player holds the reader (ddvd_reader_lock)
+	int locked;						// nesting of ddvd_reader_lock, player only
+	int flush_pending;				// an inner unlock asked for a flush
+	int reading;					// reader is inside dvdnav_get_next_block
+	int quit;
+	int sleeping;					// 1: reader, 2: player waits on cond
+	struct ddvd_loop *loop;			// player sleeps in its event loop, wake it with the next block
+	int running;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+};
+
+int		ddvd_reader_start(struct ddvd_reader *r, dvdnav_t *dvdnav, int cache_blocks);
+void	ddvd_reader_stop(struct ddvd_reader *r);
+
+// next block or event, waits at most timeout_ms and returns NULL when nothing arrived, the
+// block stays valid until the next call, its data until the next ddvd_reader_recycle
+struct ddvd_block *ddvd_reader_get(struct ddvd_reader *r, int timeout_ms);
+
+// give the drained slots back to the reader, nothing may point into them any more
+void	ddvd_reader_recycle(struct ddvd_reader *r);
+
+// the block of the last ddvd_reader_get is still current, no flush dropped it since
+int		ddvd_reader_held(struct ddvd_reader *r);
+
+// a block or event is waiting, ddvd_reader_get would not sleep
+int		ddvd_reader_ready(struct ddvd_reader *r);
+
+// the player wants to sleep in loop, returns 0 (and does not register) when a block is ready,
+// ddvd_reader_awake ends it
+int		ddvd_reader_sleep(struct ddvd_reader *r, struct ddvd_loop *loop);
+void	ddvd_reader_awake(struct ddvd_reader *r);
+
+// the data of the current block in memory the player may change, a block of the dvdnav
+// cache is copied into the slot (the cache would hand out the changed block again), pieces
+// of the block queued before stay valid
+uint8_t *ddvd_reader_writable(struct ddvd_reader *r);
+
+// dvdnav_get_position of the block the player got last instead of the one read last, resume and
+// seeks start from what was demuxed, not from up to DDVD_READER_SLOTS blocks ahead
+dvdnav_status_t ddvd_reader_position(struct ddvd_reader *r, uint32_t *pos, uint32_t *len);
+
+// stop the reader before jumping with dvdnav, unlock with flush set drops what was read before.
+// Calls nest, the reader goes on (and the flush is done) with the outermost unlock
+void	ddvd_reader_lock(struct ddvd_reader *r);
+void	ddvd_reader_unlock(struct ddvd_reader *r, int flush);
+
+#endif
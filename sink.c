@@ -0,0 +1,1019 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sink.h"
+#include "debug.h"
+#include "ddvdlib.h"
+
+static ssize_t sink_safe_write(int fd, const void *buf, size_t count)
+{
+	const uint8_t *ptr = buf;
+	size_t written = 0;
+	ssize_t n;
+
+	while (written < count) {
+		n = write(fd, &ptr[written], count - written);
+		if (n < 0) {
+			if (errno == EAGAIN)	// non-blocking device is full, the caller keeps the rest
+				break;
+			if (errno != EINTR) {
+				Perror("write");
+				return written ? (ssize_t)written : -1;
+			}
+		}
+		else if (n == 0)	// device takes nothing, a short write
+			break;
+		else
+			written += n;
+	}
+
+	return written;
+}
+
+// writes everything a blocking fd takes, iov is changed on partial writes
+static ssize_t sink_safe_writev(int fd, struct iovec *iov, int cnt)
+{
+	size_t written = 0;
+	ssize_t n;
+
+	while (cnt > 0) {
+		n = writev(fd, iov, cnt);
+		if (n < 0) {
+			if (errno == EAGAIN)
+				break;
+			if (errno != EINTR) {
+				Perror("writev");
+				return written ? (ssize_t)written : -1;
+			}
+			continue;
+		}
+		if (n == 0)
+			break;
+		written += n;
+		while (cnt > 0 && (size_t)n >= iov->iov_len) {
+			n -= iov->iov_len;
+			iov++;
+			cnt--;
+		}
+		if (cnt > 0) {
+			iov->iov_base = (uint8_t *)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+
+	return written;
+}
+
+static size_t sink_iov_len(const struct iovec *iov, int cnt)
+{
+	size_t len = 0;
+
+	while (cnt--)
+		len += iov++->iov_len;
+	return len;
+}
+
+static void sink_close_fds(struct ddvd_sink *sink)
+{
+	int fds[2 * DDVD_DEV_MAX];
+	int i, j, n = 0;
+
+	for (i = 0; i < DDVD_DEV_MAX; i++) {
+		fds[n++] = sink->write_fd[i];
+		fds[n++] = sink->ctl_fd[i];
+		sink->write_fd[i] = sink->ctl_fd[i] = -1;
+	}
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < i; j++) {	// api 3 uses the same fd for writes and control
+			if (fds[j] == fds[i])
+				break;
+		}
+		if (fds[i] != -1 && j == i)
+			close(fds[i]);
+	}
+}
+
+/*
+ * dvb backend, the real decoder devices
+ */
+
+#if CONFIG_API_VERSION == 3
+static void write_string(const char *filename, const char *string)
+{
+	FILE *f;
+
+	f = fopen(filename, "w");
+	if (f == NULL) {
+		Perror(filename);
+		return;
+	}
+
+	fputs(string, f);
+	fclose(f);
+}
+#endif
+
+static int dvb_open_dev(const char *name, int flags)
+{
+	int fd = open(name, flags);
+	if (fd == -1)
+		Perror(name);
+	return fd;
+}
+
+static int dvb_open(struct ddvd_sink *sink)
+{
+	int nonblock = sink->nonblock ? O_NONBLOCK : 0;
+
+#if CONFIG_API_VERSION == 1
+	sink->write_fd[DDVD_DEV_VIDEO] = dvb_open_dev("/dev/video", O_WRONLY | nonblock);
+	if (sink->write_fd[DDVD_DEV_VIDEO] == -1)
+		goto err;
+	sink->ctl_fd[DDVD_DEV_VIDEO] = dvb_open_dev("/dev/dvb/card0/video0", O_RDWR);
+	if (sink->ctl_fd[DDVD_DEV_VIDEO] == -1)
+		goto err;
+	sink->ctl_fd[DDVD_DEV_AUDIO] = dvb_open_dev("/dev/dvb/card0/audio0", O_RDWR);
+	if (sink->ctl_fd[DDVD_DEV_AUDIO] == -1)
+		goto err;
+	sink->write_fd[DDVD_DEV_AUDIO] = dvb_open_dev("/dev/sound/dsp1", O_RDWR | nonblock);
+	if (sink->write_fd[DDVD_DEV_AUDIO] == -1)
+		goto err;
+#elif CONFIG_API_VERSION == 3
+	sink->write_fd[DDVD_DEV_VIDEO] = sink->ctl_fd[DDVD_DEV_VIDEO] = dvb_open_dev("/dev/dvb/adapter0/video0", O_RDWR | nonblock);
+	if (sink->ctl_fd[DDVD_DEV_VIDEO] == -1)
+		goto err;
+	sink->write_fd[DDVD_DEV_AUDIO] = sink->ctl_fd[DDVD_DEV_AUDIO] = dvb_open_dev("/dev/dvb/adapter0/audio0", O_RDWR | nonblock);
+	if (sink->ctl_fd[DDVD_DEV_AUDIO] == -1)
+		goto err;
+
+	// set decoder buffer offsets to a minimum
+	write_string("/proc/stb/pcr/pcr_stc_offset", "200");
+	write_string("/proc/stb/vmpeg/0/sync_offset", "200");
+#else
+# error please define CONFIG_API_VERSION to be 1 or 3
+#endif
+	return 0;
+
+err:
+	sink_close_fds(sink);
+	return -1;
+}
+
+static void dvb_close(struct ddvd_sink *sink)
+{
+	sink_close_fds(sink);
+#if CONFIG_API_VERSION == 3
+	// reset decoder buffer offsets
+	write_string("/proc/stb/pcr/pcr_stc_offset", "2710");
+	write_string("/proc/stb/vmpeg/0/sync_offset", "2710");
+#endif
+}
+
+static ssize_t dvb_write(struct ddvd_sink *sink, int dev, const void *buf, size_t count)
+{
+	if (sink->write_fd[dev] == -1)	// no decoder for this stream
+		return count;
+	return sink_safe_write(sink->write_fd[dev], buf, count);
+}
+
+static ssize_t dvb_writev(struct ddvd_sink *sink, int dev, struct iovec *iov, int cnt)
+{
+	if (sink->write_fd[dev] == -1)
+		return sink_iov_len(iov, cnt);
+	return sink_safe_writev(sink->write_fd[dev], iov, cnt);
+}
+
+static int dvb_ioctl(struct ddvd_sink *sink, int dev, unsigned long request, unsigned long arg)
+{
+#if CONFIG_API_VERSION == 1
+	if (request == VIDEO_GET_PTS)	// pts is only available on the mpeg device
+		return ioctl(sink->write_fd[dev], request, arg);
+#endif
+	return ioctl(sink->ctl_fd[dev], request, arg);
+}
+
+static const struct ddvd_sink_ops dvb_ops = {
+	.name  = "dvb",
+	.open  = dvb_open,
+	.close = dvb_close,
+	.write = dvb_write,
+	.writev = dvb_writev,
+	.ioctl = dvb_ioctl,
+};
+
+/*
+ * file and memory backend, records the PES streams and control calls and emulates
+ * just enough of the decoder (pts, size) to keep the player going without hardware
+ */
+
+static const char *dev_name[DDVD_DEV_MAX] = { "video", "audio", "spu" };
+
+enum { SINK_ARG_NONE, SINK_ARG_INT, SINK_ARG_PTR };
+
+// what the optional argument of a control call is, ioctls without a size take an int or nothing
+static int sink_ioctl_arg(unsigned long request)
+{
+	if (_IOC_DIR(request) != _IOC_NONE)
+		return SINK_ARG_PTR;
+
+	switch (request) {
+		case VIDEO_PLAY:
+		case VIDEO_FREEZE:
+		case VIDEO_CONTINUE:
+		case VIDEO_CLEAR_BUFFER:
+		case AUDIO_STOP:
+		case AUDIO_PLAY:
+		case AUDIO_PAUSE:
+		case AUDIO_CONTINUE:
+		case AUDIO_CLEAR_BUFFER:
+			return SINK_ARG_NONE;
+		default:
+			return SINK_ARG_INT;
+	}
+}
+
+// the decoder would display this pts next, take it as current decoder time
+static void sink_track_pts(struct ddvd_sink *sink, int dev, const uint8_t *p, size_t count)
+{
+	if (dev == DDVD_DEV_VIDEO && count >= 14 && p[0] == 0 && p[1] == 0 && p[2] == 1 &&
+		(p[3] & 0xF0) == 0xE0 && (p[7] & 128)) {
+		sink->pts = ((unsigned long long)((p[9] >> 1) & 7)) << 30;
+		sink->pts |= p[10] << 22;
+		sink->pts |= (p[11] >> 1) << 15;
+		sink->pts |= p[12] << 7;
+		sink->pts |= (p[13] >> 1);
+	}
+}
+
+static int file_open(struct ddvd_sink *sink)
+{
+	char name[1024];
+	int i;
+
+	if (sink->path == NULL) // memory backend, only count
+		return 0;
+
+	for (i = 0; i < DDVD_DEV_MAX; i++) {
+		snprintf(name, sizeof(name), "%s.%s.pes", sink->path, dev_name[i]);
+		sink->write_fd[i] = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (sink->write_fd[i] == -1) {
+			Perror(name);
+			goto err;
+		}
+	}
+	snprintf(name, sizeof(name), "%s.ctl", sink->path);
+	sink->log = fopen(name, "w");
+	if (sink->log == NULL) {
+		Perror(name);
+		goto err;
+	}
+	return 0;
+
+err:
+	sink_close_fds(sink);
+	return -1;
+}
+
+static void file_close(struct ddvd_sink *sink)
+{
+	sink_close_fds(sink);
+	if (sink->log != NULL) {
+		fclose(sink->log);
+		sink->log = NULL;
+	}
+}
+
+static ssize_t file_write(struct ddvd_sink *sink, int dev, const void *buf, size_t count)
+{
+	sink_track_pts(sink, dev, buf, count);
+
+	if (sink->write_fd[dev] == -1)
+		return count;
+	return sink_safe_write(sink->write_fd[dev], buf, count);
+}
+
+static ssize_t file_writev(struct ddvd_sink *sink, int dev, struct iovec *iov, int cnt)
+{
+	int i;
+
+	for (i = 0; i < cnt; i++)
+		sink_track_pts(sink, dev, iov[i].iov_base, iov[i].iov_len);
+
+	if (sink->write_fd[dev] == -1)
+		return sink_iov_len(iov, cnt);
+	return sink_safe_writev(sink->write_fd[dev], iov, cnt);
+}
+
+static int file_ioctl(struct ddvd_sink *sink, int dev, unsigned long request, unsigned long arg)
+{
+	int ret = 0;
+
+	switch (request) {
+		case VIDEO_GET_PTS:
+#if CONFIG_API_VERSION == 1
+			*(unsigned int *)arg = sink->pts;
+#else
+			*(unsigned long long *)arg = sink->pts;
+#endif
+			break;
+#if CONFIG_API_VERSION == 3
+		case VIDEO_GET_EVENT:
+			errno = EAGAIN;	// no decoder, no events
+			ret = -1;
+			break;
+		case VIDEO_GET_SIZE:
+		{
+			video_size_t *size = (video_size_t *)arg;
+			size->w = 720;
+			size->h = 576;
+			size->aspect_ratio = 0;
+			break;
+		}
+		case VIDEO_GET_FRAME_RATE:
+			*(unsigned int *)arg = 25000;
+			break;
+#endif
+		default:
+			break;
+	}
+
+	if (sink->log != NULL) {
+		if (sink_ioctl_arg(request) == SINK_ARG_INT)
+			fprintf(sink->log, "%" PRIu64 " %s 0x%08lx %d\n", sink->bytes[dev], dev_name[dev], request, (int)arg);
+		else
+			fprintf(sink->log, "%" PRIu64 " %s 0x%08lx -\n", sink->bytes[dev], dev_name[dev], request);
+	}
+
+	return ret;
+}
+
+static const struct ddvd_sink_ops file_ops = {
+	.name  = "file",
+	.open  = file_open,
+	.close = file_close,
+	.write = file_write,
+	.writev = file_writev,
+	.ioctl = file_ioctl,
+};
+
+/*
+ * ts backend, multiplexes the PES streams into a single program MPEG transport stream
+ */
+
+#define TS_PACKET_SIZE		188
+#define TS_PID_PAT			0x0000
+#define TS_PID_PMT			0x0100
+#define TS_PID_PCR			0x0101	// the video pid carries the pcr
+#define TS_PSI_INTERVAL		4000	// repeat PAT and PMT after this many packets
+#define TS_MUX_DELAY		45000	// pcr runs 0.5s in front of the video decode time
+#define TS_PES_MAX			(65535 + 6)
+#define TS_OUT_PACKETS		348		// about 64k per write
+
+static const int ts_pid[DDVD_DEV_MAX] = { 0x0101, 0x0102, 0x0103 };
+
+struct ddvd_ts {
+	int fd;
+	int error;
+	uint8_t pes[DDVD_DEV_MAX][TS_PES_MAX];	// the player may split or join PES packets in its writes
+	int pes_len[DDVD_DEV_MAX];
+	uint8_t cc[DDVD_DEV_MAX];				// continuity counters
+	uint8_t cc_pat, cc_pmt;
+	int audio_type;							// stream type of the audio pid in the PMT
+	int private_type;						// stream type of private stream 1 audio, follows AUDIO_SET_BYPASS_MODE
+	int pmt_version;
+	int psi_due;							// write PAT and PMT before the next PES
+	unsigned long since_psi;
+	long long last_pcr;
+	uint8_t out[TS_OUT_PACKETS * TS_PACKET_SIZE];
+	int out_len;
+};
+
+static uint32_t ts_crc32(const uint8_t *data, int len)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	int i;
+
+	while (len--) {
+		crc ^= (uint32_t)*data++ << 24;
+		for (i = 0; i < 8; i++)
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+	}
+	return crc;
+}
+
+static void ts_flush(struct ddvd_ts *ts)
+{
+	if (ts->out_len && sink_safe_write(ts->fd, ts->out, ts->out_len) != ts->out_len)
+		ts->error = 1;
+	ts->out_len = 0;
+}
+
+static uint8_t *ts_packet(struct ddvd_ts *ts, int pid, int start, uint8_t *cc)
+{
+	uint8_t *p;
+
+	if (ts->out_len == sizeof(ts->out))
+		ts_flush(ts);
+	p = ts->out + ts->out_len;
+	ts->out_len += TS_PACKET_SIZE;
+	ts->since_psi++;
+
+	p[0] = 0x47;
+	p[1] = (start ? 0x40 : 0) | (pid >> 8);
+	p[2] = pid & 0xFF;
+	p[3] = 0x10 | (*cc & 0x0F);	// payload only, the caller adds an adaptation field
+	*cc = (*cc + 1) & 0x0F;
+	return p;
+}
+
+static void ts_write_section(struct ddvd_ts *ts, int pid, uint8_t *cc, uint8_t *sec, int len)
+{
+	uint8_t *p = ts_packet(ts, pid, 1, cc);
+	uint32_t crc;
+
+	sec[1] = 0xB0 | ((len + 4 - 3) >> 8);	// section length counts from after the length field, crc included
+	sec[2] = (len + 4 - 3) & 0xFF;
+	crc = ts_crc32(sec, len);
+	sec[len++] = crc >> 24;
+	sec[len++] = crc >> 16;
+	sec[len++] = crc >> 8;
+	sec[len++] = crc;
+
+	p[4] = 0;	// pointer field
+	memcpy(p + 5, sec, len);
+	memset(p + 5 + len, 0xFF, TS_PACKET_SIZE - 5 - len);
+}
+
+static int ts_add_stream(uint8_t *sec, int type, int pid)
+{
+	sec[0] = type;
+	sec[1] = 0xE0 | (pid >> 8);
+	sec[2] = pid & 0xFF;
+	sec[3] = 0xF0;
+	sec[4] = 0;
+	return 5;
+}
+
+static void ts_write_psi(struct ddvd_ts *ts)
+{
+	uint8_t sec[64];
+	int len;
+
+	// PAT, program 1 only
+	sec[0] = 0x00;
+	sec[3] = 0x00;
+	sec[4] = 0x01;	// transport stream id
+	sec[5] = 0xC1;
+	sec[6] = sec[7] = 0;
+	sec[8] = 0x00;
+	sec[9] = 0x01;
+	sec[10] = 0xE0 | (TS_PID_PMT >> 8);
+	sec[11] = TS_PID_PMT & 0xFF;
+	ts_write_section(ts, TS_PID_PAT, &ts->cc_pat, sec, 12);
+
+	// PMT
+	sec[0] = 0x02;
+	sec[3] = 0x00;
+	sec[4] = 0x01;	// program number
+	sec[5] = 0xC1 | (ts->pmt_version << 1);
+	sec[6] = sec[7] = 0;
+	sec[8] = 0xE0 | (TS_PID_PCR >> 8);
+	sec[9] = TS_PID_PCR & 0xFF;
+	sec[10] = 0xF0;
+	sec[11] = 0;
+	len = 12;
+	len += ts_add_stream(sec + len, 0x02, ts_pid[DDVD_DEV_VIDEO]);	// mpeg2 video
+	len += ts_add_stream(sec + len, ts->audio_type, ts_pid[DDVD_DEV_AUDIO]);
+	len += ts_add_stream(sec + len, 0x06, ts_pid[DDVD_DEV_SPU]);	// dvd subpictures as private data
+	ts_write_section(ts, TS_PID_PMT, &ts->cc_pmt, sec, len);
+
+	ts->psi_due = 0;
+	ts->since_psi = 0;
+}
+
+// the audio pid carries mpeg audio (also transcoded lpcm) or the ac3/dts bypass format
+static void ts_set_audio_type(struct ddvd_ts *ts, const uint8_t *pes)
+{
+	int type = (pes[3] & 0xE0) == 0xC0 ? 0x03 : ts->private_type;
+
+	if (type != ts->audio_type) {
+		ts->audio_type = type;
+		ts->pmt_version = (ts->pmt_version + 1) & 0x1F;
+		ts->psi_due = 1;
+	}
+}
+
+static void ts_write_pes(struct ddvd_ts *ts, int dev, const uint8_t *pes, int len)
+{
+	long long pcr = -1;
+	int discontinuity = 0;
+	int start = 1;
+
+	if (dev == DDVD_DEV_AUDIO)
+		ts_set_audio_type(ts, pes);
+
+	if (dev == DDVD_DEV_VIDEO && (pes[7] & 0x80) && len >= 19) {
+		const uint8_t *t = (pes[7] & 0x40) ? pes + 14 : pes + 9;	// decode time if given, else pts
+		long long dts = ((long long)((t[0] >> 1) & 7)) << 30 | t[1] << 22 | (t[2] >> 1) << 15 | t[3] << 7 | (t[4] >> 1);
+		pcr = (dts - TS_MUX_DELAY) & 0x1FFFFFFFFLL;
+		if (ts->last_pcr >= 0 && (pcr < ts->last_pcr || pcr > ts->last_pcr + 90000))
+			discontinuity = 1;	// new cell or pgc
+		ts->last_pcr = pcr;
+	}
+
+	if (ts->psi_due || (dev == DDVD_DEV_VIDEO && ts->since_psi >= TS_PSI_INTERVAL))
+		ts_write_psi(ts);
+
+	while (len > 0) {
+		uint8_t *p = ts_packet(ts, ts_pid[dev], start, &ts->cc[dev]);
+		int af = (start && pcr >= 0) ? 8 : 0;	// adaptation field size incl. length byte
+		int n = TS_PACKET_SIZE - 4 - af;
+
+		if (len < n) {	// stuff the last packet
+			af += n - len;
+			n = len;
+		}
+		if (af) {
+			int k = 6;
+			p[3] |= 0x20;
+			p[4] = af - 1;
+			if (af > 1) {
+				p[5] = 0;
+				if (start && pcr >= 0) {
+					p[5] = 0x10 | (discontinuity ? 0x80 : 0);
+					p[6] = pcr >> 25;
+					p[7] = pcr >> 17;
+					p[8] = pcr >> 9;
+					p[9] = pcr >> 1;
+					p[10] = ((pcr & 1) << 7) | 0x7E;
+					p[11] = 0;
+					k = 12;
+				}
+				memset(p + k, 0xFF, 4 + af - k);
+			}
+		}
+		memcpy(p + 4 + af, pes, n);
+		pes += n;
+		len -= n;
+		start = 0;
+	}
+}
+
+// cut complete PES packets out of the reassembly buffer
+static void ts_parse_pes(struct ddvd_ts *ts, int dev)
+{
+	uint8_t *b = ts->pes[dev];
+	int len = ts->pes_len[dev];
+	int pos = 0;
+
+	while (len - pos >= 9) {
+		int plen;
+		if (b[pos] != 0 || b[pos + 1] != 0 || b[pos + 2] != 1) {	// resync
+			pos++;
+			continue;
+		}
+		plen = (b[pos + 4] << 8 | b[pos + 5]) + 6;
+		if (plen == 6) {	// header only packet to flush the decoder, nothing to carry
+			if (len - pos < 9 + b[pos + 8])
+				break;
+			pos += 9 + b[pos + 8];
+			continue;
+		}
+		if (len - pos < plen)
+			break;
+		ts_write_pes(ts, dev, b + pos, plen);
+		pos += plen;
+	}
+
+	memmove(b, b + pos, len - pos);
+	ts->pes_len[dev] = len - pos;
+}
+
+static int ts_open(struct ddvd_sink *sink)
+{
+	struct ddvd_ts *ts;
+
+	if (sink->path == NULL) {
+		Debug(1, "ts output needs a file to write to\n");
+		return -1;
+	}
+	ts = calloc(1, sizeof(struct ddvd_ts));
+	if (ts == NULL) {
+		Perror("ts multiplexer <mem allocation failed>");
+		return -1;
+	}
+	ts->fd = open(sink->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (ts->fd == -1) {
+		Perror(sink->path);
+		free(ts);
+		return -1;
+	}
+	ts->audio_type = 0x03;	// mpeg audio until the first audio packet tells otherwise
+	ts->private_type = 0x81;
+	ts->psi_due = 1;
+	ts->last_pcr = -1;
+	sink->ts = ts;
+	return 0;
+}
+
+static void ts_close(struct ddvd_sink *sink)
+{
+	struct ddvd_ts *ts = sink->ts;
+
+	ts_flush(ts);	// incomplete PES packets are dropped
+	close(ts->fd);
+	free(ts);
+	sink->ts = NULL;
+}
+
+static ssize_t ts_write(struct ddvd_sink *sink, int dev, const void *buf, size_t count)
+{
+	struct ddvd_ts *ts = sink->ts;
+	const uint8_t *p = buf;
+	size_t left = count;
+
+	sink_track_pts(sink, dev, buf, count);
+
+	while (left > 0) {
+		size_t n = TS_PES_MAX - ts->pes_len[dev];
+		if (n > left)
+			n = left;
+		memcpy(ts->pes[dev] + ts->pes_len[dev], p, n);
+		ts->pes_len[dev] += n;
+		p += n;
+		left -= n;
+		ts_parse_pes(ts, dev);
+	}
+
+	return ts->error ? -1 : (ssize_t)count;
+}
+
+static int ts_ioctl(struct ddvd_sink *sink, int dev, unsigned long request, unsigned long arg)
+{
+	struct ddvd_ts *ts = sink->ts;
+
+	if (request == AUDIO_SET_BYPASS_MODE) {
+		int type;
+		switch ((int)arg) {
+			case 0: type = 0x81; break;	// ac3
+			case 1: type = 0x03; break;	// mpeg audio
+			case 2: type = 0x82; break;	// dts
+			default:					// lpcm and the unstripped dvd formats, the player falls back to mp2
+				errno = EINVAL;
+				return -1;
+		}
+		if (type != 0x03)	// mpeg audio comes with its own stream id, lpcm fallback included
+			ts->private_type = type;
+		return 0;
+	}
+
+	return file_ioctl(sink, dev, request, arg);
+}
+
+static const struct ddvd_sink_ops ts_ops = {
+	.name  = "ts",
+	.open  = ts_open,
+	.close = ts_close,
+	.write = ts_write,
+	.ioctl = ts_ioctl,
+};
+
+/*
+ * sink interface
+ */
+
+void ddvd_sink_init(struct ddvd_sink *sink, int type, const char *path)
+{
+	int i;
+
+	memset(sink, 0, sizeof(struct ddvd_sink));
+	for (i = 0; i < DDVD_DEV_MAX; i++)
+		sink->write_fd[i] = sink->ctl_fd[i] = -1;
+
+	switch (type) {
+		case DDVD_SINK_FILE:
+			sink->ops = &file_ops;
+			sink->path = path;
+			break;
+		case DDVD_SINK_MEMORY:
+			sink->ops = &file_ops;
+			sink->path = NULL;
+			break;
+		case DDVD_SINK_TS:
+			sink->ops = &ts_ops;
+			sink->path = path;
+			break;
+		case DDVD_SINK_DVB:
+		default:
+			sink->ops = &dvb_ops;
+			break;
+	}
+}
+
+int ddvd_sink_open(struct ddvd_sink *sink)
+{
+	Debug(1, "Opening %s output...\n", sink->path ? sink->path : sink->ops->name);
+	return sink->ops->open(sink);
+}
+
+static void sink_pend_add(struct ddvd_sink *sink, int dev, const void *buf, size_t count)
+{
+	if (sink->pend_len[dev] + count > sink->pend_size[dev]) {
+		size_t size = sink->pend_size[dev] ? sink->pend_size[dev] : 65536;
+		uint8_t *pend;
+		while (size < sink->pend_len[dev] + count)
+			size *= 2;
+		pend = realloc(sink->pend[dev], size);
+		if (pend == NULL) {
+			Perror("sink pending output <mem allocation failed>");
+			return;
+		}
+		sink->pend[dev] = pend;
+		sink->pend_size[dev] = size;
+	}
+	memcpy(sink->pend[dev] + sink->pend_len[dev], buf, count);
+	sink->pend_len[dev] += count;
+}
+
+// written bytes of iov went out, keep the rest, the pending output is the first piece if any
+static void sink_keep(struct ddvd_sink *sink, int dev, const struct iovec *iov, int cnt, size_t written)
+{
+	int i = 0;
+
+	if (sink->pend_len[dev]) {
+		if (written < sink->pend_len[dev]) {
+			memmove(sink->pend[dev], sink->pend[dev] + written, sink->pend_len[dev] - written);
+			sink->pend_len[dev] -= written;
+			written = 0;
+		}
+		else {
+			written -= sink->pend_len[dev];
+			sink->pend_len[dev] = 0;
+		}
+		i = 1;
+	}
+	for (; i < cnt; i++) {
+		if (written >= iov[i].iov_len) {
+			written -= iov[i].iov_len;
+			continue;
+		}
+		sink_pend_add(sink, dev, (const uint8_t *)iov[i].iov_base + written, iov[i].iov_len - written);
+		written = 0;
+	}
+}
+
+static int sink_ioctl(struct ddvd_sink *sink, int dev, unsigned long request, unsigned long arg)
+{
+	sink->ioctls++;
+	if (sink->stats)
+		ddvd_stats_count(sink->stats, &sink->stats->s.ioctls[dev], 1);
+	return sink->ops->ioctl(sink, dev, request, arg);
+}
+
+// written pending bytes went out, issue the waiting control calls that were behind them, returns how many
+static int sink_run_deferred(struct ddvd_sink *sink, int dev, size_t written)
+{
+	int i, n = 0;
+
+	for (i = 0; i < sink->defer_cnt[dev]; i++) {
+		struct ddvd_sink_ctl *ctl = &sink->defer[dev][i];
+		if (ctl->at > written) {
+			ctl->at -= written;
+			sink->defer[dev][n++] = *ctl;
+		}
+		else if (sink_ioctl(sink, dev, ctl->request, ctl->arg) < 0)
+			Perror("sink deferred ioctl");
+	}
+	i = sink->defer_cnt[dev] - n;
+	sink->defer_cnt[dev] = n;
+	return i;
+}
+
+static void sink_flush_dev(struct ddvd_sink *sink, int dev)
+{
+	struct iovec iov[DDVD_SINK_IOV_MAX + 1], tmp[DDVD_SINK_IOV_MAX + 1];
+	int cnt = 0, wcnt, i;
+
+	if (sink->pend_len[dev]) {	// what the device did not take last time goes first
+		iov[cnt].iov_base = sink->pend[dev];
+		iov[cnt++].iov_len = sink->pend_len[dev];
+	}
+	for (i = 0; i < sink->iov_cnt[dev]; i++)
+		iov[cnt++] = sink->iov[dev][i];
+	sink->iov_cnt[dev] = 0;
+	if (!cnt)
+		return;
+
+	uint64_t start = sink->stats ? ddvd_stats_clock() : 0;
+	memcpy(tmp, iov, cnt * sizeof(struct iovec));	// writev changes its iov on partial writes
+	wcnt = cnt;
+	if (sink->defer_cnt[dev]) {	// only up to the first waiting control call, the rest is kept behind it
+		tmp[0].iov_len = sink->defer[dev][0].at;
+		wcnt = 1;
+	}
+	ssize_t n = sink->ops->writev(sink, dev, tmp, wcnt);
+	if (n > 0)
+		sink->bytes[dev] += n;
+	sink->writes++;
+	if (sink->stats)
+		ddvd_stats_time(sink->stats, DDVD_STAGE_WRITE, start, &sink->stats->s.bytes[dev], n > 0 ? n : 0);
+
+	if (sink->nonblock && n >= 0)
+		sink_keep(sink, dev, iov, cnt, n);
+	else	// write error, the rest is lost as with a blocking write
+		sink->pend_len[dev] = 0;
+
+	// the decoder may take what was behind the control calls now
+	if (sink->defer_cnt[dev] && sink_run_deferred(sink, dev, n >= 0 ? (size_t)n : (size_t)-1) && sink->pend_len[dev])
+		sink_flush_dev(sink, dev);
+}
+
+// the decoder has to take the pending output before the sink is closed
+static void sink_drain(struct ddvd_sink *sink)
+{
+	uint64_t end = ddvd_stats_clock() + DDVD_SINK_DRAIN_MS * 1000000ULL;
+	struct pollfd pfd[DDVD_DEV_MAX];
+	int i;
+
+	ddvd_sink_flush(sink);
+	while (ddvd_sink_pending(sink)) {
+		if (ddvd_stats_clock() >= end) {
+			Debug(1, "decoder takes no data, dropping %zu pending bytes\n", ddvd_sink_pending(sink));
+			for (i = 0; i < DDVD_DEV_MAX; i++)
+				sink->pend_len[i] = sink->defer_cnt[i] = 0;
+			break;
+		}
+		if (poll(pfd, ddvd_sink_pollfds(sink, pfd, DDVD_DEV_MAX), 100) < 0 && errno != EINTR) {
+			Perror("poll");
+			break;
+		}
+		ddvd_sink_flush(sink);
+	}
+}
+
+void ddvd_sink_close(struct ddvd_sink *sink)
+{
+	int i;
+
+	Debug(2, "Closing output: video %" PRIu64 " bytes, audio %" PRIu64 " bytes, %lu writes, %lu ioctls\n",
+			sink->bytes[DDVD_DEV_VIDEO], sink->bytes[DDVD_DEV_AUDIO], sink->writes, sink->ioctls);
+	sink_drain(sink);
+	sink->ops->close(sink);
+	for (i = 0; i < DDVD_DEV_MAX; i++) {
+		free(sink->pend[i]);
+		sink->pend[i] = NULL;
+		sink->pend_len[i] = sink->pend_size[i] = 0;
+	}
+}
+
+void ddvd_sink_flush(struct ddvd_sink *sink)
+{
+	int i;
+
+	for (i = 0; i < DDVD_DEV_MAX; i++)
+		sink_flush_dev(sink, i);
+}
+
+void ddvd_sink_discard(struct ddvd_sink *sink, int dev)
+{
+	sink->iov_cnt[dev] = 0;
+	sink->pend_len[dev] = 0;
+	sink_run_deferred(sink, dev, (size_t)-1);
+}
+
+size_t ddvd_sink_pending(struct ddvd_sink *sink)
+{
+	size_t pending = 0;
+	int i;
+
+	for (i = 0; i < DDVD_DEV_MAX; i++)
+		pending += sink->pend_len[i];
+	return pending;
+}
+
+int ddvd_sink_pollfds(struct ddvd_sink *sink, struct pollfd *pfd, int max)
+{
+	int i, n = 0;
+
+	for (i = 0; i < DDVD_DEV_MAX && n < max; i++) {
+		if (sink->pend_len[i] && sink->write_fd[i] != -1) {
+			pfd[n].fd = sink->write_fd[i];
+			pfd[n].events = POLLOUT;
+			pfd[n].revents = 0;
+			n++;
+		}
+	}
+	return n;
+}
+
+void ddvd_sink_queue(struct ddvd_sink *sink, int dev, const void *buf, size_t count)
+{
+	struct iovec *last;
+
+	if (sink->ops->writev == NULL) {
+		ddvd_sink_write(sink, dev, buf, count);
+		return;
+	}
+	if (count == 0)
+		return;
+
+	last = sink->iov_cnt[dev] ? &sink->iov[dev][sink->iov_cnt[dev] - 1] : NULL;
+	if (last && (const uint8_t *)last->iov_base + last->iov_len == buf) {	// continues the last piece
+		last->iov_len += count;
+		return;
+	}
+	if (sink->iov_cnt[dev] == DDVD_SINK_IOV_MAX)
+		sink_flush_dev(sink, dev);
+	sink->iov[dev][sink->iov_cnt[dev]].iov_base = (void *)buf;
+	sink->iov[dev][sink->iov_cnt[dev]].iov_len = count;
+	sink->iov_cnt[dev]++;
+}
+
+ssize_t ddvd_sink_write(struct ddvd_sink *sink, int dev, const void *buf, size_t count)
+{
+	if (sink->ops->writev != NULL) {	// behind the queued and pending output of the device
+		ddvd_sink_queue(sink, dev, buf, count);
+		sink_flush_dev(sink, dev);
+		return count;
+	}
+
+	uint64_t start = sink->stats ? ddvd_stats_clock() : 0;
+	ssize_t n = sink->ops->write(sink, dev, buf, count);
+	if (n > 0)
+		sink->bytes[dev] += n;
+	sink->writes++;
+	if (sink->stats)
+		ddvd_stats_time(sink->stats, DDVD_STAGE_WRITE, start, &sink->stats->s.bytes[dev], n > 0 ? n : 0);
+	return n;
+}
+
+// same calling convention as ioctl(2), the optional argument is an int or a pointer
+int ddvd_sink_ioctl(struct ddvd_sink *sink, int dev, unsigned long request, ...)
+{
+	va_list ap;
+	unsigned long arg = 0;
+
+	va_start(ap, request);
+	switch (sink_ioctl_arg(request)) {
+		case SINK_ARG_INT:
+			arg = (unsigned long)va_arg(ap, int);
+			break;
+		case SINK_ARG_PTR:
+			arg = (unsigned long)va_arg(ap, void *);
+			break;
+	}
+	va_end(ap);
+
+	// hand the queued data to the decoder first, without waiting for what a full decoder does not take
+	if (_IOC_DIR(request) != _IOC_READ)
+		sink_flush_dev(sink, dev);
+
+	return sink_ioctl(sink, dev, request, arg);
+}
+
+int ddvd_sink_ioctl_queued(struct ddvd_sink *sink, int dev, unsigned long request, int arg)
+{
+	struct ddvd_sink_ctl *ctl;
+
+	sink_flush_dev(sink, dev);
+	if (!sink->pend_len[dev])
+		return sink_ioctl(sink, dev, request, (unsigned long)arg);
+
+	ctl = sink->defer_cnt[dev] ? &sink->defer[dev][sink->defer_cnt[dev] - 1] : NULL;
+	if (ctl == NULL || ctl->request != request || ctl->at != sink->pend_len[dev]) {	// else the later setting wins
+		if (sink->defer_cnt[dev] == DDVD_SINK_DEFER_MAX) {
+			Debug(1, "too many control calls waiting for the decoder, 0x%08lx goes out now\n", request);
+			return sink_ioctl(sink, dev, request, (unsigned long)arg);
+		}
+		ctl = &sink->defer[dev][sink->defer_cnt[dev]++];
+		ctl->request = request;
+		ctl->at = sink->pend_len[dev];
+	}
+	ctl->arg = (unsigned long)arg;
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __SINK_H__
+#define __SINK_H__
+
+#include "libdreamdvd_config.h"
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <poll.h>
+
+#include "ddvdlib.h"
+#include "stats.h"
+
+#if defined(HAVE_LINUX_DVB_VERSION_H)
+#include <linux/dvb/video.h>
+#include <linux/dvb/audio.h>
+#define CONFIG_API_VERSION 3
+#elif defined(HAVE_OST_DMX_H)
+#include <ost/video.h>
+#include <ost/audio.h>
+#define CONFIG_API_VERSION 1
+#endif
+
+#if CONFIG_API_VERSION == 1
+#define VIDEO_GET_PTS           _IOR('o', 1, unsigned int*)
+#endif
+#if CONFIG_API_VERSION == 3
+#ifndef VIDEO_GET_PTS
+#define VIDEO_GET_PTS              _IOR('o', 57, unsigned long long)
+#endif
+#endif
+
+/*
+ * output sink, everything the player sends to the decoders goes through here
+ *
+ * Pieces of the demuxed blocks are queued per device without copying them and written with a
+ * single writev per device on ddvd_sink_flush. A plain write and any control call that is not
+ * only reading the decoder state flush first, so the order on each device stays the same.
+ *
+ * With nonblock set the decoder devices are opened non-blocking. What a full decoder does not
+ * take is kept (copied) as pending output and written first on the next flush, the player
+ * polls the devices for POLLOUT instead of sleeping in write. Control calls never wait for
+ * the pending output: ddvd_sink_ioctl goes to the decoder right away, ddvd_sink_ioctl_queued
+ * is kept behind the pending output of its device and issued once the decoder took it.
+ * Before a decoder buffer is cleared its output is thrown away with ddvd_sink_discard.
+ * Only closing the sink waits for the pending output, at most DDVD_SINK_DRAIN_MS.
+ */
+
+#define DDVD_SINK_IOV_MAX	64		// pieces queued per device before they are written
+#define DDVD_SINK_DEFER_MAX	8		// control calls waiting behind the pending output per device
+#define DDVD_SINK_DRAIN_MS	2000	// pending output is dropped on close when the decoder takes nothing
+
+struct ddvd_sink;
+struct ddvd_ts;
+
+struct ddvd_sink_ops {
+	const char *name;
+	int		(*open)(struct ddvd_sink *sink);
+	void	(*close)(struct ddvd_sink *sink);
+	ssize_t	(*write)(struct ddvd_sink *sink, int dev, const void *buf, size_t count);
+	ssize_t	(*writev)(struct ddvd_sink *sink, int dev, struct iovec *iov, int cnt);	// NULL: no queue
+	int		(*ioctl)(struct ddvd_sink *sink, int dev, unsigned long request, unsigned long arg);
+};
+
+struct ddvd_sink_ctl {
+	unsigned long request;
+	unsigned long arg;
+	size_t at;						// pending bytes still in front of the call
+};
+
+struct ddvd_sink {
+	const struct ddvd_sink_ops *ops;
+	const char *path;				// file prefix for the file backend (NULL for the memory backend)
+	int nonblock;					// open the decoder devices with O_NONBLOCK
+	int write_fd[DDVD_DEV_MAX];		// fds the PES streams are written to
+	int ctl_fd[DDVD_DEV_MAX];		// fds the control calls go to
+	FILE *log;						// control call log of the file backend
+	uint64_t bytes[DDVD_DEV_MAX];	// bytes written per device
+	unsigned long writes;			// number of write calls
+	struct iovec iov[DDVD_DEV_MAX][DDVD_SINK_IOV_MAX];	// queued pieces
+	int iov_cnt[DDVD_DEV_MAX];
+	uint8_t *pend[DDVD_DEV_MAX];	// output a non-blocking device did not take yet
+	size_t pend_len[DDVD_DEV_MAX];
+	size_t pend_size[DDVD_DEV_MAX];
+	struct ddvd_sink_ctl defer[DDVD_DEV_MAX][DDVD_SINK_DEFER_MAX];	// control calls waiting for pending output
+	int defer_cnt[DDVD_DEV_MAX];
+	unsigned long ioctls;			// number of control calls
+	unsigned long long pts;			// emulated decoder pts (file, memory and ts backend)
+	struct ddvd_ts *ts;				// multiplexer state of the ts backend
+	struct ddvd_stats_ctx *stats;	// player counters, device writes and control calls are added here
+};
+
+// select backend, type is one of the DDVD_SINK_* values from ddvdlib.h, the devices are the DDVD_DEV_* values
+void	ddvd_sink_init(struct ddvd_sink *sink, int type, const char *path);
+int		ddvd_sink_open(struct ddvd_sink *sink);
+void	ddvd_sink_close(struct ddvd_sink *sink);
+ssize_t	ddvd_sink_write(struct ddvd_sink *sink, int dev, const void *buf, size_t count);
+// queue a piece, buf has to stay valid until the next ddvd_sink_flush
+void	ddvd_sink_queue(struct ddvd_sink *sink, int dev, const void *buf, size_t count);
+void	ddvd_sink_flush(struct ddvd_sink *sink);
+// drop the queued and pending output of one device before its decoder is cleared, waiting control calls are issued
+void	ddvd_sink_discard(struct ddvd_sink *sink, int dev);
+// bytes a non-blocking device did not take yet
+size_t	ddvd_sink_pending(struct ddvd_sink *sink);
+// fill pfd with the devices that have pending output (POLLOUT), returns the number of entries
+int		ddvd_sink_pollfds(struct ddvd_sink *sink, struct pollfd *pfd, int max);
+int		ddvd_sink_ioctl(struct ddvd_sink *sink, int dev, unsigned long request, ...);
+// a setting for the output queued from now on (bypass mode, av sync), 0 when it waits behind pending output
+int		ddvd_sink_ioctl_queued(struct ddvd_sink *sink, int dev, unsigned long request, int arg);
+
+#endif
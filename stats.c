@@ -0,0 +1,90 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#include <string.h>
+#include <sched.h>
+
+#include "stats.h"
+
+static inline void stats_begin(struct ddvd_stats_ctx *ctx)
+{
+	ctx->seq++;
+	__atomic_thread_fence(__ATOMIC_RELEASE);	// odd sequence is visible before the data changes
+}
+
+static inline void stats_end(struct ddvd_stats_ctx *ctx)
+{
+	__atomic_thread_fence(__ATOMIC_RELEASE);	// data is visible before the sequence is even again
+	ctx->seq++;
+}
+
+static inline int stats_bucket(uint64_t ns)
+{
+	int bucket = ns ? 63 - __builtin_clzll(ns) : 0;
+	return bucket < DDVD_STATS_BUCKETS ? bucket : DDVD_STATS_BUCKETS - 1;
+}
+
+void ddvd_stats_time(struct ddvd_stats_ctx *ctx, int stage, uint64_t start, unsigned long long *counter, unsigned long long n)
+{
+	ddvd_stats_add(ctx, stage, ddvd_stats_clock() - start, counter, n);
+}
+
+void ddvd_stats_add(struct ddvd_stats_ctx *ctx, int stage, uint64_t ns, unsigned long long *counter, unsigned long long n)
+{
+	struct ddvd_stage_stats *st = &ctx->s.stage[stage];
+
+	stats_begin(ctx);
+	st->count++;
+	st->total_ns += ns;
+	if (ns > st->max_ns)
+		st->max_ns = ns;
+	st->hist[stats_bucket(ns)]++;
+	if (counter)
+		*counter += n;
+	stats_end(ctx);
+}
+
+void ddvd_stats_count(struct ddvd_stats_ctx *ctx, unsigned long long *counter, unsigned long long n)
+{
+	stats_begin(ctx);
+	*counter += n;
+	stats_end(ctx);
+}
+
+void ddvd_stats_read(struct ddvd_stats_ctx *ctx, struct ddvd_stats *stats)
+{
+	unsigned int seq;
+
+	for (;;) {
+		seq = ctx->seq;
+		if (seq & 1) {	// the player is in the middle of an update
+			sched_yield();
+			continue;
+		}
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		memcpy(stats, &ctx->s, sizeof(struct ddvd_stats));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (ctx->seq == seq)
+			return;
+	}
+}
@@ -0,0 +1,65 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include <stdint.h>
+#include <time.h>
+
+#include "ddvdlib.h"
+
+/*
+ * performance counters of the player
+ *
+ * Only the player thread writes the counters, any other thread may read them with
+ * ddvd_get_stats. A sequence counter makes the copy consistent without a lock: it is odd
+ * while an update is in progress and the reader retries when it changed during the copy.
+ */
+
+struct ddvd_stats_ctx {
+	volatile unsigned int seq;
+	struct ddvd_stats s;
+};
+
+static inline uint64_t ddvd_stats_clock(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// add one call of stage that started at start (from ddvd_stats_clock), counter is optional
+// and is increased by n in the same update
+void ddvd_stats_time(struct ddvd_stats_ctx *ctx, int stage, uint64_t start, unsigned long long *counter, unsigned long long n);
+
+// same for a call that was timed elsewhere (another thread), ns is its duration
+void ddvd_stats_add(struct ddvd_stats_ctx *ctx, int stage, uint64_t ns, unsigned long long *counter, unsigned long long n);
+
+// increase one of the plain counters in ctx->s by n
+void ddvd_stats_count(struct ddvd_stats_ctx *ctx, unsigned long long *counter, unsigned long long n);
+
+// consistent copy of the counters, may be called from any thread
+void ddvd_stats_read(struct ddvd_stats_ctx *ctx, struct ddvd_stats *stats);
+
+#endif
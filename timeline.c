@@ -0,0 +1,145 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#include <string.h>
+
+#include "timeline.h"
+#include "debug.h"
+
+#define SEG(tl, n)	(&(tl)->seg[(n) % DDVD_TIMELINE_SEGMENTS])
+
+void ddvd_timeline_init(struct ddvd_timeline *tl)
+{
+	memset(tl, 0, sizeof(struct ddvd_timeline));
+}
+
+void ddvd_timeline_flush(struct ddvd_timeline *tl)
+{
+	tl->open = 0;
+	tl->decoder_valid = 0;
+}
+
+static void timeline_segment(struct ddvd_timeline *tl, unsigned long long start, unsigned long long end)
+{
+	struct ddvd_timeline_segment *seg;
+	int64_t base = 0;
+	int flushed = !tl->open;
+
+	if (tl->started) {	// continue the time behind the last segment
+		seg = SEG(tl, tl->write);
+		base = seg->base + (int64_t)(seg->end - seg->start);
+		tl->write++;
+	}
+	seg = SEG(tl, tl->write);
+	seg->start = start;
+	seg->end = end;
+	seg->base = base;
+	tl->open = 1;
+	tl->started = 1;
+
+	if (flushed)	// nothing older is left in the decoder
+		tl->play = tl->write;
+	else if (tl->write - tl->play >= DDVD_TIMELINE_SEGMENTS)
+		tl->play = tl->write - DDVD_TIMELINE_SEGMENTS + 1;
+	Debug(3, "timeline: segment %u pts %llu-%llu at %lld, decoder in %u\n", tl->write, start, end, (long long)base, tl->play);
+}
+
+void ddvd_timeline_nav(struct ddvd_timeline *tl, unsigned long long start, unsigned long long end)
+{
+	struct ddvd_timeline_segment *seg = SEG(tl, tl->write);
+
+	if (end < start)
+		end = start;
+	if (!tl->open || start + DDVD_TIMELINE_SLACK < seg->end || start > seg->end + DDVD_TIMELINE_SLACK)
+		timeline_segment(tl, start, end);
+	else if (end > seg->end)
+		seg->end = end;
+}
+
+int64_t ddvd_timeline_time(struct ddvd_timeline *tl, unsigned long long pts)
+{
+	struct ddvd_timeline_segment *seg;
+
+	if (!tl->open)	// no nav packet yet
+		timeline_segment(tl, pts, pts);
+	seg = SEG(tl, tl->write);
+	return seg->base + (int64_t)(pts - seg->start);
+}
+
+int64_t ddvd_timeline_stream(struct ddvd_timeline *tl, int stream, unsigned long long pts)
+{
+	tl->stream_time[stream] = ddvd_timeline_time(tl, pts);
+	tl->stream_seg[stream] = tl->write;
+	tl->stream_pts[stream] = pts;
+	return tl->stream_time[stream];
+}
+
+static int timeline_inside(struct ddvd_timeline_segment *seg, unsigned long long pts)
+{
+	return pts + DDVD_TIMELINE_SLACK >= seg->start && pts <= seg->end + DDVD_TIMELINE_SLACK;
+}
+
+void ddvd_timeline_decoder(struct ddvd_timeline *tl, unsigned long long pts)
+{
+	int back = tl->decoder_valid && pts + DDVD_TIMELINE_SLACK < tl->decoder_pts;
+
+	if (!tl->open)
+		return;
+	// the decoder went on to the next segment when its pts left the range of the current one
+	// or went back, ranges of segments may overlap when the pts starts over
+	while (tl->play != tl->write) {
+		if (timeline_inside(SEG(tl, tl->play), pts) && !back)
+			break;
+		tl->play++;
+		back = 0;
+		Debug(4, "timeline: decoder pts %llu in segment %u\n", pts, tl->play);
+	}
+	tl->decoder_valid = 1;
+	tl->decoder_pts = pts;
+	tl->decoder_time = SEG(tl, tl->play)->base + (int64_t)(pts - SEG(tl, tl->play)->start);
+}
+
+int64_t ddvd_timeline_buffered(struct ddvd_timeline *tl)
+{
+	int64_t t;
+
+	if (!tl->decoder_valid)
+		return 0;
+	t = tl->stream_time[DDVD_TL_VIDEO] - tl->decoder_time;
+	return t > 0 ? t : 0;
+}
+
+int ddvd_timeline_due(struct ddvd_timeline *tl, int64_t time, int64_t slack)
+{
+	return tl->decoder_valid && tl->decoder_time + slack >= time;
+}
+
+int ddvd_timeline_caught_up(struct ddvd_timeline *tl, int stream)
+{
+	unsigned int seg = tl->stream_seg[stream];
+
+	if (!tl->decoder_valid || (int)(tl->play - seg) >= 0)
+		return 1;
+	// showing the last frame of the segment before
+	return tl->play + 1 == seg && tl->decoder_pts + DDVD_TIMELINE_SLACK >= SEG(tl, tl->play)->end;
+}
@@ -0,0 +1,94 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __TIMELINE_H__
+#define __TIMELINE_H__
+
+#include <stdint.h>
+
+/*
+ * pts timeline of the streams sent to the decoder
+ *
+ * The pts of a DVD starts over at PGC and often at cell boundaries, so comparing a stream
+ * pts with the decoder pts only works inside one continuous piece. The nav packet of every
+ * VOBU gives its start and end pts, a VOBU that does not start where the previous one ended
+ * opens a new segment. Segments are laid out one after the other on a continuous time
+ * (90kHz) and every stream pts is mapped into the segment it was read in.
+ *
+ * The decoder still plays older segments while the next ones are read. Its pts is followed
+ * through the segments: it moves on when the pts leaves the range of its segment or jumps
+ * back. Subtitles and stills are due when the decoder time reaches their time.
+ */
+
+#define DDVD_TIMELINE_SEGMENTS	16
+#define DDVD_TIMELINE_SLACK		3600	// 40ms, jitter of the decoder pts
+
+enum {DDVD_TL_VIDEO, DDVD_TL_AUDIO, DDVD_TL_SPU, DDVD_TL_STREAMS};
+
+struct ddvd_timeline_segment {
+	unsigned long long start;	// stream pts at the start of the segment
+	unsigned long long end;		// end pts of its last VOBU
+	int64_t base;				// timeline time of start
+};
+
+struct ddvd_timeline {
+	struct ddvd_timeline_segment seg[DDVD_TIMELINE_SEGMENTS];
+	unsigned int write;			// segment read last, counts up (index modulo DDVD_TIMELINE_SEGMENTS)
+	unsigned int play;			// segment the decoder plays
+	int started;				// any segment yet
+	int open;					// write takes more VOBUs, 0 after a flush
+	unsigned int stream_seg[DDVD_TL_STREAMS];
+	unsigned long long stream_pts[DDVD_TL_STREAMS];
+	int64_t stream_time[DDVD_TL_STREAMS];
+	int decoder_valid;
+	unsigned long long decoder_pts;
+	int64_t decoder_time;
+};
+
+void	ddvd_timeline_init(struct ddvd_timeline *tl);
+
+// the decoder was cleared, what is read next is played next
+void	ddvd_timeline_flush(struct ddvd_timeline *tl);
+
+// start and end pts of the VOBU of a nav packet (pci vobu_s_ptm and vobu_e_ptm)
+void	ddvd_timeline_nav(struct ddvd_timeline *tl, unsigned long long start, unsigned long long end);
+
+// time of a pts read now on the timeline
+int64_t	ddvd_timeline_time(struct ddvd_timeline *tl, unsigned long long pts);
+
+// pts of a pack of the stream, returns its time on the timeline
+int64_t	ddvd_timeline_stream(struct ddvd_timeline *tl, int stream, unsigned long long pts);
+
+// current decoder pts
+void	ddvd_timeline_decoder(struct ddvd_timeline *tl, unsigned long long pts);
+
+// time of video read but not played yet, 0 when unknown
+int64_t	ddvd_timeline_buffered(struct ddvd_timeline *tl);
+
+// the decoder time reached time - slack
+int		ddvd_timeline_due(struct ddvd_timeline *tl, int64_t time, int64_t slack);
+
+// the decoder played all segments before the one of the last pts of stream
+int		ddvd_timeline_caught_up(struct ddvd_timeline *tl, int stream);
+
+#endif
@@ -0,0 +1,563 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <dvdread/ifo_read.h>
+
+#include "tmap.h"
+#include "debug.h"
+
+#define BCD(x)	(((x) >> 4) * 10 + ((x) & 0x0f))
+
+// playback time of a cell or PGC in 90 kHz
+uint64_t ddvd_tmap_dvd_time(const dvd_time_t *t)
+{
+	uint64_t ticks = (BCD(t->hour) * 3600 + BCD(t->minute) * 60 + BCD(t->second)) * 90000ULL;
+	// the upper two bits of frame_u give the frame rate, 3 = 29.97, else 25
+	return ticks + BCD(t->frame_u & 0x3f) * ((t->frame_u >> 6) == 3 ? 3003 : 3600);
+}
+
+// angle blocks are counted once, like dvdnav does
+static int tmap_cell_counted(const cell_playback_t *cell)
+{
+	return cell->block_type != BLOCK_TYPE_ANGLE_BLOCK || cell->block_mode == BLOCK_MODE_FIRST_CELL;
+}
+
+// dvdnav position of a VTS sector, -1 if it is in none of the counted cells of the PGC
+static int64_t tmap_sector_block(const pgc_t *pgc, uint32_t sector)
+{
+	uint32_t block = 0;
+	int i;
+
+	for (i = 0; i < pgc->nr_of_cells; i++) {
+		const cell_playback_t *cell = &pgc->cell_playback[i];
+		if (!tmap_cell_counted(cell))
+			continue;
+		if (sector >= cell->first_sector && sector <= cell->last_sector)
+			return block + sector - cell->first_sector;
+		block += cell->last_sector - cell->first_sector + 1;
+	}
+	return -1;
+}
+
+static int tmap_point_cmp(const void *a, const void *b)
+{
+	const struct ddvd_tmap_point *pa = a, *pb = b;
+
+	if (pa->time != pb->time)
+		return pa->time < pb->time ? -1 : 1;
+	return pa->block < pb->block ? -1 : pa->block > pb->block;
+}
+
+static struct ddvd_tmap_pgc *tmap_find_pgc(struct ddvd_tmap *tmap, int vtsn, int pgcn)
+{
+	int i;
+
+	for (i = 0; i < tmap->nr_pgcs; i++) {
+		if (tmap->pgcs[i].vtsn == vtsn && tmap->pgcs[i].pgcn == pgcn)
+			return &tmap->pgcs[i];
+	}
+	return NULL;
+}
+
+static struct ddvd_tmap_part *tmap_find_part(struct ddvd_tmap *tmap, int title, int part)
+{
+	int i;
+
+	for (i = 0; i < tmap->nr_parts; i++) {
+		if (tmap->parts[i].title == title && tmap->parts[i].part == part)
+			return &tmap->parts[i];
+	}
+	return NULL;
+}
+
+// new, empty entries at the end of the tables
+static struct ddvd_tmap_pgc *tmap_add_pgc(struct ddvd_tmap *tmap)
+{
+	struct ddvd_tmap_pgc *pgcs = realloc(tmap->pgcs, (tmap->nr_pgcs + 1) * sizeof(struct ddvd_tmap_pgc));
+
+	if (pgcs == NULL)
+		return NULL;
+	tmap->pgcs = pgcs;
+	memset(&pgcs[tmap->nr_pgcs], 0, sizeof(struct ddvd_tmap_pgc));
+	return &pgcs[tmap->nr_pgcs++];
+}
+
+static struct ddvd_tmap_part *tmap_add_part(struct ddvd_tmap *tmap)
+{
+	struct ddvd_tmap_part *parts = realloc(tmap->parts, (tmap->nr_parts + 1) * sizeof(struct ddvd_tmap_part));
+
+	if (parts == NULL)
+		return NULL;
+	tmap->parts = parts;
+	memset(&parts[tmap->nr_parts], 0, sizeof(struct ddvd_tmap_part));
+	return &parts[tmap->nr_parts++];
+}
+
+static void tmap_free(struct ddvd_tmap *tmap)
+{
+	int i;
+
+	for (i = 0; i < tmap->nr_pgcs; i++)
+		free(tmap->pgcs[i].points);
+	free(tmap->pgcs);
+	free(tmap->parts);
+	tmap->pgcs = NULL;
+	tmap->parts = NULL;
+	tmap->nr_pgcs = tmap->nr_parts = 0;
+	tmap->cur = NULL;
+	tmap->have_info = 0;
+}
+
+static int tmap_build(struct ddvd_tmap_pgc *map_pgc, const vts_tmapt_t *tmapt, const pgc_t *pgc)
+{
+	const vts_tmap_t *map = NULL;
+	struct ddvd_tmap_point *points;
+	uint64_t time = 0;
+	uint32_t block = 0;
+	int i, n = 0, pgcn = map_pgc->pgcn;
+
+	if (pgc->cell_playback == NULL || pgc->nr_of_cells == 0)
+		return -1;
+	if (tmapt != NULL && pgcn <= tmapt->nr_of_tmaps && tmapt->tmap[pgcn - 1].tmu && tmapt->tmap[pgcn - 1].map_ent != NULL)
+		map = &tmapt->tmap[pgcn - 1];
+
+	points = malloc((pgc->nr_of_cells + 1 + (map ? map->nr_of_entries : 0)) * sizeof(struct ddvd_tmap_point));
+	if (points == NULL)
+		return -1;
+
+	// start of every cell and the end of the PGC
+	for (i = 0; i < pgc->nr_of_cells; i++) {
+		const cell_playback_t *cell = &pgc->cell_playback[i];
+		if (!tmap_cell_counted(cell))
+			continue;
+		points[n].time = time;
+		points[n++].block = block;
+		time += ddvd_tmap_dvd_time(&cell->playback_time);
+		block += cell->last_sector - cell->first_sector + 1;
+	}
+	points[n].time = time;
+	points[n++].block = block;
+
+	// entry i of the time map is the VOBU playing at (i + 1) * tmu seconds
+	if (map != NULL) {
+		for (i = 0; i < map->nr_of_entries; i++) {
+			uint64_t t = (uint64_t)(i + 1) * map->tmu * 90000;
+			int64_t b = tmap_sector_block(pgc, map->map_ent[i] & 0x7fffffff);	// bit 31 marks a discontinuity
+			if (t >= time || b < 0)
+				continue;
+			points[n].time = t;
+			points[n++].block = b;
+		}
+	}
+
+	// both time and block have to go up, drop what the interleaving or a broken map puts out of order
+	qsort(points, n, sizeof(struct ddvd_tmap_point), tmap_point_cmp);
+	int m = 1;
+	for (i = 1; i < n; i++) {
+		if (points[i].time > points[m - 1].time && points[i].block > points[m - 1].block)
+			points[m++] = points[i];
+	}
+	if (m < 2) {	// no playback time
+		free(points);
+		return -1;
+	}
+
+	map_pgc->points = points;
+	map_pgc->nr_points = m;
+	map_pgc->length = time;
+	map_pgc->blocks = block;
+	Debug(2, "time map of vts %d pgc %d: %d points (%d from the tmap), %u blocks, %llu s\n", map_pgc->vtsn, pgcn, m,
+		map ? map->nr_of_entries : 0, block, (unsigned long long)(time / 90000));
+	return 0;
+}
+
+static int tmap_open_dvd(struct ddvd_tmap *tmap, const char *path)
+{
+	if (tmap->dvd == NULL) {
+		tmap->dvd = DVDOpen(path);
+		if (tmap->dvd == NULL) {
+			Debug(1, "time map: cannot open %s\n", path);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * cache file: header, the disc info if there is one, the title/part table, then every PGC with
+ * its points, all in host byte order (the file never leaves the box)
+ */
+#define TMAP_CACHE_MAGIC	"DDVDTMAP"
+#define TMAP_CACHE_VERSION	2
+#define TMAP_CACHE_MAX		4096	// PGCs or parts, more means a broken file
+
+struct tmap_cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t have_info;
+	uint32_t nr_parts;
+	uint32_t nr_pgcs;
+};
+
+struct tmap_cache_pgc {
+	int32_t vtsn, pgcn;
+	uint64_t length;
+	uint32_t blocks;
+	uint32_t nr_points;
+};
+
+// the lookups divide by the distance of two points
+static int tmap_pgc_sane(const struct ddvd_tmap_pgc *pgc)
+{
+	int i;
+
+	for (i = 1; i < pgc->nr_points; i++) {
+		if (pgc->points[i].time <= pgc->points[i - 1].time || pgc->points[i].block <= pgc->points[i - 1].block)
+			return 0;
+	}
+	return pgc->points[0].time == 0 && pgc->points[0].block == 0 &&
+		pgc->points[i - 1].time == pgc->length && pgc->points[i - 1].block == pgc->blocks;
+}
+
+static int tmap_cache_read(struct ddvd_tmap *tmap)
+{
+	struct tmap_cache_header header;
+	struct tmap_cache_pgc cpgc;
+	FILE *f;
+	uint32_t i;
+
+	f = fopen(tmap->cache_file, "rb");
+	if (f == NULL)
+		return -1;
+	if (fread(&header, sizeof(header), 1, f) != 1 || memcmp(header.magic, TMAP_CACHE_MAGIC, 8) ||
+		header.version != TMAP_CACHE_VERSION || header.nr_parts > TMAP_CACHE_MAX || header.nr_pgcs > TMAP_CACHE_MAX)
+		goto err;
+
+	if (header.have_info) {
+		if (fread(&tmap->info, sizeof(struct ddvd_disc_info), 1, f) != 1 ||
+			tmap->info.titles < 0 || tmap->info.titles > DDVD_MAX_TITLES)
+			goto err;
+		tmap->info.title_string[sizeof(tmap->info.title_string) - 1] = 0;
+		tmap->have_info = 1;
+	}
+
+	for (i = 0; i < header.nr_parts; i++) {
+		struct ddvd_tmap_part *part = tmap_add_part(tmap);
+		if (part == NULL || fread(part, sizeof(struct ddvd_tmap_part), 1, f) != 1)
+			goto err;
+	}
+	for (i = 0; i < header.nr_pgcs; i++) {
+		struct ddvd_tmap_pgc *pgc = tmap_add_pgc(tmap);
+		if (pgc == NULL || fread(&cpgc, sizeof(cpgc), 1, f) != 1 || cpgc.nr_points < 2 || cpgc.nr_points > 0x100000)
+			goto err;
+		pgc->vtsn = cpgc.vtsn;
+		pgc->pgcn = cpgc.pgcn;
+		pgc->length = cpgc.length;
+		pgc->blocks = cpgc.blocks;
+		pgc->points = malloc(cpgc.nr_points * sizeof(struct ddvd_tmap_point));
+		if (pgc->points == NULL || fread(pgc->points, sizeof(struct ddvd_tmap_point), cpgc.nr_points, f) != cpgc.nr_points)
+			goto err;
+		pgc->nr_points = cpgc.nr_points;
+		if (!tmap_pgc_sane(pgc))
+			goto err;
+	}
+	fclose(f);
+	Debug(2, "time map: %d maps of %d parts%s from %s\n", tmap->nr_pgcs, tmap->nr_parts,
+		tmap->have_info ? " and the disc info" : "", tmap->cache_file);
+	return 0;
+
+err:
+	Debug(1, "time map: ignoring broken cache %s\n", tmap->cache_file);
+	fclose(f);
+	tmap_free(tmap);
+	return -1;
+}
+
+static void tmap_cache_write(struct ddvd_tmap *tmap)
+{
+	struct tmap_cache_header header;
+	char tmp[strlen(tmap->cache_file) + 5];
+	FILE *f;
+	int i, ok;
+
+	// written next to the cache and renamed, a crash or a second player never leaves half a file
+	sprintf(tmp, "%s.tmp", tmap->cache_file);
+	f = fopen(tmp, "wb");
+	if (f == NULL) {
+		Perror(tmp);
+		return;
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TMAP_CACHE_MAGIC, 8);
+	header.version = TMAP_CACHE_VERSION;
+	header.have_info = tmap->have_info;
+	header.nr_parts = tmap->nr_parts;
+	header.nr_pgcs = tmap->nr_pgcs;
+	ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+		(!tmap->have_info || fwrite(&tmap->info, sizeof(struct ddvd_disc_info), 1, f) == 1) &&
+		(!tmap->nr_parts || fwrite(tmap->parts, sizeof(struct ddvd_tmap_part), tmap->nr_parts, f) == (size_t)tmap->nr_parts);
+	for (i = 0; ok && i < tmap->nr_pgcs; i++) {
+		struct ddvd_tmap_pgc *pgc = &tmap->pgcs[i];
+		struct tmap_cache_pgc cpgc = { pgc->vtsn, pgc->pgcn, pgc->length, pgc->blocks, pgc->nr_points };
+		ok = fwrite(&cpgc, sizeof(cpgc), 1, f) == 1 &&
+			fwrite(pgc->points, sizeof(struct ddvd_tmap_point), pgc->nr_points, f) == (size_t)pgc->nr_points;
+	}
+	if (fclose(f) != 0)
+		ok = 0;
+	if (!ok || rename(tmp, tmap->cache_file) < 0) {
+		Perror(tmap->cache_file);
+		unlink(tmp);
+		return;
+	}
+	Debug(2, "time map: %d maps of %d parts to %s\n", tmap->nr_pgcs, tmap->nr_parts, tmap->cache_file);
+}
+
+static uint64_t tmap_hash(uint64_t hash, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	while (len--)	// FNV-1a
+		hash = (hash ^ *p++) * 0x100000001b3ULL;
+	return hash;
+}
+
+// key of the cache file: the UDF volume ids and VIDEO_TS.IFO, which dvdnav has just read. DVDDiscID
+// would read the first nine VTS IFO files as well, on a slow drive that is what the cache is to save
+static int tmap_disc_key(dvd_reader_t *dvd, uint64_t *key)
+{
+	char volid[32];
+	unsigned char volsetid[128];
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	dvd_file_t *file;
+	ssize_t size;
+
+	memset(volid, 0, sizeof(volid));
+	memset(volsetid, 0, sizeof(volsetid));
+	if (DVDUDFVolumeInfo(dvd, volid, sizeof(volid), volsetid, sizeof(volsetid)) == 0) {
+		hash = tmap_hash(hash, volid, sizeof(volid));
+		hash = tmap_hash(hash, volsetid, sizeof(volsetid));
+	}
+
+	file = DVDOpenFile(dvd, 0, DVD_READ_INFO_FILE);
+	if (file == NULL)
+		return -1;
+	size = DVDFileSize(file) * DVD_VIDEO_LB_LEN;
+	uint8_t *ifo = size > 0 && size <= 0x100000 ? malloc(size) : NULL;
+	if (ifo == NULL || DVDReadBytes(file, ifo, size) != size) {
+		free(ifo);
+		DVDCloseFile(file);
+		return -1;
+	}
+	hash = tmap_hash(hash, ifo, size);
+	free(ifo);
+	DVDCloseFile(file);
+
+	*key = hash;
+	return 0;
+}
+
+int ddvd_tmap_open(struct ddvd_tmap *tmap, const char *path, const char *cache_dir)
+{
+	uint64_t key;
+
+	memset(tmap, 0, sizeof(struct ddvd_tmap));
+	if (cache_dir == NULL)
+		return 0;
+	if (tmap_open_dvd(tmap, path) < 0 || tmap_disc_key(tmap->dvd, &key) < 0) {
+		Debug(1, "time map: no disc id for %s, not cached\n", path);
+		return -1;
+	}
+	tmap->cache_file = malloc(strlen(cache_dir) + 2 + 16 + 5 + 1);
+	if (tmap->cache_file == NULL)
+		return -1;
+	sprintf(tmap->cache_file, "%s/%016llx.tmap", cache_dir, (unsigned long long)key);
+	return tmap_cache_read(tmap);
+}
+
+void ddvd_tmap_close(struct ddvd_tmap *tmap)
+{
+	if (tmap->cache_file != NULL && tmap->dirty)
+		tmap_cache_write(tmap);
+	free(tmap->cache_file);
+	tmap_free(tmap);
+	if (tmap->vts != NULL)
+		ifoClose(tmap->vts);
+	if (tmap->vmg != NULL)
+		ifoClose(tmap->vmg);
+	if (tmap->dvd != NULL)
+		DVDClose(tmap->dvd);
+	memset(tmap, 0, sizeof(struct ddvd_tmap));
+}
+
+ifo_handle_t *ddvd_tmap_ifo(struct ddvd_tmap *tmap, const char *path, int vtsn)
+{
+	if (tmap_open_dvd(tmap, path) < 0)
+		return NULL;
+	if (vtsn == 0) {
+		if (tmap->vmg == NULL) {
+			tmap->vmg = ifoOpen(tmap->dvd, 0);
+			if (tmap->vmg == NULL)
+				Debug(1, "time map: cannot read VIDEO_TS.IFO\n");
+		}
+		return tmap->vmg;
+	}
+	if (vtsn != tmap->vtsn) {
+		if (tmap->vts != NULL)
+			ifoClose(tmap->vts);
+		tmap->vts = ifoOpen(tmap->dvd, vtsn);
+		tmap->vtsn = tmap->vts ? vtsn : 0;
+		if (tmap->vts == NULL)
+			Debug(1, "time map: cannot read VTS_%02d_0.IFO\n", vtsn);
+	}
+	return tmap->vts;
+}
+
+// look up the PGC of title/part in the IFO files
+static int tmap_read_part(struct ddvd_tmap *tmap, const char *path, int title, int part, struct ddvd_tmap_part *p)
+{
+	const ifo_handle_t *vmg = ddvd_tmap_ifo(tmap, path, 0);
+	if (vmg == NULL || vmg->tt_srpt == NULL || title < 1 || title > vmg->tt_srpt->nr_of_srpts)
+		return -1;
+	int vtsn = vmg->tt_srpt->title[title - 1].title_set_nr;
+	int ttn = vmg->tt_srpt->title[title - 1].vts_ttn;
+	if (vtsn < 1 || ddvd_tmap_ifo(tmap, path, vtsn) == NULL)
+		return -1;
+
+	const vts_ptt_srpt_t *ptt_srpt = tmap->vts->vts_ptt_srpt;
+	if (ptt_srpt == NULL || ttn < 1 || ttn > ptt_srpt->nr_of_srpts || part < 1 || part > ptt_srpt->title[ttn - 1].nr_of_ptts)
+		return -1;
+
+	p->title = title;
+	p->part = part;
+	p->vtsn = vtsn;
+	p->pgcn = ptt_srpt->title[ttn - 1].ptt[part - 1].pgcn;
+	return 0;
+}
+
+// read the map of a PGC of the title set tmap_read_part has just opened
+static struct ddvd_tmap_pgc *tmap_read_pgc(struct ddvd_tmap *tmap, const struct ddvd_tmap_part *p)
+{
+	struct ddvd_tmap_pgc *pgc;
+
+	const pgcit_t *pgcit = tmap->vts->vts_pgcit;
+	if (pgcit == NULL || p->pgcn < 1 || p->pgcn > pgcit->nr_of_pgci_srp || pgcit->pgci_srp[p->pgcn - 1].pgc == NULL)
+		return NULL;
+
+	pgc = tmap_add_pgc(tmap);
+	if (pgc == NULL)
+		return NULL;
+	pgc->vtsn = p->vtsn;
+	pgc->pgcn = p->pgcn;
+	if (tmap_build(pgc, tmap->vts->vts_tmapt, pgcit->pgci_srp[p->pgcn - 1].pgc) < 0) {
+		tmap->nr_pgcs--;
+		return NULL;
+	}
+	return pgc;
+}
+
+int ddvd_tmap_load(struct ddvd_tmap *tmap, const char *path, int title, int part)
+{
+	struct ddvd_tmap_part *p = tmap_find_part(tmap, title, part);
+	struct ddvd_tmap_part found;
+
+	tmap->cur = p ? tmap_find_pgc(tmap, p->vtsn, p->pgcn) : NULL;
+	if (tmap->cur != NULL)
+		return 0;
+
+	if (tmap_read_part(tmap, path, title, part, &found) < 0)
+		return -1;
+	tmap->cur = tmap_find_pgc(tmap, found.vtsn, found.pgcn);	// the parts of a title often share one PGC
+	if (tmap->cur == NULL)
+		tmap->cur = tmap_read_pgc(tmap, &found);
+	if (tmap->cur == NULL)
+		return -1;
+	if (p == NULL)
+		p = tmap_add_part(tmap);
+	if (p != NULL)
+		*p = found;
+	tmap->dirty = 1;
+	return 0;
+}
+
+const struct ddvd_disc_info *ddvd_tmap_info(const struct ddvd_tmap *tmap)
+{
+	return tmap->have_info ? &tmap->info : NULL;
+}
+
+void ddvd_tmap_set_info(struct ddvd_tmap *tmap, const struct ddvd_disc_info *info)
+{
+	memcpy(&tmap->info, info, sizeof(struct ddvd_disc_info));
+	tmap->have_info = 1;
+	tmap->dirty = 1;
+}
+
+int ddvd_tmap_valid(const struct ddvd_tmap *tmap, uint32_t len)
+{
+	return tmap->cur != NULL && tmap->cur->blocks == len;
+}
+
+// last point at or before key, by time or by block
+static int tmap_find(const struct ddvd_tmap_pgc *pgc, uint64_t key, int by_block)
+{
+	int lo = 0, hi = pgc->nr_points - 1;
+
+	while (hi - lo > 1) {
+		int mid = (lo + hi) / 2;
+		if ((by_block ? pgc->points[mid].block : pgc->points[mid].time) <= key)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+uint32_t ddvd_tmap_block(const struct ddvd_tmap *tmap, uint64_t time)
+{
+	const struct ddvd_tmap_pgc *pgc = tmap->cur;
+
+	if (pgc == NULL)
+		return 0;
+	if (time >= pgc->length)
+		return pgc->blocks;
+
+	const struct ddvd_tmap_point *a = &pgc->points[tmap_find(pgc, time, 0)];
+	return a->block + (time - a->time) * (a[1].block - a->block) / (a[1].time - a->time);
+}
+
+uint64_t ddvd_tmap_time(const struct ddvd_tmap *tmap, uint32_t block)
+{
+	const struct ddvd_tmap_pgc *pgc = tmap->cur;
+
+	if (pgc == NULL)
+		return 0;
+	if (block >= pgc->blocks)
+		return pgc->length;
+
+	const struct ddvd_tmap_point *a = &pgc->points[tmap_find(pgc, block, 1)];
+	return a->time + (uint64_t)(block - a->block) * (a[1].time - a->time) / (a[1].block - a->block);
+}
@@ -0,0 +1,113 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __TMAP_H__
+#define __TMAP_H__
+
+#include <stdint.h>
+
+#include <dvdread/dvd_reader.h>
+#include <dvdread/ifo_types.h>
+
+#include "ddvdlib.h"
+
+/*
+ * time map of the playing program chain, title time (90 kHz) to dvdnav block and back
+ *
+ * The points are taken from the time map table of the title set (VTS_TMAPT, one VOBU start
+ * sector every tmu seconds) and from the cell playback times. The VOBU sectors are
+ * translated to the block positions dvdnav_get_position and dvdnav_sector_search use with
+ * PGC based positioning: the cells of the PGC one after the other, only the first cell of an
+ * angle block counted. Between two points the position is interpolated, so a seek lands at
+ * most one time unit off instead of spreading the error over the whole title. Titles
+ * without a time map only have the cell points.
+ *
+ * The IFO files are read with their own dvdread handle, the VMG once per disc and a VTS when
+ * the title set changes. Every map read stays in memory until the disc is closed, together
+ * with the PGC each title/part plays and the title table of ddvd_probe. With a cache
+ * directory they are also kept in a file per disc and read back on the next open, so playing
+ * or probing the disc again needs no IFO parsing for them at all. The file is named after a
+ * hash of the UDF volume ids and VIDEO_TS.IFO, which dvdnav reads on open anyway.
+ */
+
+struct ddvd_tmap_point {
+	uint64_t time;					// 90 kHz from the start of the PGC
+	uint32_t block;					// dvdnav position
+};
+
+struct ddvd_tmap_pgc {
+	int vtsn, pgcn;
+	uint64_t length;				// playback time of the PGC
+	uint32_t blocks;				// dvdnav length of the PGC
+	int nr_points;
+	struct ddvd_tmap_point *points;	// by time, the last one is the end of the PGC
+};
+
+struct ddvd_tmap_part {
+	int title, part;
+	int vtsn, pgcn;					// the PGC it plays
+};
+
+struct ddvd_tmap {
+	dvd_reader_t *dvd;
+	ifo_handle_t *vmg;
+	ifo_handle_t *vts;
+	int vtsn;						// title set of vts
+	struct ddvd_tmap_pgc *pgcs;		// every map read from this disc
+	int nr_pgcs;
+	struct ddvd_tmap_part *parts;
+	int nr_parts;
+	struct ddvd_tmap_pgc *cur;		// the playing PGC, NULL without a map
+	struct ddvd_disc_info info;		// titles, chapters and streams of the disc
+	int have_info;					// info was read or taken from the cache
+	char *cache_file;				// NULL without a cache
+	int dirty;						// maps were added since the cache file was read
+};
+
+// open the disc, read the maps of an earlier run from cache_dir (may be NULL)
+int			ddvd_tmap_open(struct ddvd_tmap *tmap, const char *path, const char *cache_dir);
+// write new maps to the cache and free everything
+void		ddvd_tmap_close(struct ddvd_tmap *tmap);
+
+// make the map of the PGC playing part of title the current one, reads it when it is new
+int			ddvd_tmap_load(struct ddvd_tmap *tmap, const char *path, int title, int part);
+
+// the title table of the disc if it came from the cache or was stored before, else NULL
+const struct ddvd_disc_info *ddvd_tmap_info(const struct ddvd_tmap *tmap);
+// keep the title table for the cache
+void		ddvd_tmap_set_info(struct ddvd_tmap *tmap, const struct ddvd_disc_info *info);
+
+// the current map is for a PGC of len blocks (as dvdnav_get_position tells)
+int			ddvd_tmap_valid(const struct ddvd_tmap *tmap, uint32_t len);
+
+// the VMG (vtsn 0) or a VTS IFO of the disc, read through the handle of the map, NULL on errors.
+// A VTS stays valid until another one is asked for
+ifo_handle_t *ddvd_tmap_ifo(struct ddvd_tmap *tmap, const char *path, int vtsn);
+
+// a cell or PGC playback time of the IFO in 90 kHz
+uint64_t	ddvd_tmap_dvd_time(const dvd_time_t *t);
+
+uint32_t	ddvd_tmap_block(const struct ddvd_tmap *tmap, uint64_t time);
+uint64_t	ddvd_tmap_time(const struct ddvd_tmap *tmap, uint32_t block);
+
+#endif
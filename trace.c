@@ -0,0 +1,88 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+#define DDVD_TRACE_FMT(id, fmt) fmt,
+static const char *trace_fmt[TRACE_MAX] = {
+	DDVD_TRACE_EVENTS(DDVD_TRACE_FMT)
+};
+#undef DDVD_TRACE_FMT
+
+// shared by all players like the Debug() output
+static struct ddvd_trace_event trace_ring[DDVD_TRACE_SIZE];
+static uint32_t trace_head;
+
+void ddvd_trace_add(int level, int id, long long a0, long long a1, long long a2, long long a3, long long a4, long long a5, long long a6)
+{
+	uint32_t n = __atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED);
+	struct ddvd_trace_event *ev = &trace_ring[n & (DDVD_TRACE_SIZE - 1)];
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	__atomic_store_n(&ev->seq, 0, __ATOMIC_RELAXED);	// invalid while it is written
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	ev->time = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	ev->id = id;
+	ev->level = level;
+	ev->arg[0] = a0;
+	ev->arg[1] = a1;
+	ev->arg[2] = a2;
+	ev->arg[3] = a3;
+	ev->arg[4] = a4;
+	ev->arg[5] = a5;
+	ev->arg[6] = a6;
+	__atomic_store_n(&ev->seq, n + 1, __ATOMIC_RELEASE);
+}
+
+void ddvd_trace_dump(int fd)
+{
+	uint32_t head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+	uint32_t n = head > DDVD_TRACE_SIZE ? head - DDVD_TRACE_SIZE : 0;
+	FILE *f;
+
+	f = fdopen(dup(fd), "w");
+	if (f == NULL)
+		return;
+
+	for (; n != head; n++) {
+		struct ddvd_trace_event *slot = &trace_ring[n & (DDVD_TRACE_SIZE - 1)];
+		struct ddvd_trace_event ev;
+
+		if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != n + 1)
+			continue;	// being written or already overwritten by a newer event
+		ev = *slot;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != n + 1 || ev.id >= TRACE_MAX)
+			continue;
+
+		fprintf(f, "LIBDVD: %llu.%06llu: ", (unsigned long long)(ev.time / 1000000000), (unsigned long long)(ev.time % 1000000000 / 1000));
+		fprintf(f, trace_fmt[ev.id], ev.arg[0], ev.arg[1], ev.arg[2], ev.arg[3], ev.arg[4], ev.arg[5], ev.arg[6]);
+		fputc('\n', f);
+	}
+	fclose(f);
+}
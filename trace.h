@@ -0,0 +1,111 @@
+/*
+ * vim: ts=4
+ *
+ * DreamDVD V0.9 - DVD-Player for Dreambox
+ * Copyright (C) 2007 by Seddi
+ *
+ * DreamDVD is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * DreamDVD is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
+ *
+ * part of libdreamdvd
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdint.h>
+
+#include "debug.h"
+#include "ddvdlib.h"
+
+/*
+ * binary event trace for the player loop
+ *
+ * Debug() formats and prints right away, which changes the timing of the player enough to
+ * hide the bugs one is looking for. Trace() only stores a timestamp, the event id and up to
+ * DDVD_TRACE_ARGS integers in a ring of the last DDVD_TRACE_SIZE events, the text is made
+ * when the ring is dumped. Recording follows the LIBDVD_DEBUG level like Debug(), events of
+ * DDVD_TRACE_MAX_LEVEL and up are not compiled in at all.
+ */
+
+#ifndef DDVD_TRACE_MAX_LEVEL
+#define DDVD_TRACE_MAX_LEVEL	5
+#endif
+
+#define DDVD_TRACE_SIZE		8192	// events, power of 2
+#define DDVD_TRACE_ARGS		7
+
+// event id and format, all arguments are printed as long long
+#define DDVD_TRACE_EVENTS(X) \
+	X(TRACE_OSD_TIME,			"OSD_TIME vpts=%llu pts=%llu iframesend=%lld") \
+	X(TRACE_SPU_FINISHED,		"    set clear SPU backbuffer, SPU finished") \
+	X(TRACE_SPU_BLOCK,			"DVD SPU BLOCK: spu_nr=%lld/%lld vpts=%llu pts=%llu highlight=%lld") \
+	X(TRACE_SPU_PTS,			"                                                                 SPTS=%llu  %3lld:  %lld:%02lld:%02lld.%05lld") \
+	X(TRACE_STILL_FRAME,		"DVDNAV_STILL_FRAME: lenght=%lld vpts=%llu pts=%llu") \
+	X(TRACE_NAV_WAIT,			"DVDNAV_WAIT: decoder done, vpts=%llu pts=%llu") \
+	X(TRACE_SPU_CLUT_CHANGE,	"DVDNAV_SPU_CLUT_CHANGE vpts=%llu pts=%llu highlight=%lld") \
+	X(TRACE_SPU_STREAM_CHANGE,	"DVDNAV_SPU_STREAM_CHANGE vpts=%llu pts=%llu highlight=%lld spu_lock=%lld") \
+	X(TRACE_SPU_CLEAR,			"   clr spu frame spu_nr=%lld->%lld") \
+	X(TRACE_HIGHLIGHT,			"DVDNAV_HIGHLIGHT vpts=%llu pts=%llu highlight=%lld button=%lld mode=%lld, bpts=%llu same_as_previous=%lld") \
+	X(TRACE_VTS_CHANGE,			"DVDNAV_VTS_CHANGE vpts=%llu pts=%llu highlight=%lld") \
+	X(TRACE_CELL_CHANGE,		"DVDNAV_CELL_CHANGE vpts=%llu pts=%llu highlight=%lld") \
+	X(TRACE_STILL_ACTIVATE,		"DVDNAV_STILL_FRAME: activate: length=%lld vpts=%llu pts=%llu") \
+	X(TRACE_SPU_DECODED,		"SPU current=%lld pts=%llu spupts=%llu displaytime=%lld type=%lld btns=%lld highlight=%lld") \
+	X(TRACE_SPU_BBOX,			"    bbox: %lldx%lld %lldx%lld") \
+	X(TRACE_FORCE_HIGHLIGHT,	"FORCE highlight button %lld") \
+	X(TRACE_UPDATE_HIGHLIGHT,	"Update highlight buttons - %lld of %lld, switching to menu") \
+	X(TRACE_SPU_NEW,			"clear p_lfb, physical screen, new SPU, vpts=%llu pts=%llu spts=%llu highlight=%lld spu_timer_active=%lld lastsputime=%lld") \
+	X(TRACE_SPU_SKIP,			"do not display this spu: active stream=%lld spulock=%lld") \
+	X(TRACE_SPU_DRAW,			"    drawing subtitle, vpts=%llu pts=%llu highlight=%lld") \
+	X(TRACE_HIGHLIGHT_DRAW,		"HIGHLIGHT DRAW Selected button=%lld mode=%lld, bpts=%llu vpts=%llu pts=%llu") \
+	X(TRACE_BUTTON_GROUP,		"DOBUTTON %lld data from buttongroup") \
+	X(TRACE_BUTTON_BTNI,		"DOBUTTON btni") \
+	X(TRACE_BUTTON_CLEAR,		"        clear lbb2, backbuffer, new button to come") \
+	X(TRACE_BUTTON_BBOX,		"BUT new bbox: %lldx%lld %lldx%lld") \
+	X(TRACE_BUTTON_NONE,		"DOBUTTON no info - no drawing!") \
+	X(TRACE_DRAW_CLEAR,			"DODRAW DRAW clear screen area: %lldx%lld %lldx%lld") \
+	X(TRACE_DRAW,				"DODRAW DRAW button/subtitle at: %lldx%lld %lldx%lld") \
+	X(TRACE_RESIZED,			"resized to: %lldx%lld %lldx%lld") \
+	X(TRACE_DRAW_FILL,			"fill p_lfb from lbb2, backbuffer with new button/subtitle") \
+	X(TRACE_MENU_OPENED,		"MENU_OPENED vpts=%llu, pts=%llu highlight=%lld!!!") \
+	X(TRACE_MENU_CLOSED,		"MENU_CLOSED vpts=%llu, pts=%llu highlight=%lld!!!") \
+	X(TRACE_WAIT_KEY,			"Waiting for keypress - paused=%lld, vpts=%llu pts=%llu menu=%lld playermenu=%lld")
+
+#define DDVD_TRACE_ID(id, fmt) id,
+enum {
+	DDVD_TRACE_EVENTS(DDVD_TRACE_ID)
+	TRACE_MAX,
+};
+#undef DDVD_TRACE_ID
+
+struct ddvd_trace_event {
+	uint64_t time;					// CLOCK_MONOTONIC in ns
+	uint32_t seq;					// number of the event + 1, written last
+	uint16_t id;
+	uint16_t level;
+	long long arg[DDVD_TRACE_ARGS];
+};
+
+void ddvd_trace_add(int level, int id, long long a0, long long a1, long long a2, long long a3, long long a4, long long a5, long long a6);
+
+// unused arguments are 0, the extra dummy makes an event without arguments work
+#define TRACE_ARGS(dummy, a0, a1, a2, a3, a4, a5, a6, ...) \
+	(long long)(a0), (long long)(a1), (long long)(a2), (long long)(a3), (long long)(a4), (long long)(a5), (long long)(a6)
+
+#define Trace(level, id, ...) do { \
+		if ((level) < DDVD_TRACE_MAX_LEVEL && DebugLevel > (level)) \
+			ddvd_trace_add(level, id, TRACE_ARGS(0, ##__VA_ARGS__, 0, 0, 0, 0, 0, 0, 0)); \
+	} while (0)
+
+#endif